@@ -0,0 +1,713 @@
+/*
+ * $Id$
+ * bench.c
+ *
+ * Benchmarks for coopt; build and run with 'make benchmark', which also
+ * reports the size of the library. Built twice: once against libcoopt.a,
+ * and once with coopt_single.h.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#ifdef COOPT_BENCH_SINGLE
+#define COOPT_IMPLEMENTATION
+#include "coopt_single.h"
+#else
+#include "coopt.h"
+#endif
+
+/*
+ * Each benchmark does one unit of work (a whole command line, say) per
+ * call; we run it until enough time has passed to measure. Those with a
+ * setup function are run at several sizes of input, to show how their
+ * time grows; the adversarial ones should stay flat (or fall) per byte.
+ */
+struct bench
+{
+  char const *name;
+  void (*setup)(size_t);
+  void (*run)(void);
+};
+
+static void bench_startup(void);
+static void bench_tokenise(void);
+static void bench_cached(void);
+static void bench_table_acquire(void);
+static void bench_table_swap(void);
+static void bench_table_startup(void);
+static void bench_fingerprint(void);
+static void bench_traced(void);
+static void bench_forward_sopt(void);
+static void bench_forward_emit(void);
+static void setup_long_eq(size_t);
+static void bench_long_eq(void);
+static void setup_abbrev(size_t);
+static void bench_abbrev(void);
+static void setup_short_run(size_t);
+static void bench_short_run(void);
+static void bench_short_run_limited(void);
+static void bench_short_run_diagnosed(void);
+static void setup_flag_run(size_t);
+static void bench_flag_run(void);
+static void bench_flag_run_cluster(void);
+static void setup_long_element(size_t);
+static void setup_inputs(size_t);
+static void setup_foreign(size_t);
+static void bench_foreign(void);
+static void bench_foreign_passthrough(void);
+static void bench_inputs(void);
+static void bench_inputs_scopes(void);
+static void setup_edited(size_t);
+static void bench_edited(void);
+static void bench_long_element_limited(void);
+
+static struct bench const benches[] =
+{
+  { "startup: init and parse a typical command line", NULL, bench_startup },
+  { "startup: tokenise, init and parse", NULL, bench_tokenise },
+  { "startup: init and parse from a warm cache", NULL, bench_cached },
+  { "startup: acquire a table, init and parse", NULL, bench_table_startup },
+  { "startup: init and fingerprint", NULL, bench_fingerprint },
+  { "startup: init and parse, traced", NULL, bench_traced },
+  { "forward: parse, rebuild argv with coopt_sopt()", NULL,
+    bench_forward_sopt },
+  { "forward: parse, rebuild argv with coopt_emit()", NULL,
+    bench_forward_emit },
+  { "reload: acquire and release the current table", NULL,
+    bench_table_acquire },
+  { "reload: swap tables, and retire the old one", NULL, bench_table_swap },
+  { "adversarial: 32 character long_eq", setup_long_eq, bench_long_eq },
+  { "adversarial: ambiguous abbreviations (indexed)", setup_abbrev,
+    bench_abbrev },
+  { "adversarial: unknown short options", setup_short_run,
+    bench_short_run },
+  { "adversarial: unknown short options, max_results", setup_short_run,
+    bench_short_run_limited },
+  { "adversarial: unknown short options, diagnosed", setup_short_run,
+    bench_short_run_diagnosed },
+  { "flags: run of flags, coopt()", setup_flag_run, bench_flag_run },
+  { "flags: run of flags, coopt_cluster()", setup_flag_run,
+    bench_flag_run_cluster },
+  { "adversarial: long element, max_length", setup_long_element,
+    bench_long_element_limited },
+  { "inputs: options for each input, coopt()", setup_inputs, bench_inputs },
+  { "inputs: options for each input, coopt_scopes()", setup_inputs,
+    bench_inputs_scopes },
+  { "inputs: change one in the middle, coopt_reparse()", setup_edited,
+    bench_edited },
+  { "wrapper: foreign options, coopt()", setup_foreign, bench_foreign },
+  { "wrapper: foreign options, coopt_passthrough()", setup_foreign,
+    bench_foreign_passthrough },
+};
+
+#define NUM_BENCHES (sizeof(benches)/sizeof(benches[0]))
+#define MIN_TIME (CLOCKS_PER_SEC/4)
+
+/* Sizes of input for the adversarial benchmarks */
+static size_t const sizes[] = { 1000, 10000, 100000 };
+#define NUM_SIZES (sizeof(sizes)/sizeof(sizes[0]))
+#define MAX_SIZE 100000
+static struct coopt_option const options[] =
+{
+  { 'v', COOPT_NO_PARAM, "verbose", 0, COOPT_UNORDERED },
+  { 'q', COOPT_NO_PARAM, "quiet", 0, COOPT_UNORDERED },
+  { 'f', COOPT_REQUIRED_PARAM, "file", 0, 0 },
+  { 'o', COOPT_REQUIRED_PARAM, "output", 0, 0 },
+  { 'n', COOPT_NO_PARAM, "dry-run", 0, COOPT_UNORDERED },
+  { 'j', COOPT_REQUIRED_PARAM, "jobs", 0, COOPT_UNORDERED },
+  { 'C', COOPT_REQUIRED_PARAM, "directory", 0, 0 },
+  { 'k', COOPT_NO_PARAM, "keep-going", 0, COOPT_UNORDERED },
+  { 0, COOPT_NO_PARAM, "version", 0, 0 },
+  { 0, COOPT_NO_PARAM, "help", 0, 0 },
+};
+
+#define NUM_OPTIONS (sizeof(options)/sizeof(options[0]))
+
+static char const line[] =
+  "-v --file input.txt -j4 --directory=/srv/app -kn --output out.log a b";
+
+static char const * const line_argv[] =
+{
+  "-v", "--file", "input.txt", "-j4", "--directory=/srv/app", "-kn",
+  "--output", "out.log", "a", "b"
+};
+
+#define LINE_ARGC (sizeof(line_argv)/sizeof(line_argv[0]))
+
+/* Somewhere to put results, so they can't be optimised away */
+static volatile unsigned long sink;
+
+static void bench_parse(int argc, char const * const *argv)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, options, NUM_OPTIONS, argc, argv);
+  do
+  {
+    ret = coopt(&state);
+    sink += (unsigned long)ret.opt;
+  }
+  while (coopt_is_okay(ret.result));
+}
+
+static void bench_startup(void)
+{
+  bench_parse(LINE_ARGC, line_argv);
+}
+
+static void bench_tokenise(void)
+{
+  char copy[sizeof(line)];
+  char const *argv[16];
+  int argc;
+
+  memcpy(copy, line, sizeof(line));
+  argc = coopt_tokenise(copy, argv, 16);
+  bench_parse(argc, argv);
+}
+
+/* Only the first call misses */
+static void bench_cached(void)
+{
+  static struct coopt_cache cache;
+  static double space[COOPT_CACHE_SIZE(1, 1024)/sizeof(double) + 1];
+  static int ready;
+  struct coopt_state state;
+  struct coopt_return results[16];
+  int i, n;
+
+  if (!ready)
+  {
+    coopt_cache_init(&cache, options, NUM_OPTIONS, 1, 1024, space);
+    ready = 1;
+  }
+  coopt_init(&state, options, NUM_OPTIONS, LINE_ARGC, line_argv);
+  n = coopt_cache_run(&cache, &state, results, 16);
+  for (i=0; i<n && i<16; i++)
+    sink += (unsigned long)results[i].opt;
+}
+
+static void bench_fingerprint(void)
+{
+  struct coopt_state state;
+  struct coopt_fingerprint fingerprint;
+
+  coopt_init(&state, options, NUM_OPTIONS, LINE_ARGC, line_argv);
+  coopt_fingerprint(&state, &fingerprint);
+  sink += fingerprint.hash[0];
+}
+
+/* The ring is never reset, so it wraps, as it would in a long run */
+static void bench_traced(void)
+{
+  static struct coopt_trace trace;
+  static struct coopt_trace_event events[256];
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  if (trace.events==NULL)
+    coopt_trace_init(&trace, events, 256);
+  coopt_init(&state, options, NUM_OPTIONS, LINE_ARGC, line_argv);
+  coopt_trace(&state, &trace);
+  do
+  {
+    ret = coopt(&state);
+    sink += (unsigned long)ret.opt;
+  }
+  while (coopt_is_okay(ret.result));
+}
+
+/*
+ * Passing a command line on: by hand, copying each option as coopt_sopt()
+ * gives it and then its parameter, or with an emitter.
+ */
+static void bench_forward_sopt(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  char arena[256];
+  char const *argv[32];
+  size_t used = 0;
+  int argc = 0;
+
+  coopt_init(&state, options, NUM_OPTIONS, LINE_ARGC, line_argv);
+  while (coopt_is_okay((ret = coopt(&state)).result))
+  {
+    if (ret.opt==NULL)
+    {
+      argv[argc++] = ret.param;
+      continue;
+    }
+    argv[argc++] = arena+used;
+    used += coopt_sopt(arena+used, sizeof(arena)-used, &ret, 1, &state)+1;
+    if (ret.param!=NULL)
+    {
+      size_t len = strlen(ret.param)+1;
+      memcpy(arena+used, ret.param, len);
+      argv[argc++] = arena+used;
+      used += len;
+    }
+  }
+  argv[argc] = NULL;
+  sink += argc + used + (unsigned long)argv[argc-1];
+}
+
+static void bench_forward_emit(void)
+{
+  struct coopt_state state;
+  struct coopt_emitter emitter;
+  struct coopt_return ret;
+  char arena[256];
+  char const *argv[32];
+
+  coopt_init(&state, options, NUM_OPTIONS, LINE_ARGC, line_argv);
+  coopt_emitter_init(&emitter, argv, 32, arena, sizeof(arena));
+  while (coopt_is_okay((ret = coopt(&state)).result))
+    coopt_emit(&emitter, &ret);
+  sink += coopt_emitted(&emitter);
+}
+
+/*
+ * Two tables of the same options, swapped back and forth; with nothing
+ * else going on, each swap retires the table it replaces.
+ */
+static struct coopt_tables tables;
+static struct coopt_table table[2];
+static int which_table;
+
+static void setup_tables(void)
+{
+  static int ready;
+  if (!ready)
+  {
+    table[0].options = table[1].options = options;
+    table[0].num_options = table[1].num_options = NUM_OPTIONS;
+    table[0].index = table[1].index = NULL;
+    coopt_tables_init(&tables, table);
+    ready = 1;
+  }
+}
+
+static void bench_table_acquire(void)
+{
+  struct coopt_table const *t;
+  unsigned int ticket;
+
+  setup_tables();
+  t = coopt_table_acquire(&tables, &ticket);
+  sink += t->num_options;
+  coopt_table_release(&tables, ticket);
+}
+
+static void bench_table_swap(void)
+{
+  setup_tables();
+  which_table = !which_table;
+  sink += coopt_tables_swap(&tables, table+which_table);
+}
+
+static void bench_table_startup(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  struct coopt_table const *t;
+  unsigned int ticket;
+
+  setup_tables();
+  t = coopt_table_acquire(&tables, &ticket);
+  coopt_table_init(&state, t, LINE_ARGC, line_argv);
+  do
+  {
+    ret = coopt(&state);
+    sink += (unsigned long)ret.opt;
+  }
+  while (coopt_is_okay(ret.result));
+  coopt_table_release(&tables, ticket);
+}
+
+/*
+ * The adversarial inputs: one long element (or a run of short ones) of
+ * 'input_size' bytes, in 'input'
+ */
+static char input[MAX_SIZE+3];
+static size_t input_size;
+static char const *input_argv[MAX_SIZE/5+1];
+static int input_argc;
+
+static void fill_input(char const *prefix, char c, size_t n)
+{
+  size_t len = strlen(prefix);
+
+  memcpy(input, prefix, len);
+  memset(input+len, c, n);
+  input[len+n] = 0;
+  input_argv[0] = input;
+  input_argc = 1;
+  input_size = n;
+}
+
+/* "--aaaa...", against a long_eq of "aaa...ab", which is the worst case
+ * for the obvious strstr()
+ */
+static char const long_eq[] = "aaaaaaaaaaaaaaaaaaaaaaaaaaaaaaab";
+
+static void setup_long_eq(size_t n)
+{
+  fill_input("--", 'a', n);
+}
+
+static void bench_long_eq(void)
+{
+  struct coopt_state state;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  state.long_eq = long_eq;
+  sink += coopt(&state).result;
+}
+
+/* Lots of "--op", each an ambiguous abbreviation of 256 options */
+#define NUM_ABBREV_OPTIONS 256
+static struct coopt_option abbrev_options[NUM_ABBREV_OPTIONS];
+static char abbrev_names[NUM_ABBREV_OPTIONS][8];
+static int abbrev_space[COOPT_INDEX_SIZE(NUM_ABBREV_OPTIONS)];
+static struct coopt_index abbrev_index;
+
+static void setup_abbrev(size_t n)
+{
+  int i;
+
+  for (i=0; i<NUM_ABBREV_OPTIONS; i++)
+  {
+    sprintf(abbrev_names[i], "opt%03i", i);
+    abbrev_options[i].short_option = 0;
+    abbrev_options[i].has_param = COOPT_NO_PARAM;
+    abbrev_options[i].long_option = abbrev_names[i];
+  }
+  coopt_index_init(&abbrev_index, abbrev_options, NUM_ABBREV_OPTIONS, 0,
+		   abbrev_space);
+  for (input_argc=0; (size_t)input_argc*5<n; input_argc++)
+  {
+    memcpy(input+input_argc*5, "--op", 5);
+    input_argv[input_argc] = input+input_argc*5;
+  }
+  input_size = n;
+}
+
+static void bench_abbrev(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, abbrev_options, NUM_ABBREV_OPTIONS, input_argc,
+	     input_argv);
+  coopt_use_index(&state, &abbrev_index);
+  state.flags.allow_long_opts_breved = 1;
+  do
+  {
+    ret = coopt(&state);
+    sink += ret.result;
+  }
+  while (!coopt_is_termination(ret.result));
+}
+
+/* "-zzzz...", each of which is an unknown option */
+static void setup_short_run(size_t n)
+{
+  fill_input("-", 'z', n);
+}
+
+static void bench_short_run(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  do
+  {
+    ret = coopt(&state);
+    sink += ret.result;
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+static void bench_short_run_limited(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  state.max_results = 64;
+  do
+  {
+    ret = coopt(&state);
+    sink += ret.result;
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+static void bench_short_run_diagnosed(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  struct coopt_diagnostic entries[64];
+  struct coopt_diagnostics diag;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  coopt_diagnostics_init(&diag, entries, 64);
+  coopt_diagnose(&state, &diag);
+  ret = coopt(&state);
+  sink += ret.result + diag.count;
+}
+
+/* "-vqnkvqnk...", all of them options without parameters */
+static void setup_flag_run(size_t n)
+{
+  size_t i;
+
+  fill_input("-", 'v', n);
+  for (i=0; i<n; i++)
+    input[1+i] = "vqnk"[i&3];
+}
+
+static void bench_flag_run(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  do
+  {
+    ret = coopt(&state);
+    sink += (unsigned long)ret.opt;
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+static void bench_flag_run_cluster(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  unsigned long flags[COOPT_FLAGMAP_WORDS(NUM_OPTIONS)];
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  do
+  {
+    ret = coopt_cluster(&state, flags);
+    sink += flags[0];
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+/* "--aaaa...", which max_length should stop us looking at */
+static void setup_long_element(size_t n)
+{
+  fill_input("--", 'a', n);
+}
+
+static void bench_long_element_limited(void)
+{
+  struct coopt_state state;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  state.max_length = 1024;
+  sink += coopt(&state).result;
+}
+
+/*
+ * "-fab in -fab in ...": an option for each of n/10 inputs, kept as
+ * coopt() returns them, and then with their scopes as well
+ */
+static struct coopt_return input_results[MAX_SIZE/5+1];
+static struct coopt_scope input_scopes[MAX_SIZE/5+1];
+
+static void setup_inputs(size_t n)
+{
+  for (input_argc=0; (size_t)input_argc*5<n; input_argc++)
+  {
+    memcpy(input+input_argc*5, (input_argc&1)?("in.c"):("-fab"), 5);
+    input_argv[input_argc] = input+input_argc*5;
+  }
+  input_size = n;
+}
+
+static void bench_inputs(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  int n = 0;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  while (coopt_is_okay((ret = coopt(&state)).result))
+    input_results[n++] = ret;
+  sink += n;
+}
+
+static void bench_inputs_scopes(void)
+{
+  struct coopt_state state;
+  struct coopt_scopes scopes;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  coopt_scopes_init(&scopes, input_results, MAX_SIZE/5+1, input_scopes,
+		    MAX_SIZE/5+1);
+  coopt_scopes(&state, &scopes);
+  sink += scopes.num_scopes;
+}
+
+/*
+ * The same, parsed once up front, and then the option in the middle
+ * changed back and forth; with enough checkpoints, each time takes about
+ * as long however long the command line is
+ */
+static struct coopt_state edited_state;
+static struct coopt_incremental edited;
+static struct coopt_checkpoint edited_checkpoints[1024];
+
+static void setup_edited(size_t n)
+{
+  setup_inputs(n);
+  coopt_init(&edited_state, options, NUM_OPTIONS, input_argc, input_argv);
+  coopt_incremental_init(&edited, input_results, MAX_SIZE/5+1,
+			 edited_checkpoints, 1024);
+  coopt_incremental(&edited_state, &edited);
+}
+
+static void bench_edited(void)
+{
+  int middle = (input_argc/2) & ~1;
+
+  input_argv[middle] = (input_argv[middle][2]=='a') ? "-fcd" : "-fab";
+  sink += coopt_reparse(&edited_state, &edited, input_argc, input_argv,
+			middle, 1, 1);
+  sink += edited.num_changed;
+}
+
+/*
+ * "-Wxy --zz -v -Wxy ...": mostly options for something else, with the
+ * options indexed
+ */
+static int foreign_space[COOPT_INDEX_SIZE(NUM_OPTIONS)];
+static struct coopt_index foreign_index;
+
+static void setup_foreign(size_t n)
+{
+  static char const * const elements[] = { "-Wxy", "--zz", "-v" };
+
+  coopt_index_init(&foreign_index, options, NUM_OPTIONS, 0, foreign_space);
+  for (input_argc=0; (size_t)input_argc*5<n; input_argc++)
+  {
+    memcpy(input+input_argc*5, elements[input_argc%3], 5);
+    input_argv[input_argc] = input+input_argc*5;
+  }
+  input_size = n;
+}
+
+static void bench_foreign(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  coopt_use_index(&state, &foreign_index);
+  do
+  {
+    ret = coopt(&state);
+    sink += (unsigned long)ret.param;
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+static void bench_foreign_passthrough(void)
+{
+  struct coopt_state state;
+  struct coopt_return ret;
+  char const * const *elements;
+  int count;
+
+  coopt_init(&state, options, NUM_OPTIONS, input_argc, input_argv);
+  coopt_use_index(&state, &foreign_index);
+  do
+  {
+    ret = coopt_passthrough(&state, 1, &elements, &count);
+    sink += (unsigned long)ret.param + count;
+  }
+  while (!coopt_is_termination(ret.result) && !coopt_is_fatal(ret.result));
+}
+
+/* How long one call of 'run' takes, in ns */
+static double time_bench(void (*run)(void))
+{
+  unsigned long n = 0, batch = 1;
+  clock_t start = clock(), elapsed;
+
+  do
+  {
+    unsigned long j;
+    for (j=0; j<batch; j++)
+      run();
+    n += batch;
+    if (batch<1000)
+      batch *= 2;
+    elapsed = clock()-start;
+  }
+  while (elapsed < MIN_TIME);
+  return 1e9*elapsed/CLOCKS_PER_SEC/n;
+}
+
+int main(void)
+{
+  unsigned int i, j;
+
+  printf("sizeof(struct coopt_state) = %lu\n",
+	 (unsigned long)sizeof(struct coopt_state));
+  for (i=0; i<NUM_BENCHES; i++)
+  {
+    if (benches[i].setup==NULL)
+    {
+      printf("%-50s %10.1f ns\n", benches[i].name,
+	     time_bench(benches[i].run));
+      continue;
+    }
+    printf("%s\n", benches[i].name);
+    for (j=0; j<NUM_SIZES; j++)
+    {
+      double t;
+      benches[i].setup(sizes[j]);
+      t = time_bench(benches[i].run);
+      printf("  %8lu bytes %15.1f ns %10.3f ns/byte\n",
+	     (unsigned long)sizes[j], t, t/sizes[j]);
+    }
+  }
+  return 0;
+}
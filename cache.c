@@ -0,0 +1,893 @@
+/*
+ * $Id$
+ * cache.c
+ *
+ * Implementation of a cache of the results of whole command lines (which
+ * can be saved and loaded again), for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Each slot holds a key, which is everything that affects the results
+ * (see coopt_cache_key()), followed by the results just as coopt()
+ * returned them, so a hit can copy them out in one go. Their parameters
+ * and markers pointed into the state they came from, so they're kept as
+ * NULL, and the end of the slot has a struct coopt_cache_fix for each
+ * result (the first one last) saying where they really were.
+ *
+ * A saved cache can't depend on where anything was, so its results are
+ * RESULT_SIZE bytes each instead:
+ *
+ *   0		result + 128
+ *   1		ambigresult + 128
+ *   2		position of the marker in state->markers + 1, or 0
+ *   3-6	position of the option in state->options + 1, or 0
+ *   7-10	element of argv the parameter is in, or NO_VALUE
+ *   11-14	offset of the parameter in that element
+ *
+ * Numbers there (and in keys) are little-endian. The image is a header
+ * of native ints (as for index images), then each slot in use from the
+ * least recently used: three ints (key_size, size and num_results, where
+ * size is of the key and results as saved), then the key and results
+ * padded to a whole number of ints.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+/* Keys are hashed a (32 bit, little-endian) word at a time */
+#define KEY_OFFSET		2166136261UL
+#define KEY_MULTIPLIER		0x9e3779b1UL
+#define key_mix(h, w) \
+	((h) = (((h) ^ (w))*KEY_MULTIPLIER) & 0xffffffffUL, (h) ^= (h)>>16)
+
+#define KEY_HEAD		(1+4*8)	/* bytes before the strings */
+#define KEY_SCRATCH		512	/* bytes of key built on the stack */
+#define RESULT_SIZE		15	/* saved */
+#define RECORD_SIZE \
+	(sizeof(struct coopt_return) + sizeof(struct coopt_cache_fix))
+#define NO_VALUE		0xffffffffUL
+
+#define CACHE_MAGIC		0	/* COOPT_CACHE_MAGIC */
+#define CACHE_VERSION		1	/* COOPT_CACHE_VERSION */
+#define CACHE_BYTE_ORDER	2	/* CACHE_ORDER_MARK */
+#define CACHE_INT_SIZE		3	/* sizeof(int) */
+#define CACHE_SIZE		4	/* bytes in the whole image */
+#define CACHE_FINGERPRINT	5	/* of the options */
+#define CACHE_ENTRIES		6
+#define CACHE_HEADER		8	/* the rest is reserved, and zero */
+#define CACHE_ENTRY		3	/* ints before each entry's data */
+
+#define CACHE_ORDER_MARK	0x01020304
+
+/* data is padded to this */
+#define cache_ints(size) (((size)+sizeof(int)-1)/sizeof(int))
+#define cache_saved(s) ((s)->key_size + (s)->num_results*RESULT_SIZE)
+
+/* What coopt_cache_put() does with each part of a key */
+#define KEY_HASH		0
+#define KEY_COMPARE		1
+#define KEY_COPY		2
+
+struct coopt_cache_key
+{
+  int mode;
+  unsigned char * data; /* to compare with or copy to */
+  size_t room; /* bytes at data */
+  size_t size; /* bytes of key so far */
+  unsigned long hash;
+  int differ; /* non-zero once it doesn't match data */
+};
+
+/* Where a result's parameter and marker were */
+struct coopt_cache_fix
+{
+  unsigned long element; /* or NO_VALUE */
+  unsigned long offset;
+  unsigned int marker; /* position in state->markers + 1, or 0 */
+};
+
+static int coopt_cache_usable(struct coopt_cache const *,
+			      struct coopt_state const *);
+static void coopt_cache_key(struct coopt_cache_key *,
+			    struct coopt_state const *);
+static void coopt_cache_start(struct coopt_cache_key *, int,
+			      unsigned char *, size_t);
+static void coopt_cache_put(struct coopt_cache_key *, void const *, size_t);
+static void coopt_cache_string(struct coopt_cache_key *, char const *);
+static void coopt_cache_number(unsigned char *, unsigned long);
+static void coopt_cache_set32(unsigned char *, unsigned long);
+static unsigned long coopt_cache_get32(unsigned char const *);
+static unsigned long coopt_cache_hash(unsigned char const *, size_t);
+static int coopt_cache_encode(struct coopt_state const *,
+			      char const * const *, int,
+			      struct coopt_return const *, int *,
+			      struct coopt_cache_fix *);
+static void coopt_cache_pack(struct coopt_cache const *,
+			     struct coopt_return const *,
+			     struct coopt_cache_fix const *, unsigned char *);
+static void coopt_cache_unpack(struct coopt_cache const *,
+			       unsigned char const *, struct coopt_return *,
+			       struct coopt_cache_fix *);
+static int coopt_cache_check(struct coopt_cache const *,
+			     unsigned char const *, size_t, unsigned int,
+			     unsigned long *, unsigned long *);
+static int coopt_cache_find(struct coopt_cache *, struct coopt_state const *,
+			    unsigned char const *, size_t, unsigned long);
+static int coopt_cache_take(struct coopt_cache *);
+static void coopt_cache_release(struct coopt_cache *, int);
+static void coopt_cache_insert(struct coopt_cache *, int);
+static void coopt_cache_remove(struct coopt_cache *, int);
+static void coopt_cache_lock(struct coopt_cache *);
+static void coopt_cache_unlock(struct coopt_cache *);
+
+void coopt_cache_init(struct coopt_cache *cache,
+		      struct coopt_option const *options,
+		      unsigned int num_options, unsigned int slots,
+		      size_t slot_size, void *space)
+{
+  struct coopt_cache_key k;
+  unsigned int i;
+
+  cache->lookups = 0;
+  cache->hits = 0;
+  cache->collisions = 0;
+  cache->evictions = 0;
+  cache->lock = NULL;
+  cache->unlock = NULL;
+  cache->lock_data = NULL;
+
+  cache->options = options;
+  cache->num_options = num_options;
+  coopt_cache_start(&k, KEY_HASH, NULL, 0);
+  for (i=0; i<num_options; i++)
+  {
+    unsigned char b[3];
+    b[0] = (unsigned char)options[i].short_option;
+    b[1] = (unsigned char)options[i].has_param;
+    b[2] = (options[i].long_option!=NULL);
+    coopt_cache_put(&k, b, 3);
+    if (options[i].long_option!=NULL)
+      coopt_cache_string(&k, options[i].long_option);
+  }
+  cache->fingerprint = k.hash;
+
+  /* the most buckets that fit, which is at least as many as slots */
+  cache->mask = 1;
+  while (cache->mask*2 <= 2*(unsigned long)slots)
+    cache->mask *= 2;
+  cache->mask--;
+  cache->slots = (struct coopt_cache_slot *)space;
+  cache->buckets = (int *)(cache->slots + slots);
+  cache->data = (unsigned char *)(cache->buckets + 2*slots);
+  cache->num_slots = slots;
+  cache->slot_size = slot_size;
+  cache->newest = -1;
+  cache->oldest = -1;
+  cache->free = -1;
+  if (slots==0)
+    return; /* no buckets either */
+  for (i=0; i<=cache->mask; i++)
+    cache->buckets[i] = -1;
+  for (i=slots; i>0; i--)
+    coopt_cache_release(cache, i-1);
+}
+
+int coopt_cache_run(struct coopt_cache *cache, struct coopt_state *state,
+		    struct coopt_return *results, int max_results)
+{
+  unsigned char key[KEY_SCRATCH];
+  struct coopt_cache_key k;
+  struct coopt_cache_fix fix;
+  struct coopt_return ret, bare;
+  char const * const *argv;
+  unsigned char *data=NULL;
+  size_t key_size=0, end;
+  int argc, i, n, slot, element, stored;
+  unsigned long hash=0;
+
+  if (!coopt_cache_usable(cache, state))
+    slot = -1;
+  else
+  {
+    /* one walk over the state, then the key's all in one place */
+    coopt_cache_start(&k, KEY_COPY, key, sizeof(key));
+    coopt_cache_key(&k, state);
+    key_size = k.size;
+    hash = coopt_cache_hash(key, key_size);
+
+    coopt_cache_lock(cache);
+    cache->lookups++;
+    slot = coopt_cache_find(cache, state, key, key_size, hash);
+    if (slot>=0)
+    {
+      struct coopt_cache_slot *s = cache->slots + slot;
+      data = cache->data + slot*cache->slot_size;
+      n = s->num_results;
+      if (max_results>0)
+	coopt_memcpy(results, data + s->key_size,
+		     ((n<max_results)?(n):(max_results))*
+		     sizeof(struct coopt_return));
+      data += cache->slot_size;
+      for (i=0; i<n && i<max_results; i++)
+      {
+	data -= sizeof(fix);
+	coopt_memcpy(&fix, data, sizeof(fix));
+	results[i].param = (fix.element==NO_VALUE)?(NULL):
+			   (state->argv[fix.element] + fix.offset);
+	results[i].marker = (fix.marker==0)?(NULL):
+			    (state->markers[fix.marker-1]);
+      }
+      state->num_results = s->counted;
+      cache->hits++;
+      coopt_cache_remove(cache, slot);
+      coopt_cache_insert(cache, slot);
+      coopt_cache_unlock(cache);
+      state->argv += state->argc;
+      state->argc = 0;
+      return n;
+    }
+    slot = (key_size<=cache->slot_size)?(coopt_cache_take(cache)):(-1);
+    coopt_cache_unlock(cache);
+  }
+
+  /* The slot isn't anywhere the cache can see, so it's ours for now */
+  argv = (state!=NULL)?(state->argv):(NULL);
+  argc = (state!=NULL)?(state->argc):(0);
+  stored = (slot>=0);
+  if (stored)
+  {
+    data = cache->data + slot*cache->slot_size;
+    if (key_size<=sizeof(key))
+      coopt_memcpy(data, key, key_size);
+    else
+    {
+      coopt_cache_start(&k, KEY_COPY, data, key_size);
+      coopt_cache_key(&k, state);
+    }
+  }
+  element = 0;
+  end = key_size;
+  n = 0;
+  do
+  {
+    ret = coopt(state);
+    if (n<max_results)
+      results[n] = ret;
+    if (stored)
+    {
+      if (end+RECORD_SIZE > cache->slot_size ||
+	  coopt_cache_encode(state, argv, argc, &ret, &element, &fix)<0)
+	stored = 0;
+      else
+      {
+	bare = ret;
+	bare.param = NULL;
+	bare.marker = NULL;
+	coopt_memcpy(data + key_size + n*sizeof(bare), &bare, sizeof(bare));
+	coopt_memcpy(data + cache->slot_size - (n+1)*sizeof(fix), &fix,
+		     sizeof(fix));
+	end += RECORD_SIZE;
+      }
+    }
+    n++;
+  } while (!coopt_is_termination(ret.result) &&
+	   !coopt_is_fatal(ret.result));
+
+  if (slot>=0)
+  {
+    coopt_cache_lock(cache);
+    if (stored)
+    {
+      struct coopt_cache_slot *s = cache->slots + slot;
+      s->hash = hash;
+      s->key_size = key_size;
+      s->size = end;
+      s->num_results = n;
+      s->counted = state->num_results;
+      coopt_cache_insert(cache, slot);
+    }
+    else
+      coopt_cache_release(cache, slot);
+    coopt_cache_unlock(cache);
+  }
+  return n;
+}
+
+size_t coopt_cache_write(struct coopt_cache *cache, void *buffer,
+			 size_t size)
+{
+  size_t needed = CACHE_HEADER*sizeof(int);
+  int entries = 0;
+  int slot;
+  int *out;
+
+  coopt_cache_lock(cache);
+  for (slot=cache->oldest; slot>=0; slot=cache->slots[slot].newer)
+  {
+    needed += (CACHE_ENTRY + cache_ints(cache_saved(cache->slots + slot)))*
+	      sizeof(int);
+    entries++;
+  }
+  if (buffer!=NULL && size>=needed)
+  {
+    out = (int *)buffer;
+    coopt_memset(buffer, 0, needed);
+    out[CACHE_MAGIC] = COOPT_CACHE_MAGIC;
+    out[CACHE_VERSION] = COOPT_CACHE_VERSION;
+    out[CACHE_BYTE_ORDER] = CACHE_ORDER_MARK;
+    out[CACHE_INT_SIZE] = sizeof(int);
+    out[CACHE_SIZE] = needed;
+    out[CACHE_FINGERPRINT] = cache->fingerprint;
+    out[CACHE_ENTRIES] = entries;
+    out += CACHE_HEADER;
+    for (slot=cache->oldest; slot>=0; slot=cache->slots[slot].newer)
+    {
+      struct coopt_cache_slot const *s = cache->slots + slot;
+      unsigned char const *data = cache->data + slot*cache->slot_size;
+      unsigned char *bytes = (unsigned char *)(out + CACHE_ENTRY);
+      struct coopt_return ret;
+      struct coopt_cache_fix fix;
+      unsigned int i;
+
+      *out++ = s->key_size;
+      *out++ = cache_saved(s);
+      *out++ = s->num_results;
+      coopt_memcpy(bytes, data, s->key_size);
+      for (i=0; i<s->num_results; i++)
+      {
+	coopt_memcpy(&ret, data + s->key_size + i*sizeof(ret), sizeof(ret));
+	coopt_memcpy(&fix, data + cache->slot_size - (i+1)*sizeof(fix),
+		     sizeof(fix));
+	coopt_cache_pack(cache, &ret, &fix,
+			 bytes + s->key_size + i*RESULT_SIZE);
+      }
+      out += cache_ints(cache_saved(s));
+    }
+  }
+  coopt_cache_unlock(cache);
+  return needed;
+}
+
+int coopt_cache_read(struct coopt_cache *cache, void const *image,
+		     size_t size)
+{
+  int const *in = (int const *)image;
+  int const *end;
+  int entries, i, loaded=0;
+
+  if (size<CACHE_HEADER*sizeof(int) ||
+      in[CACHE_MAGIC]!=COOPT_CACHE_MAGIC ||
+      in[CACHE_VERSION]!=COOPT_CACHE_VERSION ||
+      in[CACHE_BYTE_ORDER]!=CACHE_ORDER_MARK ||
+      in[CACHE_INT_SIZE]!=sizeof(int) ||
+      in[CACHE_SIZE]<0 || (size_t)in[CACHE_SIZE]>size ||
+      in[CACHE_FINGERPRINT]!=(int)cache->fingerprint ||
+      in[CACHE_ENTRIES]<0)
+    return -1;
+
+  /* check it all before loading anything */
+  entries = in[CACHE_ENTRIES];
+  end = in + in[CACHE_SIZE]/sizeof(int);
+  in += CACHE_HEADER;
+  for (i=0; i<entries; i++)
+  {
+    if (end-in < CACHE_ENTRY || in[0]<0 || in[1]<in[0] || in[2]<1 ||
+	(size_t)(in[1]-in[0])!=(size_t)in[2]*RESULT_SIZE ||
+	(size_t)(end-in-CACHE_ENTRY) < cache_ints((size_t)in[1]))
+      return -1;
+    in += CACHE_ENTRY + cache_ints((size_t)in[1]);
+  }
+
+  coopt_cache_lock(cache);
+  in = (int const *)image + CACHE_HEADER;
+  for (i=0; i<entries; i++)
+  {
+    unsigned char const *saved = (unsigned char const *)(in + CACHE_ENTRY);
+    size_t key_size = in[0];
+    unsigned int j, num_results = in[2];
+    unsigned long hash, counted;
+    int slot;
+    if (key_size<=cache->slot_size &&
+	num_results<=(cache->slot_size-key_size)/RECORD_SIZE &&
+	coopt_cache_check(cache, saved, key_size, num_results, &hash,
+			  &counted)==0 &&
+	(slot=coopt_cache_take(cache))>=0)
+    {
+      struct coopt_cache_slot *s = cache->slots + slot;
+      unsigned char *data = cache->data + slot*cache->slot_size;
+      struct coopt_return ret;
+      struct coopt_cache_fix fix;
+
+      coopt_memcpy(data, saved, key_size);
+      for (j=0; j<num_results; j++)
+      {
+	coopt_cache_unpack(cache, saved + key_size + j*RESULT_SIZE, &ret,
+			   &fix);
+	coopt_memcpy(data + key_size + j*sizeof(ret), &ret, sizeof(ret));
+	coopt_memcpy(data + cache->slot_size - (j+1)*sizeof(fix), &fix,
+		     sizeof(fix));
+      }
+      s->hash = hash;
+      s->key_size = key_size;
+      s->size = key_size + num_results*RECORD_SIZE;
+      s->num_results = num_results;
+      s->counted = counted;
+      coopt_cache_insert(cache, slot);
+      loaded++;
+    }
+    in += CACHE_ENTRY + cache_ints((size_t)in[1]);
+  }
+  coopt_cache_unlock(cache);
+  return loaded;
+}
+
+/*
+ * Can (state) use the cache? Only if it's fresh, and its results don't
+ * depend on (or go to) anything but its options and configuration.
+ */
+static int coopt_cache_usable(struct coopt_cache const *cache,
+			      struct coopt_state const *state)
+{
+  return (cache!=NULL && cache->num_slots>0 && state!=NULL &&
+	  state->argv!=NULL && state->markers!=NULL &&
+	  state->options==cache->options &&
+	  state->num_options==cache->num_options &&
+	  state->namespaces==NULL && state->constraints==NULL &&
+	  state->parsed==NULL && state->diagnostics==NULL &&
+	  state->trace==NULL &&
+	  state->classmap==NULL &&
+	  state->permutation==NULL && state->char_within_arg==0 &&
+	  state->skip_next_arg==0 && state->num_results==0);
+}
+
+/*
+ * Everything that affects the results, except the options themselves
+ * (which are fixed for the cache, and in its fingerprint).
+ */
+static void coopt_cache_key(struct coopt_cache_key *k,
+			    struct coopt_state const *state)
+{
+  unsigned char head[KEY_HEAD];
+  int i;
+
+  /* as few pieces as possible, since each costs as much as a few bytes */
+  for (i=0; state->markers[i]!=NULL; i++)
+    ;
+  head[0] = (unsigned char)(state->flags.allow_mix_short_params |
+			    state->flags.allow_long_eq_params<<1 |
+			    state->flags.allow_long_sep_params<<2 |
+			    state->flags.allow_long_opts_breved<<3 |
+			    (state->separator!=NULL)<<4 |
+			    (state->long_eq!=NULL)<<5);
+  coopt_cache_number(head+1, i);
+  coopt_cache_number(head+9, state->max_length);
+  coopt_cache_number(head+17, state->max_results);
+  coopt_cache_number(head+25, state->argc);
+  coopt_cache_put(k, head, sizeof(head));
+  if (state->separator!=NULL)
+    coopt_cache_string(k, state->separator);
+  if (state->long_eq!=NULL)
+    coopt_cache_string(k, state->long_eq);
+  for (i=0; state->markers[i]!=NULL; i++)
+    coopt_cache_string(k, state->markers[i]);
+  for (i=0; i<state->argc; i++)
+    coopt_cache_string(k, state->argv[i]);
+}
+
+static void coopt_cache_start(struct coopt_cache_key *k, int mode,
+			      unsigned char *data, size_t room)
+{
+  k->mode = mode;
+  k->data = data;
+  k->room = room;
+  k->size = 0;
+  k->hash = KEY_OFFSET;
+  k->differ = 0;
+}
+
+/* Hash, compare or copy the next part of the key */
+static void coopt_cache_put(struct coopt_cache_key *k, void const *bytes,
+			    size_t n)
+{
+  unsigned char const *b = (unsigned char const *)bytes;
+  unsigned long h, w;
+  size_t i=0;
+
+  switch (k->mode)
+  {
+   case KEY_HASH:
+    /* the last word overlaps the one before, so there's no loop for it */
+    h = k->hash;
+    if (n>=4)
+    {
+      for (i=0; i+4<n; i+=4)
+	key_mix(h, coopt_cache_get32(b+i));
+      w = coopt_cache_get32(b+n-4);
+    }
+    else if (n>0)
+      w = b[0] | (unsigned long)b[n>>1]<<8 | (unsigned long)b[n-1]<<16;
+    else
+      w = 0;
+    key_mix(h, w);
+    k->hash = h;
+    break;
+   case KEY_COMPARE:
+    if (!k->differ &&
+	(k->size+n > k->room || coopt_memcmp(k->data+k->size, b, n)!=0))
+      k->differ = 1;
+    break;
+   case KEY_COPY:
+    /* as much as fits, so the start can be used even if the rest can't */
+    if (k->size < k->room)
+      coopt_memcpy(k->data+k->size, b,
+		   (n < k->room-k->size)?(n):(k->room-k->size));
+    break;
+  }
+  k->size += n;
+}
+
+/* Strings are kept with their NUL, so they don't run together */
+static void coopt_cache_string(struct coopt_cache_key *k, char const *s)
+{
+  if (k->mode==KEY_COMPARE && !k->differ)
+  {
+    /* there's no need to find its length first */
+    unsigned char const *d = k->data + k->size;
+    size_t room = k->room - k->size;
+    size_t i;
+    for (i=0; i<room && d[i]==(unsigned char)s[i]; i++)
+    {
+      if (s[i]==0)
+      {
+	k->size += i+1;
+	return;
+      }
+    }
+    k->differ = 1; /* and the size doesn't matter any more */
+    return;
+  }
+  if (k->mode==KEY_COPY)
+  {
+    /* likewise, they're mostly short enough to copy a byte at a time */
+    unsigned char *d = k->data + k->size;
+    size_t room = (k->size<k->room)?(k->room-k->size):(0);
+    size_t i;
+    for (i=0; i<room; i++)
+    {
+      if ((d[i]=(unsigned char)s[i])==0)
+      {
+	k->size += i+1;
+	return;
+      }
+    }
+    k->size += room + coopt_strlen(s+room)+1;
+    return;
+  }
+  coopt_cache_put(k, s, coopt_strlen(s)+1);
+}
+
+static void coopt_cache_number(unsigned char *b, unsigned long v)
+{
+  coopt_cache_set32(b, v);
+  coopt_cache_set32(b+4, (v>>16)>>16); /* in case it's only 32 bits */
+}
+
+static void coopt_cache_set32(unsigned char *b, unsigned long v)
+{
+  b[0] = (unsigned char)(v & 0xff);
+  b[1] = (unsigned char)((v>>8) & 0xff);
+  b[2] = (unsigned char)((v>>16) & 0xff);
+  b[3] = (unsigned char)((v>>24) & 0xff);
+}
+
+static unsigned long coopt_cache_get32(unsigned char const *b)
+{
+  return (unsigned long)b[0] | (unsigned long)b[1]<<8 |
+	 (unsigned long)b[2]<<16 | (unsigned long)b[3]<<24;
+}
+
+/*
+ * Hash a key, of which the first KEY_SCRATCH bytes (all of it, unless
+ * it's huge) are at (key); anything past that is compared anyway.
+ */
+static unsigned long coopt_cache_hash(unsigned char const *key, size_t size)
+{
+  struct coopt_cache_key k;
+
+  coopt_cache_start(&k, KEY_HASH, NULL, 0);
+  coopt_cache_put(&k, key, (size<KEY_SCRATCH)?(size):(KEY_SCRATCH));
+  key_mix(k.hash, size & 0xffffffffUL);
+  return k.hash;
+}
+
+/*
+ * Note in (fix) where the parameter and marker of (ret) are, with its
+ * parameter found in one of (argc) elements of (argv), starting from
+ * *element (which is where the last one was, so this is usually quick).
+ * Returns -1 if it can't be kept, because it points at something other
+ * than the state's own options, markers and elements, or won't fit in a
+ * saved cache.
+ */
+static int coopt_cache_encode(struct coopt_state const *state,
+			      char const * const *argv, int argc,
+			      struct coopt_return const *ret, int *element,
+			      struct coopt_cache_fix *fix)
+{
+  int i;
+
+  if (ret->result<-128 || ret->result>127 ||
+      ret->ambigresult<-128 || ret->ambigresult>127 || ret->related!=NULL)
+    return -1;
+  if (ret->opt!=NULL && (ret->opt<state->options ||
+			 ret->opt>=state->options+state->num_options))
+    return -1;
+  fix->marker = 0;
+  if (ret->marker!=NULL)
+  {
+    for (i=0; state->markers[i]!=NULL && state->markers[i]!=ret->marker; i++)
+      ;
+    if (state->markers[i]==NULL || i>=255)
+      return -1;
+    fix->marker = i+1;
+  }
+  fix->element = NO_VALUE;
+  fix->offset = 0;
+  if (ret->param==NULL)
+    return 0;
+  for (i=0; i<argc; i++)
+  {
+    int e = (*element+i) % argc;
+    if (ret->param>=argv[e] && ret->param<=argv[e]+coopt_strlen(argv[e]))
+    {
+      *element = e;
+      fix->element = e;
+      fix->offset = ret->param - argv[e];
+      return 0;
+    }
+  }
+  return -1;
+}
+
+/* A result as it's saved; it's already been checked, when it was kept */
+static void coopt_cache_pack(struct coopt_cache const *cache,
+			     struct coopt_return const *ret,
+			     struct coopt_cache_fix const *fix,
+			     unsigned char *out)
+{
+  out[0] = (unsigned char)(ret->result+128);
+  out[1] = (unsigned char)(ret->ambigresult+128);
+  out[2] = (unsigned char)fix->marker;
+  coopt_cache_set32(out+3, (ret->opt==NULL)?(0):
+			   ((ret->opt - cache->options) + 1));
+  coopt_cache_set32(out+7, fix->element);
+  coopt_cache_set32(out+11, fix->offset);
+}
+
+/* And back again; it's already been checked, by coopt_cache_check() */
+static void coopt_cache_unpack(struct coopt_cache const *cache,
+			       unsigned char const *in,
+			       struct coopt_return *ret,
+			       struct coopt_cache_fix *fix)
+{
+  unsigned long opt = coopt_cache_get32(in+3);
+
+  ret->result = in[0]-128;
+  ret->ambigresult = in[1]-128;
+  ret->opt = (opt==0)?(NULL):(cache->options + (opt-1));
+  ret->param = NULL;
+  ret->marker = NULL;
+  ret->related = NULL;
+  fix->marker = in[2];
+  fix->element = coopt_cache_get32(in+7);
+  fix->offset = coopt_cache_get32(in+11);
+}
+
+/*
+ * Check a saved slot: its key must be laid out as coopt_cache_key() does
+ * it, and its results must fit the key (so they fit any state with the
+ * same key). Its hash, and what state->num_results ends up as after its
+ * results, are set if it's all right; otherwise returns -1.
+ */
+static int coopt_cache_check(struct coopt_cache const *cache,
+			     unsigned char const *data, size_t key_size,
+			     unsigned int num_results, unsigned long *hash,
+			     unsigned long *counted)
+{
+  unsigned long num_markers, argc, strings, i, element;
+  unsigned char const *in;
+  size_t at, first;
+
+  if (key_size<KEY_HEAD || coopt_cache_get32(data+5)!=0 ||
+      coopt_cache_get32(data+29)!=0)
+    return -1;
+  num_markers = coopt_cache_get32(data+1);
+  argc = coopt_cache_get32(data+25);
+  if (num_markers>key_size || argc>key_size)
+    return -1; /* each string is at least one byte */
+  strings = ((data[0]>>4)&1) + ((data[0]>>5)&1) + num_markers;
+
+  at = first = KEY_HEAD;
+  for (i=0; i<strings+argc; i++)
+  {
+    unsigned char const *end = (unsigned char const *)
+			       coopt_memchr(data+at, 0, key_size-at);
+    if (end==NULL)
+      return -1;
+    if (i==strings)
+      first = at;
+    at = (end-data)+1;
+  }
+  if (at!=key_size)
+    return -1;
+  if (argc==0)
+    first = at;
+
+  in = data + key_size;
+  element = 0;
+  at = first;
+  *counted = 0;
+  for (i=0; i<num_results; i++, in+=RESULT_SIZE)
+  {
+    unsigned long e = coopt_cache_get32(in+7);
+    if (in[2]>num_markers ||
+	coopt_cache_get32(in+3)>cache->num_options)
+      return -1;
+    if (e!=NO_VALUE)
+    {
+      if (e>=argc)
+	return -1;
+      if (e<element)
+      {
+	element = 0;
+	at = first;
+      }
+      for (; element<e; element++)
+	at += coopt_strlen((char const *)data+at)+1;
+      if (coopt_cache_get32(in+11)>coopt_strlen((char const *)data+at))
+	return -1;
+    }
+    /* as coopt() counts them: not the termination, nor hitting the limit */
+    if (!coopt_is_termination(in[0]-128) &&
+	(in[0]-128!=COOPT_RESULT_TOOMANY ||
+	 (coopt_cache_get32(data+17)==0 && coopt_cache_get32(data+21)==0)))
+      (*counted)++;
+  }
+  *hash = coopt_cache_hash(data, key_size);
+  return 0;
+}
+
+/*
+ * The slot holding (key) for (state), which is (size) bytes (only as far
+ * as KEY_SCRATCH of them are in (key)) with (hash), or -1. Slots with the
+ * same hash but a different key are collisions.
+ */
+static int coopt_cache_find(struct coopt_cache *cache,
+			    struct coopt_state const *state,
+			    unsigned char const *key, size_t size,
+			    unsigned long hash)
+{
+  int slot;
+  for (slot=cache->buckets[hash & cache->mask]; slot>=0;
+       slot=cache->slots[slot].chain)
+  {
+    struct coopt_cache_slot const *s = cache->slots + slot;
+    if (s->hash==hash && s->key_size==size)
+    {
+      unsigned char *data = cache->data + slot*cache->slot_size;
+      if (coopt_memcmp(data, key,
+		       (size<KEY_SCRATCH)?(size):(KEY_SCRATCH))==0)
+      {
+	struct coopt_cache_key c;
+	if (size<=KEY_SCRATCH)
+	  return slot;
+	coopt_cache_start(&c, KEY_COMPARE, data, size);
+	coopt_cache_key(&c, state);
+	if (!c.differ)
+	  return slot;
+      }
+      cache->collisions++;
+    }
+  }
+  return -1;
+}
+
+/* A slot to fill in: a free one, or the least recently used. -1 if none */
+static int coopt_cache_take(struct coopt_cache *cache)
+{
+  int slot = cache->free;
+  if (slot>=0)
+  {
+    cache->free = cache->slots[slot].older;
+    return slot;
+  }
+  slot = cache->oldest;
+  if (slot>=0)
+  {
+    coopt_cache_remove(cache, slot);
+    cache->evictions++;
+  }
+  return slot;
+}
+
+static void coopt_cache_release(struct coopt_cache *cache, int slot)
+{
+  cache->slots[slot].older = cache->free;
+  cache->free = slot;
+}
+
+/* Put a filled-in slot in its bucket, as the most recently used */
+static void coopt_cache_insert(struct coopt_cache *cache, int slot)
+{
+  struct coopt_cache_slot *s = cache->slots + slot;
+  int *bucket = cache->buckets + (s->hash & cache->mask);
+
+  s->chain = *bucket;
+  *bucket = slot;
+  s->older = cache->newest;
+  s->newer = -1;
+  if (cache->newest>=0)
+    cache->slots[cache->newest].newer = slot;
+  else
+    cache->oldest = slot;
+  cache->newest = slot;
+}
+
+/* Take a slot out of its bucket and the order of use */
+static void coopt_cache_remove(struct coopt_cache *cache, int slot)
+{
+  struct coopt_cache_slot *s = cache->slots + slot;
+  int *p = cache->buckets + (s->hash & cache->mask);
+
+  while (*p!=slot)
+    p = &cache->slots[*p].chain;
+  *p = s->chain;
+  if (s->older>=0)
+    cache->slots[s->older].newer = s->newer;
+  else
+    cache->oldest = s->newer;
+  if (s->newer>=0)
+    cache->slots[s->newer].older = s->older;
+  else
+    cache->newest = s->older;
+}
+
+static void coopt_cache_lock(struct coopt_cache *cache)
+{
+  if (cache->lock!=NULL)
+    cache->lock(cache->lock_data);
+}
+
+static void coopt_cache_unlock(struct coopt_cache *cache)
+{
+  if (cache->unlock!=NULL)
+    cache->unlock(cache->lock_data);
+}
@@ -0,0 +1,90 @@
+/*
+ * $Id$
+ * classify.c
+ *
+ * Implementation of coopt_classify(), bulk classification pre-pass for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+
+/*
+ * We only look at the first byte of each element: it's a candidate if
+ * that byte could start the separator or any marker. That's the only
+ * part of the element we need to bring into cache, and it makes the
+ * whole pass a table lookup per element, with the map built up a word
+ * at a time.
+ */
+void coopt_classify(struct coopt_state *state, unsigned long *map)
+{
+  unsigned char candidate[256];
+  unsigned long word=0;
+  int i, all=0;
+
+  if (state==NULL)
+    return;
+
+  state->classmap = NULL;
+  state->classbase = NULL;
+  state->classcount = 0;
+  if (map==NULL || state->argv==NULL || state->markers==NULL
+      || state->argc<=0)
+    return;
+
+  for (i=0; i<256; i++)
+    candidate[i]=0;
+  if (state->separator!=NULL)
+    candidate[(unsigned char)state->separator[0]]=1;
+  for (i=0; state->markers[i]!=NULL; i++)
+  {
+    if (state->markers[i][0]==0 || state->markers[i][1]==0)
+      all=1; /* empty marker; everything's a candidate */
+    else
+      candidate[(unsigned char)state->markers[i][1]]=1;
+  }
+
+  for (i=0; i<state->argc; i++)
+  {
+    if (all || candidate[(unsigned char)state->argv[i][0]])
+      word |= 1UL<<(i%COOPT_CLASSMAP_BITS);
+    if ((i+1)%COOPT_CLASSMAP_BITS==0)
+    {
+      map[i/COOPT_CLASSMAP_BITS] = word;
+      word=0;
+    }
+  }
+  if (i%COOPT_CLASSMAP_BITS!=0)
+    map[i/COOPT_CLASSMAP_BITS] = word;
+
+  state->classmap = map;
+  state->classbase = state->argv;
+  state->classcount = state->argc;
+}
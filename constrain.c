@@ -0,0 +1,252 @@
+/*
+ * $Id$
+ * constrain.c
+ *
+ * Implementation of option constraints (conflicts, requirements and groups)
+ * for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+
+#define setbit(set, bit) \
+	((set)[(bit)/COOPT_CLASSMAP_BITS] |= 1UL<<((bit)%COOPT_CLASSMAP_BITS))
+
+static int coopt_constraints_bit(struct coopt_constraints *,
+				 struct coopt_option const *);
+static struct coopt_option const *coopt_constraints_first(
+	struct coopt_constraints *, unsigned long const *,
+	unsigned long const *, int, unsigned int);
+
+int coopt_constraints_init(struct coopt_constraints *constraints,
+			   struct coopt_constraint const *constraint,
+			   unsigned int num_constraints,
+			   struct coopt_option const *options,
+			   unsigned int num_options,
+			   unsigned long *space)
+{
+  unsigned int i, j;
+  unsigned long *set;
+
+  constraints->options = options;
+  constraints->num_options = num_options;
+  constraints->constraints = constraint;
+  constraints->num_constraints = num_constraints;
+  constraints->words = COOPT_CLASSMAP_WORDS(num_options);
+  constraints->seen = space;
+  constraints->sets = space + constraints->words;
+  constraints->next = 0;
+
+  for (i=0; i<COOPT_CONSTRAINTS_WORDS(num_options, num_constraints); i++)
+    space[i]=0;
+
+  for (i=0; i<num_constraints; i++)
+  {
+    int bit;
+    set = constraints->sets + 2*i*constraints->words;
+    if (constraint[i].option!=NULL)
+    {
+      bit = coopt_constraints_bit(constraints, constraint[i].option);
+      if (bit<0)
+	return -1;
+      setbit(set, bit);
+    }
+    set += constraints->words;
+    for (j=0; constraint[i].options!=NULL &&
+	      constraint[i].options[j]!=NULL; j++)
+    {
+      bit = coopt_constraints_bit(constraints, constraint[i].options[j]);
+      if (bit<0)
+	return -1;
+      setbit(set, bit);
+    }
+  }
+  return 0;
+}
+
+void coopt_constrain(struct coopt_state *state,
+		     struct coopt_constraints *constraints)
+{
+  state->constraints = constraints;
+  if (constraints!=NULL)
+  {
+    unsigned int i;
+    for (i=0; i<constraints->words; i++)
+      constraints->seen[i]=0;
+    constraints->next = 0;
+  }
+}
+
+void coopt_constraints_note(struct coopt_constraints *constraints,
+			    struct coopt_option const *opt)
+{
+  int bit = coopt_constraints_bit(constraints, opt);
+  if (bit>=0)
+    setbit(constraints->seen, bit);
+}
+
+/*
+ * Each check is a few passes over a constraint's bitsets, so with up to
+ * one word's worth of options, it's a handful of operations per
+ * constraint.
+ */
+struct coopt_return coopt_check(struct coopt_state *state)
+{
+  struct coopt_return result;
+  struct coopt_constraints *c;
+
+  result.result=COOPT_RESULT_END;
+  result.ambigresult=COOPT_RESULT_OKAY;
+  result.opt=NULL;
+  result.param=NULL;
+  result.marker=NULL;
+  result.related=NULL;
+
+  if (state==NULL || state->constraints==NULL)
+    return result;
+  c = state->constraints;
+
+  while (c->next < c->num_constraints)
+  {
+    struct coopt_constraint const *constraint = c->constraints + c->next;
+    unsigned long const *subject = c->sets + 2*c->next*c->words;
+    unsigned long const *group = subject + c->words;
+    unsigned int given=0, subject_given=0;
+    unsigned int w;
+    c->next++;
+
+    for (w=0; w<c->words; w++)
+    {
+      unsigned long g = group[w] & c->seen[w];
+      if (subject[w] & c->seen[w])
+	subject_given=1;
+      while (g!=0 && given<2)
+      {
+	g &= g-1; /* count up to two */
+	given++;
+      }
+    }
+
+    switch (constraint->type)
+    {
+     case COOPT_CONFLICTS:
+      if (constraint->option!=NULL)
+      {
+	if (subject_given && given>0)
+	{
+	  result.result = COOPT_RESULT_CONFLICT;
+	  result.opt = constraint->option;
+	  result.related = coopt_constraints_first(c, group, c->seen, 0, 0);
+	}
+	break;
+      }
+      /* at most one of the group, as below */
+      /* FALLTHROUGH */
+     case COOPT_ONE_OF:
+      if (given>1)
+      {
+	result.result = COOPT_RESULT_CONFLICT;
+	result.opt = coopt_constraints_first(c, group, c->seen, 0, 0);
+	result.related = coopt_constraints_first(c, group, c->seen, 0, 1);
+      }
+      else if (given==0 && constraint->type==COOPT_ONE_OF)
+      {
+	result.result = COOPT_RESULT_NONEOF;
+	result.opt = coopt_constraints_first(c, group, c->seen, 1, 0);
+	result.related = coopt_constraints_first(c, group, c->seen, 1, 1);
+      }
+      break;
+     case COOPT_ANY_OF:
+      if (given==0)
+      {
+	result.result = COOPT_RESULT_NONEOF;
+	result.opt = coopt_constraints_first(c, group, c->seen, 1, 0);
+	result.related = coopt_constraints_first(c, group, c->seen, 1, 1);
+      }
+      break;
+     case COOPT_REQUIRES:
+      if (subject_given)
+      {
+	result.related = coopt_constraints_first(c, group, c->seen, 1, 0);
+	if (result.related!=NULL)
+	{
+	  result.result = COOPT_RESULT_REQUIRES;
+	  result.opt = constraint->option;
+	}
+      }
+      break;
+     default:
+      result.result = COOPT_RESULT_ERROR;
+      return result;
+    }
+
+    if (result.result!=COOPT_RESULT_END)
+    {
+      /* so coopt_sopt() can display 'opt' */
+      if (result.opt!=NULL)
+	result.marker = coopt_marker_for(state, result.opt);
+      return result;
+    }
+  }
+  return result;
+}
+
+/*
+ * Which bit represents (opt), or -1 if it isn't one of ours.
+ */
+static int coopt_constraints_bit(struct coopt_constraints *constraints,
+				 struct coopt_option const *opt)
+{
+  if (opt < constraints->options ||
+      opt >= constraints->options + constraints->num_options)
+    return -1;
+  return opt - constraints->options;
+}
+
+/*
+ * The (skip)th option (counting from 0) in (set), restricted to those in
+ * (seen) or, if (missing) is set, to those not in (seen). NULL if there
+ * aren't that many.
+ */
+static struct coopt_option const *coopt_constraints_first(
+	struct coopt_constraints *constraints, unsigned long const *set,
+	unsigned long const *seen, int missing, unsigned int skip)
+{
+  unsigned int w, b;
+  for (w=0; w<constraints->words; w++)
+  {
+    unsigned long bits = set[w] & ((missing)?(~seen[w]):(seen[w]));
+    for (b=0; bits!=0; b++, bits>>=1)
+      if ((bits&1) && skip--==0)
+	return constraints->options + w*COOPT_CLASSMAP_BITS + b;
+  }
+  return NULL;
+}
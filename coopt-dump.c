@@ -0,0 +1,700 @@
+/*
+ * $Id$
+ * coopt-dump.c
+ *
+ * coopt-dump: parses command lines in bulk, writing what coopt() made of
+ * them in a columnar binary form or as JSON Lines.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Usage: coopt-dump [-0] [-j] [-o output] spec [input]
+ *
+ * Reads command lines from the input (standard input if there isn't one,
+ * or it's "-"), one to a line, or each ended by a NUL with -0. Each is
+ * split up as sh would (see coopt_tokenise()) and parsed with the options
+ * in the spec (see tools.c); as with argv, the first element is taken to
+ * be the program's name. Every command line gets an entry in the output,
+ * even if it's empty, so they can be matched up by position.
+ *
+ * One state and index are used for every command line, and elements are
+ * left where they were read; text is only copied into the output. Output
+ * is built up in large buffers, and written with a single fwrite() each.
+ *
+ * Each result has the result code, the option's position in the spec (or
+ * -1), and some text: the parameter or argument, or for BADOPTION and
+ * AMBIGUOUSOPT, the option as it was given (as coopt_sopt() has it, so
+ * without any parameter). A command line with an unclosed quote gets
+ * just an ERROR, and one with more than MAX_ELEMENTS elements a TOOMANY.
+ * END isn't included.
+ *
+ * With -j, each command line is written as a line of JSON:
+ *
+ *   {"line":1,"results":[{"result":"OKAY","option":"file","param":"x"},
+ *     {"result":"OKAY","argument":"a"},{"result":"BADOPTION","given":"-z"}]}
+ *
+ * where options are named by their long option, or failing that their
+ * short one. Text is written as it comes; it isn't checked for being
+ * UTF-8.
+ *
+ * Otherwise, the output is in blocks, with each column of a block stored
+ * together, and in this machine's byte order and sizes. It starts with
+ * unsigned longs: DUMP_MAGIC, DUMP_VERSION, DUMP_ORDER_MARK, sizeof(int),
+ * the number of options, and the size of their names; then the names of
+ * the options as above, each terminated by a NUL. Each block then has
+ * unsigned longs giving the number of command lines in it, the number of
+ * results, and the size of its text, then these columns:
+ *
+ *   int counts[command lines]	the number of results for each
+ *   int options[results]	position in the spec, or -1
+ *   int texts[results]		offset of the result's text, or -1
+ *   signed char results[results]
+ *   char text[]		NUL terminated strings
+ *
+ * The names and every column are padded with NULs to a multiple of
+ * sizeof(unsigned long).
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coopt.h"
+#include "tools.h"
+
+#define MAX_ELEMENTS 65536
+#define INPUT_SIZE (1<<20)
+#define OUTPUT_SIZE (1<<20)
+#define BLOCK_LINES 65536
+#define BLOCK_RESULTS (1<<18)
+#define BLOCK_TEXT (1<<22)
+
+#define DUMP_MAGIC	(0x504d4443UL) /* "CDMP" */
+#define DUMP_VERSION	(1)
+#define DUMP_ORDER_MARK	(0x01020304UL)
+
+#define PAD(n) (((n) + sizeof(unsigned long) - 1) & \
+		~(unsigned long)(sizeof(unsigned long) - 1))
+
+static char const *program = "coopt-dump";
+
+struct dump
+{
+  struct coopt_option *opts;
+  unsigned int num_opts;
+  struct coopt_index index;
+  struct coopt_state state;
+  char const **argv;
+  int json;
+  unsigned long line;
+  FILE *out;
+  int failed; /* non-zero once writing has gone wrong */
+
+  /* for JSON: the output, and each option's name as a JSON string */
+  char *buffer;
+  size_t used, size;
+  char **names;
+  unsigned long on_line; /* results written for this command line */
+  char *scratch; /* room for an unknown option */
+  size_t scratch_size;
+
+  /* for the binary form: the block being built up */
+  int *counts;
+  int *options;
+  int *texts;
+  signed char *results;
+  char *text;
+  unsigned long lines, max_lines;
+  unsigned long num, max_num;
+  unsigned long text_used, max_text;
+};
+
+static int dump_input(struct dump *, FILE *, int);
+static void dump_line(struct dump *, char *, size_t);
+static void dump_result(struct dump *, struct coopt_return *);
+static void reserve(struct dump *, unsigned long, unsigned long);
+static void *grow(void *, unsigned long);
+static void out_of_memory(void);
+static char *room(struct dump *, size_t);
+static void flush(struct dump *);
+static void write_header(struct dump *);
+static void write_padded(struct dump *, void const *, size_t);
+static size_t json_string(char *, char const *);
+static size_t json_number(char *, unsigned long);
+static char *json_name(struct coopt_option const *);
+
+/* What has to be escaped in JSON strings, and how (0 => \u00XX) */
+static char json_escape[256];
+
+int main(int argc, char const * const * argv)
+{
+  static struct coopt_option const options[] =
+  {
+    { '0', COOPT_NO_PARAM, "null", 0, 0 },
+    { 'j', COOPT_NO_PARAM, "json", 0, 0 },
+    { 'o', COOPT_REQUIRED_PARAM, "output", 0, 0 },
+  };
+  struct coopt_state state;
+  struct coopt_return ret;
+  char const *spec = NULL, *input = NULL, *output = NULL;
+  struct dump dump;
+  int delimiter = '\n';
+  int *space;
+  unsigned int i;
+  FILE *in;
+
+  memset(&dump, 0, sizeof(dump));
+  coopt_init(&state, options, 3, argc-1, argv+1);
+  for (;;)
+  {
+    ret = coopt(&state);
+    if (!coopt_is_okay(ret.result))
+      break;
+    if (ret.opt==NULL)
+    {
+      if (input!=NULL)
+      {
+	fprintf(stderr, "%s: only one spec and input, please\n", program);
+	return 1;
+      }
+      if (spec==NULL)
+	spec = ret.param;
+      else
+	input = ret.param;
+    }
+    else if (ret.opt->short_option=='0')
+      delimiter = 0;
+    else if (ret.opt->short_option=='j')
+      dump.json = 1;
+    else
+      output = ret.param;
+  }
+  if (coopt_is_error(ret.result) || spec==NULL)
+  {
+    if (coopt_is_error(ret.result))
+    {
+      char buffer[256];
+      coopt_serror(buffer, 256, &ret, &state);
+      fprintf(stderr, "%s: %s\n", program, buffer);
+    }
+    fprintf(stderr, "usage: %s [-0] [-j] [-o output] spec [input]\n",
+	    program);
+    return 1;
+  }
+
+  if ((in = fopen(spec, "r"))==NULL)
+  {
+    fprintf(stderr, "%s: can't open %s\n", program, spec);
+    return 1;
+  }
+  if (spec_read(in, spec, program, &dump.opts, &dump.num_opts)!=0)
+    return 1;
+  fclose(in);
+  space = (int *)malloc(COOPT_INDEX_SIZE(dump.num_opts) * sizeof(int));
+  dump.argv = (char const **)malloc(MAX_ELEMENTS * sizeof(char const *));
+  if (space==NULL || dump.argv==NULL)
+    out_of_memory();
+  spec_index(&dump.index, dump.opts, dump.num_opts, space);
+
+  if (dump.json)
+  {
+    for (i=0; i<32; i++)
+      json_escape[i] = 0;
+    json_escape['\b'] = 'b';
+    json_escape['\f'] = 'f';
+    json_escape['\n'] = 'n';
+    json_escape['\r'] = 'r';
+    json_escape['\t'] = 't';
+    for (i=32; i<256; i++)
+      json_escape[i] = 1;
+    json_escape['"'] = '"';
+    json_escape['\\'] = '\\';
+    dump.names = (char **)malloc((dump.num_opts+1) * sizeof(char *));
+    dump.size = OUTPUT_SIZE;
+    dump.buffer = (char *)malloc(dump.size);
+    for (i=0; dump.names!=NULL && i<dump.num_opts; i++)
+    {
+      if ((dump.names[i] = json_name(dump.opts + i))==NULL)
+	dump.names = NULL;
+    }
+  }
+  else
+  {
+    dump.max_lines = BLOCK_LINES;
+    dump.max_num = BLOCK_RESULTS;
+    dump.max_text = BLOCK_TEXT;
+    dump.counts = (int *)malloc(dump.max_lines * sizeof(int));
+    dump.options = (int *)malloc(dump.max_num * sizeof(int));
+    dump.texts = (int *)malloc(dump.max_num * sizeof(int));
+    dump.results = (signed char *)malloc(dump.max_num);
+    dump.text = (char *)malloc(dump.max_text);
+  }
+  if ((dump.json && (dump.names==NULL || dump.buffer==NULL)) ||
+      (!dump.json && (dump.counts==NULL || dump.options==NULL ||
+		      dump.texts==NULL || dump.results==NULL ||
+		      dump.text==NULL)))
+    out_of_memory();
+
+  if (output==NULL || strcmp(output, "-")==0)
+  {
+    dump.out = stdout;
+    output = "standard output";
+  }
+  else if ((dump.out = fopen(output, "wb"))==NULL)
+  {
+    fprintf(stderr, "%s: can't write %s\n", program, output);
+    return 1;
+  }
+  if (input==NULL || strcmp(input, "-")==0)
+  {
+    in = stdin;
+    input = "standard input";
+  }
+  else if ((in = fopen(input, "rb"))==NULL)
+  {
+    fprintf(stderr, "%s: can't open %s\n", program, input);
+    return 1;
+  }
+
+  if (!dump.json)
+    write_header(&dump);
+  if (dump_input(&dump, in, delimiter)!=0)
+  {
+    fprintf(stderr, "%s: can't read %s\n", program, input);
+    return 1;
+  }
+  flush(&dump);
+  if (dump.failed || fflush(dump.out)!=0 ||
+      (dump.out!=stdout && fclose(dump.out)!=0))
+  {
+    fprintf(stderr, "%s: error writing %s\n", program, output);
+    return 1;
+  }
+  return 0;
+}
+
+/*
+ * Read the input in large pieces, handing each complete command line to
+ * dump_line() where it lies; only an incomplete one at the end of a piece
+ * is moved, to the start of the buffer. Returns non-zero on error.
+ */
+static int dump_input(struct dump *dump, FILE *in, int delimiter)
+{
+  size_t size = INPUT_SIZE, have = 0, start, got;
+  char *buffer = (char *)grow(NULL, size), *end;
+
+  for (;;)
+  {
+    /* a command line filling the buffer needs a bigger one */
+    if (have+1 >= size)
+    {
+      size *= 2;
+      buffer = (char *)grow(buffer, size);
+    }
+    got = fread(buffer + have, 1, size - have - 1, in);
+    have += got;
+    start = 0;
+    while ((end = (char *)memchr(buffer + start, delimiter,
+				 have - start))!=NULL)
+    {
+      *end = 0;
+      dump_line(dump, buffer + start, end - (buffer + start));
+      start = end + 1 - buffer;
+    }
+    if (got==0)
+    {
+      if (ferror(in))
+	return 1;
+      if (start<have)
+      {
+	buffer[have] = 0;
+	dump_line(dump, buffer + start, have - start);
+      }
+      free(buffer);
+      return 0;
+    }
+    memmove(buffer, buffer + start, have - start);
+    have -= start;
+  }
+}
+
+/* Parse one command line, 'len' long, and add what coopt() made of it */
+static void dump_line(struct dump *dump, char *line, size_t len)
+{
+  int argc = coopt_tokenise(line, dump->argv, MAX_ELEMENTS);
+  struct coopt_return ret;
+  char *o;
+
+  dump->line++;
+  /*
+   * Every result takes at least a character of the line, and has at most
+   * three bytes of text for each (a marker, a short option and a NUL);
+   * each element might need a NUL of its own as well
+   */
+  reserve(dump, len+2, 4*len+8);
+  if (dump->json)
+  {
+    dump->on_line = 0;
+    o = room(dump, 40);
+    memcpy(o, "{\"line\":", 8);
+    o += 8;
+    o += json_number(o, dump->line);
+    memcpy(o, ",\"results\":[", 12);
+    dump->used = o+12 - dump->buffer;
+  }
+  else
+    dump->counts[dump->lines] = 0;
+
+  ret.opt = NULL;
+  ret.param = NULL;
+  ret.marker = NULL;
+  ret.result = COOPT_RESULT_OKAY;
+  if (argc<0 || argc>MAX_ELEMENTS)
+  {
+    ret.result = (argc<0)?(COOPT_RESULT_ERROR):(COOPT_RESULT_TOOMANY);
+    dump_result(dump, &ret);
+  }
+  else if (argc>0)
+  {
+    coopt_init(&dump->state, dump->opts, dump->num_opts, argc-1,
+	       dump->argv+1);
+    coopt_use_index(&dump->state, &dump->index);
+    for (;;)
+    {
+      ret = coopt(&dump->state);
+      if (ret.result==COOPT_RESULT_END)
+	break;
+      dump_result(dump, &ret);
+      if (coopt_is_fatal(ret.result) || coopt_is_termination(ret.result))
+	break;
+    }
+  }
+
+  if (dump->json)
+  {
+    o = room(dump, 3);
+    memcpy(o, "]}\n", 3);
+    dump->used = o+3 - dump->buffer;
+  }
+  else
+    dump->lines++;
+}
+
+static void dump_result(struct dump *dump, struct coopt_return *ret)
+{
+  int option = (ret->opt==NULL)?(-1):(int)(ret->opt - dump->opts);
+  int unknown = (ret->result==COOPT_RESULT_BADOPTION ||
+		 ret->result==COOPT_RESULT_AMBIGUOUSOPT);
+  char const *text = ret->param;
+
+  if (unknown)
+  {
+    /* reserve() made sure there's room for this in text */
+    char *to = (dump->json)?(dump->scratch):(dump->text + dump->text_used);
+    coopt_sopt(to, (dump->json)?(dump->scratch_size):
+				 (dump->max_text - dump->text_used),
+	       ret, 1, &dump->state);
+    text = to;
+  }
+
+  if (dump->json)
+  {
+    char const *result = result_name(ret->result);
+    size_t len = strlen(result);
+    char *o = room(dump, len+20);
+
+    if (dump->on_line++ > 0)
+      *o++ = ',';
+    memcpy(o, "{\"result\":\"", 11);
+    memcpy(o+11, result, len);
+    o[11+len] = '"';
+    dump->used = o+12+len - dump->buffer;
+    if (option>=0)
+    {
+      len = strlen(dump->names[option]);
+      o = room(dump, len+10);
+      memcpy(o, ",\"option\":", 10);
+      memcpy(o+10, dump->names[option], len);
+      dump->used = o+10+len - dump->buffer;
+    }
+    if (text!=NULL)
+    {
+      o = room(dump, 6*strlen(text)+16);
+      if (unknown)
+      {
+	memcpy(o, ",\"given\":", 9);
+	o += 9;
+      }
+      else if (option>=0)
+      {
+	memcpy(o, ",\"param\":", 9);
+	o += 9;
+      }
+      else
+      {
+	memcpy(o, ",\"argument\":", 12);
+	o += 12;
+      }
+      o += json_string(o, text);
+      dump->used = o - dump->buffer;
+    }
+    o = room(dump, 1);
+    *o = '}';
+    dump->used++;
+    return;
+  }
+
+  dump->options[dump->num] = option;
+  dump->results[dump->num] = (signed char)ret->result;
+  if (text==NULL)
+    dump->texts[dump->num] = -1;
+  else
+  {
+    size_t len = strlen(text) + 1;
+    dump->texts[dump->num] = (int)dump->text_used;
+    if (!unknown)
+      memcpy(dump->text + dump->text_used, text, len);
+    dump->text_used += len;
+  }
+  dump->num++;
+  dump->counts[dump->lines]++;
+}
+
+/*
+ * Make sure a command line giving up to 'results' results with 'text'
+ * bytes of text will fit: for JSON, in the scratch space for unknown
+ * options, and otherwise in the block (writing out the one being built,
+ * or failing that growing the columns, if they're full).
+ */
+static void reserve(struct dump *dump, unsigned long results,
+		    unsigned long text)
+{
+  if (dump->json)
+  {
+    if (dump->scratch_size < text)
+    {
+      dump->scratch_size = text;
+      dump->scratch = (char *)grow(dump->scratch, text);
+    }
+    return;
+  }
+
+  if (dump->lines==dump->max_lines || dump->max_num - dump->num < results ||
+      dump->max_text - dump->text_used < text)
+    flush(dump);
+  if (dump->max_num < results)
+  {
+    while (dump->max_num < results)
+      dump->max_num *= 2;
+    dump->options = (int *)grow(dump->options, dump->max_num * sizeof(int));
+    dump->texts = (int *)grow(dump->texts, dump->max_num * sizeof(int));
+    dump->results = (signed char *)grow(dump->results, dump->max_num);
+  }
+  if (dump->max_text < text)
+  {
+    while (dump->max_text < text)
+      dump->max_text *= 2;
+    dump->text = (char *)grow(dump->text, dump->max_text);
+  }
+}
+
+/* realloc(), giving up if there isn't the memory */
+static void *grow(void *p, unsigned long size)
+{
+  if ((p = realloc(p, size))==NULL)
+    out_of_memory();
+  return p;
+}
+
+static void out_of_memory(void)
+{
+  fprintf(stderr, "%s: out of memory\n", program);
+  exit(1);
+}
+
+/* Where 'n' bytes of JSON can be written, writing out what's there first */
+static char *room(struct dump *dump, size_t n)
+{
+  if (dump->size - dump->used < n)
+  {
+    flush(dump);
+    if (dump->size < n)
+    {
+      while (dump->size < n)
+	dump->size *= 2;
+      dump->buffer = (char *)grow(dump->buffer, dump->size);
+    }
+  }
+  return dump->buffer + dump->used;
+}
+
+/* Write out the JSON so far, or the block being built up */
+static void flush(struct dump *dump)
+{
+  unsigned long header[3];
+
+  if (dump->json)
+  {
+    if (dump->used>0 && fwrite(dump->buffer, 1, dump->used, dump->out)!=
+	dump->used)
+      dump->failed = 1;
+    dump->used = 0;
+    return;
+  }
+
+  if (dump->lines==0)
+    return;
+  header[0] = dump->lines;
+  header[1] = dump->num;
+  header[2] = dump->text_used;
+  write_padded(dump, header, sizeof(header));
+  write_padded(dump, dump->counts, dump->lines * sizeof(int));
+  write_padded(dump, dump->options, dump->num * sizeof(int));
+  write_padded(dump, dump->texts, dump->num * sizeof(int));
+  write_padded(dump, dump->results, dump->num);
+  write_padded(dump, dump->text, dump->text_used);
+  dump->lines = dump->num = dump->text_used = 0;
+}
+
+static void write_header(struct dump *dump)
+{
+  unsigned long header[6];
+  unsigned int i;
+  size_t size = 0;
+  char *names, *p;
+
+  for (i=0; i<dump->num_opts; i++)
+  {
+    if (dump->opts[i].long_option!=NULL)
+      size += strlen(dump->opts[i].long_option) + 1;
+    else
+      size += 2;
+  }
+  if ((names = p = (char *)malloc(size+1))==NULL)
+    out_of_memory();
+  for (i=0; i<dump->num_opts; i++)
+  {
+    if (dump->opts[i].long_option!=NULL)
+    {
+      strcpy(p, dump->opts[i].long_option);
+      p += strlen(p) + 1;
+    }
+    else
+    {
+      *p++ = dump->opts[i].short_option;
+      *p++ = 0;
+    }
+  }
+  header[0] = DUMP_MAGIC;
+  header[1] = DUMP_VERSION;
+  header[2] = DUMP_ORDER_MARK;
+  header[3] = sizeof(int);
+  header[4] = dump->num_opts;
+  header[5] = size;
+  write_padded(dump, header, sizeof(header));
+  write_padded(dump, names, size);
+  free(names);
+}
+
+static void write_padded(struct dump *dump, void const *p, size_t size)
+{
+  static unsigned long const zero = 0;
+
+  if (size>0 && fwrite(p, 1, size, dump->out)!=size)
+    dump->failed = 1;
+  if (PAD(size)!=size &&
+      fwrite(&zero, 1, PAD(size)-size, dump->out)!=PAD(size)-size)
+    dump->failed = 1;
+}
+
+/* Write 's' as a JSON string, returning its length; this can be 6x 's' */
+static size_t json_string(char *out, char const *s)
+{
+  static char const hex[] = "0123456789abcdef";
+  char *o = out;
+  unsigned char c;
+
+  *o++ = '"';
+  while ((c = (unsigned char)*s++)!=0)
+  {
+    if (json_escape[c]==1)
+      *o++ = (char)c;
+    else if (json_escape[c]==0)
+    {
+      memcpy(o, "\\u00", 4);
+      o[4] = hex[c>>4];
+      o[5] = hex[c&15];
+      o += 6;
+    }
+    else
+    {
+      o[0] = '\\';
+      o[1] = json_escape[c];
+      o += 2;
+    }
+  }
+  *o++ = '"';
+  return o - out;
+}
+
+static size_t json_number(char *out, unsigned long n)
+{
+  char digits[24];
+  size_t i = 0, len;
+
+  do
+  {
+    digits[i++] = (char)('0' + n%10);
+    n /= 10;
+  }
+  while (n>0);
+  len = i;
+  while (i>0)
+    *out++ = digits[--i];
+  return len;
+}
+
+/* An option's name as a JSON string, malloc()ed */
+static char *json_name(struct coopt_option const *opt)
+{
+  char shortname[2];
+  char const *name = opt->long_option;
+  char *s;
+
+  if (name==NULL)
+  {
+    shortname[0] = opt->short_option;
+    shortname[1] = 0;
+    name = shortname;
+  }
+  if ((s = (char *)malloc(6*strlen(name) + 3))!=NULL)
+    s[json_string(s, name)] = 0;
+  return s;
+}
@@ -0,0 +1,328 @@
+/*
+ * $Id$
+ * coopt-gen.c
+ *
+ * coopt-gen: generates C option tables, with a compiled index, from an
+ * option spec, so that coopt needs no setup at run time.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The spec is described in tools.c.
+ *
+ * Usage: coopt-gen [-n name] [-o output.c] [-H output.h] [-i image] [spec]
+ *
+ * This writes <name>_options[] and <name>_index, the latter having been
+ * built with a seed that gives every long option its own hash slot. With
+ * -i, it writes a binary image of the index instead (see image.c), unless
+ * you also ask for C with -o.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "coopt.h"
+#include "tools.h"
+
+/* Attributes, by bit, as they're written in C */
+static char const * const attributes_c[SPEC_NUM_ATTRIBUTES] =
+{
+  "COOPT_UNORDERED", "COOPT_SCOPE_OPEN", "COOPT_SCOPE_CLOSE"
+};
+
+static char const *program = "coopt-gen";
+
+static void write_string(FILE *, char const *);
+static void write_char(FILE *, char);
+static void write_attributes(FILE *, unsigned int);
+static void write_ints(FILE *, char const *, char const *, int const *,
+		       unsigned int);
+static void write_source(FILE *, char const *, char const *,
+			 struct coopt_index const *, int);
+static void write_header(FILE *, char const *, unsigned int);
+
+int main(int argc, char const * const * argv)
+{
+  static struct coopt_option const options[] =
+  {
+    { 'n', COOPT_REQUIRED_PARAM, "name", 0, 0 },
+    { 'o', COOPT_REQUIRED_PARAM, "output", 0, 0 },
+    { 'H', COOPT_REQUIRED_PARAM, "header", 0, 0 },
+    { 'i', COOPT_REQUIRED_PARAM, "image", 0, 0 },
+  };
+  struct coopt_state state;
+  struct coopt_return ret;
+  char const *name = "coopt", *output = NULL, *header = NULL;
+  char const *image = NULL;
+  char const *spec = NULL;
+  struct coopt_option *opts;
+  unsigned int num_opts;
+  struct coopt_index index;
+  int *space;
+  int best;
+  FILE *in, *out;
+
+  coopt_init(&state, options, 4, argc-1, argv+1);
+  for (;;)
+  {
+    ret = coopt(&state);
+    if (!coopt_is_okay(ret.result))
+      break;
+    if (ret.opt==NULL)
+    {
+      if (spec!=NULL)
+      {
+	fprintf(stderr, "%s: only one spec, please\n", program);
+	return 1;
+      }
+      spec = ret.param;
+    }
+    else if (ret.opt->short_option=='n')
+      name = ret.param;
+    else if (ret.opt->short_option=='o')
+      output = ret.param;
+    else if (ret.opt->short_option=='i')
+      image = ret.param;
+    else
+      header = ret.param;
+  }
+  if (coopt_is_error(ret.result))
+  {
+    char buffer[256];
+    coopt_serror(buffer, 256, &ret, &state);
+    fprintf(stderr, "%s: %s\n", program, buffer);
+    fprintf(stderr, "usage: %s [-n name] [-o output.c] [-H output.h] "
+	    "[-i image] [spec]\n", program);
+    return 1;
+  }
+
+  if (spec==NULL || strcmp(spec, "-")==0)
+  {
+    in = stdin;
+    spec = "standard input";
+  }
+  else if ((in = fopen(spec, "r"))==NULL)
+  {
+    fprintf(stderr, "%s: can't open %s\n", program, spec);
+    return 1;
+  }
+  if (spec_read(in, spec, program, &opts, &num_opts)!=0)
+    return 1;
+  if (in!=stdin)
+    fclose(in);
+
+  space = (int *)malloc(COOPT_INDEX_SIZE(num_opts) * sizeof(int));
+  if (space==NULL)
+  {
+    fprintf(stderr, "%s: out of memory\n", program);
+    return 1;
+  }
+  best = spec_index(&index, opts, num_opts, space);
+
+  if (image!=NULL)
+  {
+    size_t size = coopt_image_write(&index, NULL, 0);
+    void *buffer = malloc(size);
+    if (buffer==NULL)
+    {
+      fprintf(stderr, "%s: out of memory\n", program);
+      return 1;
+    }
+    coopt_image_write(&index, buffer, size);
+    if ((out = fopen(image, "wb"))==NULL)
+    {
+      fprintf(stderr, "%s: can't write %s\n", program, image);
+      return 1;
+    }
+    if (fwrite(buffer, 1, size, out)!=size || fclose(out)!=0)
+    {
+      fprintf(stderr, "%s: error writing %s\n", program, image);
+      return 1;
+    }
+    free(buffer);
+  }
+
+  if (image==NULL || output!=NULL)
+  {
+    if (output==NULL)
+      out = stdout;
+    else if ((out = fopen(output, "w"))==NULL)
+    {
+      fprintf(stderr, "%s: can't write %s\n", program, output);
+      return 1;
+    }
+    write_source(out, spec, name, &index, best);
+    if (out!=stdout && fclose(out)!=0)
+    {
+      fprintf(stderr, "%s: error writing %s\n", program, output);
+      return 1;
+    }
+  }
+
+  if (header!=NULL)
+  {
+    if ((out = fopen(header, "w"))==NULL)
+    {
+      fprintf(stderr, "%s: can't write %s\n", program, header);
+      return 1;
+    }
+    write_header(out, name, num_opts);
+    if (fclose(out)!=0)
+    {
+      fprintf(stderr, "%s: error writing %s\n", program, header);
+      return 1;
+    }
+  }
+  return 0;
+}
+
+static void write_source(FILE *out, char const *spec, char const *name,
+			 struct coopt_index const *index, int displaced)
+{
+  unsigned int i;
+
+  fprintf(out, "/*\n * Generated by coopt-gen from %s; don't edit.\n", spec);
+  if (displaced>0)
+    fprintf(out, " * (%i long options share hash slots.)\n", displaced);
+  fprintf(out, " */\n\n#include \"coopt.h\"\n\n");
+
+  fprintf(out, "struct coopt_option const %s_options[%u] =\n{\n", name,
+	  (index->num_options>0)?(index->num_options):(1));
+  for (i=0; i<index->num_options; i++)
+  {
+    struct coopt_option const *o = index->options + i;
+    fprintf(out, "  { ");
+    write_char(out, o->short_option);
+    fprintf(out, ", %s, ", (o->has_param==COOPT_REQUIRED_PARAM)?
+	    ("COOPT_REQUIRED_PARAM"):("COOPT_NO_PARAM"));
+    write_string(out, o->long_option);
+    fprintf(out, ", 0, ");
+    write_attributes(out, o->attributes);
+    fprintf(out, " },\n");
+  }
+  if (index->num_options==0)
+    fprintf(out, "  { 0, COOPT_NO_PARAM, 0, 0, 0 }\n");
+  fprintf(out, "};\n\n");
+
+  write_ints(out, name, "table", index->table, index->mask+1);
+  write_ints(out, name, "lengths", index->lengths, index->num_options);
+  write_ints(out, name, "sorted", index->sorted, index->num_sorted);
+  write_ints(out, name, "prefixes", index->prefixes, index->num_sorted);
+  write_ints(out, name, "firsts", index->firsts, index->num_sorted);
+
+  fprintf(out, "struct coopt_index const %s_index =\n{\n", name);
+  fprintf(out, "  %s_options, %u,\n  {", name, index->num_options);
+  for (i=0; i<256; i++)
+    fprintf(out, "%s%i%s", (i%16==0)?("\n    "):(""), index->short_map[i],
+	    (i==255)?(""):((i%16==15)?(","):(", ")));
+  fprintf(out, "\n  },\n");
+  fprintf(out, "  %s_table, %luUL, %luUL,\n", name, index->mask, index->seed);
+  fprintf(out, "  %s_lengths, %s_sorted, %u, %s_prefixes, %s_firsts\n};\n",
+	  name, name, index->num_sorted, name, name);
+}
+
+static void write_header(FILE *out, char const *name, unsigned int num)
+{
+  fprintf(out, "/*\n * Generated by coopt-gen; don't edit.\n */\n\n");
+  fprintf(out, "#ifndef %s_OPTIONS_H\n#define %s_OPTIONS_H\n\n", name, name);
+  fprintf(out, "#include \"coopt.h\"\n\n");
+  fprintf(out, "#define %s_NUM_OPTIONS (%u)\n\n", name, num);
+  fprintf(out, "extern struct coopt_option const %s_options[];\n", name);
+  fprintf(out, "extern struct coopt_index const %s_index;\n", name);
+  fprintf(out, "\n#endif\n");
+}
+
+/* Write attributes as the macros or-ed together, or 0 */
+static void write_attributes(FILE *out, unsigned int attributes)
+{
+  unsigned int a;
+  char const *sep = "";
+
+  if (attributes==0)
+    fprintf(out, "0");
+  for (a=0; a<SPEC_NUM_ATTRIBUTES; a++)
+  {
+    if (attributes & (1U<<a))
+    {
+      fprintf(out, "%s%s", sep, attributes_c[a]);
+      sep = "|";
+    }
+  }
+}
+
+/*
+ * Write an array of ints; we always write at least one, as C doesn't
+ * allow empty arrays.
+ */
+static void write_ints(FILE *out, char const *name, char const *what,
+		       int const *ints, unsigned int n)
+{
+  unsigned int i;
+  fprintf(out, "static int const %s_%s[%u] =\n{", name, what,
+	  (n>0)?(n):(1));
+  for (i=0; i<n; i++)
+    fprintf(out, "%s%i%s", (i%16==0)?("\n  "):(""), ints[i],
+	    (i+1==n)?(""):((i%16==15)?(","):(", ")));
+  if (n==0)
+    fprintf(out, "\n  0");
+  fprintf(out, "\n};\n\n");
+}
+
+static void write_string(FILE *out, char const *s)
+{
+  if (s==NULL)
+  {
+    fprintf(out, "0");
+    return;
+  }
+  fputc('"', out);
+  for (; *s!=0; s++)
+  {
+    if (*s=='"' || *s=='\\')
+      fprintf(out, "\\%c", *s);
+    else if (isprint((unsigned char)*s))
+      fputc(*s, out);
+    else
+      fprintf(out, "\\%03o", (unsigned char)*s);
+  }
+  fputc('"', out);
+}
+
+static void write_char(FILE *out, char c)
+{
+  if (c=='\'' || c=='\\')
+    fprintf(out, "'\\%c'", c);
+  else if (c!=0 && isprint((unsigned char)c))
+    fprintf(out, "'%c'", c);
+  else
+    fprintf(out, "%i", c);
+}
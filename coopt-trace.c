@@ -0,0 +1,217 @@
+/*
+ * $Id$
+ * coopt-trace.c
+ *
+ * coopt-trace: prints a trace saved with coopt_trace_write(), as a list of
+ * events or as folded stacks for a flame graph.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Usage: coopt-trace [-f] [trace]
+ *
+ * Reads the trace (from standard input if there's no file, or it's "-"),
+ * which has to have been written on a machine like this one. Normally
+ * each event is printed on a line of its own, with the cycles since the
+ * first. With -f, it writes instead a line for each event in the form
+ * flamegraph.pl reads, "element N;what count", where the count is the
+ * cycles until the next event; use flamegraph.pl --flamechart to keep
+ * them in order, as a timeline.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coopt.h"
+#include "tools.h"
+
+#define READ_CHUNK 65536
+
+static char const *program = "coopt-trace";
+
+static void *read_all(FILE *, size_t *);
+static double event_time(struct coopt_trace_event const *);
+static void describe(char *, struct coopt_trace_event const *);
+
+int main(int argc, char const * const * argv)
+{
+  static struct coopt_option const options[] =
+  {
+    { 'f', COOPT_NO_PARAM, "flame", 0, 0 },
+  };
+  struct coopt_state state;
+  struct coopt_return ret;
+  struct coopt_trace_event const *events;
+  char const *file = NULL;
+  char what[64];
+  int flame = 0, n, i;
+  double start;
+  size_t size;
+  void *buffer;
+  FILE *in;
+
+  coopt_init(&state, options, 1, argc-1, argv+1);
+  for (;;)
+  {
+    ret = coopt(&state);
+    if (!coopt_is_okay(ret.result))
+      break;
+    if (ret.opt==NULL)
+    {
+      if (file!=NULL)
+      {
+	fprintf(stderr, "%s: only one trace, please\n", program);
+	return 1;
+      }
+      file = ret.param;
+    }
+    else
+      flame = 1;
+  }
+  if (coopt_is_error(ret.result))
+  {
+    char buf[256];
+    coopt_serror(buf, 256, &ret, &state);
+    fprintf(stderr, "%s: %s\n", program, buf);
+    fprintf(stderr, "usage: %s [-f] [trace]\n", program);
+    return 1;
+  }
+
+  if (file==NULL || strcmp(file, "-")==0)
+  {
+    in = stdin;
+    file = "standard input";
+  }
+  else if ((in = fopen(file, "rb"))==NULL)
+  {
+    fprintf(stderr, "%s: can't open %s\n", program, file);
+    return 1;
+  }
+  buffer = read_all(in, &size);
+  if (in!=stdin)
+    fclose(in);
+  if (buffer==NULL)
+  {
+    fprintf(stderr, "%s: can't read %s\n", program, file);
+    return 1;
+  }
+  n = coopt_trace_events(buffer, size, &events);
+  if (n<0)
+  {
+    fprintf(stderr, "%s: %s isn't a trace from this sort of machine\n",
+	    program, file);
+    return 1;
+  }
+
+  start = (n>0)?(event_time(events)):(0);
+  for (i=0; i<n; i++)
+  {
+    describe(what, events+i);
+    if (flame)
+    {
+      /* the last event has nothing to measure to */
+      if (i+1<n)
+	printf("element %i;%s %.0f\n", events[i].element, what,
+	       event_time(events+i+1) - event_time(events+i));
+    }
+    else
+      printf("%12.0f %5i:%-4i %s\n", event_time(events+i) - start,
+	     events[i].element, events[i].offset, what);
+  }
+  free(buffer);
+  return 0;
+}
+
+/* The whole of (in), in memory suitably aligned for the events */
+static void *read_all(FILE *in, size_t *size)
+{
+  size_t space = READ_CHUNK, got;
+  char *buffer = (char *)malloc(space), *more;
+
+  *size = 0;
+  while (buffer!=NULL)
+  {
+    got = fread(buffer + *size, 1, space - *size, in);
+    *size += got;
+    if (*size<space)
+      return ferror(in)?(free(buffer), (void *)NULL):(buffer);
+    more = (char *)realloc(buffer, space*2);
+    if (more==NULL)
+      free(buffer);
+    buffer = more;
+    space *= 2;
+  }
+  return NULL;
+}
+
+static double event_time(struct coopt_trace_event const *e)
+{
+  return e->time_hi*4294967296.0 + e->time_lo;
+}
+
+static void describe(char *what, struct coopt_trace_event const *e)
+{
+  switch (e->kind)
+  {
+   case COOPT_TRACE_MARKER:
+    if (e->detail<0)
+      strcpy(what, "argument");
+    else
+      sprintf(what, "marker %i", e->detail);
+    break;
+   case COOPT_TRACE_SEPARATOR:
+    strcpy(what, "separator");
+    break;
+   case COOPT_TRACE_SHORT:
+   case COOPT_TRACE_LONG:
+    if (e->kind==COOPT_TRACE_SHORT)
+      sprintf(what, "short '%c' ", (e->detail>32 && e->detail<127)?
+				     (e->detail):('?'));
+    else
+      sprintf(what, "long length %i ", e->detail);
+    if (e->option<0)
+      strcat(what, "not found");
+    else
+      sprintf(what+strlen(what), "option %i", e->option);
+    break;
+   case COOPT_TRACE_SKIP:
+    strcpy(what, (e->detail)?("skip next"):("skipped"));
+    break;
+   case COOPT_TRACE_RESULT:
+    sprintf(what, "result %s", result_name(e->detail));
+    if (e->option>=0)
+      sprintf(what+strlen(what), " option %i", e->option);
+    break;
+   default:
+    sprintf(what, "unknown event %i", e->kind);
+    break;
+  }
+}
@@ -41,19 +41,42 @@
  * I'm no longer positive what this means ... ?
  */
 
-#include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
 #include "coopt.h"
+#include "coopt_string.h"
 
 /* Some utility routines we'll use later */
+static struct coopt_return coopt_next(struct coopt_state *);
 static struct coopt_return coopt_shortopt(struct coopt_state *);
+static int coopt_marker(struct coopt_state *, char const *, char const **);
+static void coopt_advance(struct coopt_state *, int, int);
 static char *coopt_strstarts(char const *, char const *);
 static char *coopt_strnstarts(char const *, char const *, size_t);
+static void coopt_namespace(struct coopt_state *, char const *,
+			    struct coopt_namespace *);
+static struct coopt_option const *coopt_find_long(struct coopt_state *,
+						  struct coopt_namespace const *,
+						  char const *, unsigned int,
+						  int *);
+static unsigned int coopt_find_short(struct coopt_namespace const *, char);
+static int coopt_too_long(struct coopt_state *, struct coopt_return *, int);
 
-#ifndef HAVE_STRSTR
-char *strstr(char const *, char const *);
-#endif
+/* The default markers: "--" for long options, "-" for short */
+static char const * const coopt_default_markers[] = { "L--", "S-", NULL };
+
+/* Write a trace event; only a test if we aren't tracing */
+#define coopt_traced(state, kind, option, detail) \
+	((state)->trace==NULL ? (void)0 : \
+	 coopt_trace_note((state), (kind), (option), (detail)))
+
+/* Is (element) longer than state->max_length? Looks no further than that */
+#define coopt_over_length(state, element) \
+	((state)->max_length!=0 && \
+	 coopt_memchr((element), 0, (state)->max_length+1)==NULL)
+
+/* Can we use the namespace's index? */
+#define coopt_indexed(ns) \
+	((ns)->index!=NULL && (ns)->index->options==(ns)->options && \
+	 (ns)->index->num_options==(ns)->num_options)
 
 /*
  * Initialise the coopt_state structure to (a) the user setup, and
@@ -64,7 +87,6 @@ void coopt_init(struct coopt_state *state,
 		unsigned int num_options,
 		int argc, char const * const * argv)
 {
-  char const **markers;
   state->options = options;
   state->num_options = num_options;
 
@@ -72,7 +94,25 @@ void coopt_init(struct coopt_state *state,
   state->argv = argv;
   state->char_within_arg = 0;
   state->skip_next_arg = 0;
+  state->passthrough = 0;
   state->last_marker = NULL;
+  state->classmap = NULL;
+  state->classbase = NULL;
+  state->classcount = 0;
+  state->permutation = NULL;
+  state->permbase = NULL;
+  state->perm_options = 0;
+  state->perm_arguments = 0;
+  state->perm_size = 0;
+  state->constraints = NULL;
+  state->parsed = NULL;
+  state->diagnostics = NULL;
+  state->trace = NULL;
+  state->index = NULL;
+  state->namespaces = NULL;
+  state->max_length = 0;
+  state->max_results = 0;
+  state->num_results = 0;
 
   state->flags.allow_mix_short_params = 0;
   state->flags.allow_long_eq_params = 1;
@@ -80,22 +120,55 @@ void coopt_init(struct coopt_state *state,
   state->flags.allow_long_opts_breved = 0;
   state->separator = "--";
   state->long_eq = "=";
+  state->markers = coopt_default_markers;
+}
 
-  markers=(char const **)malloc(3*sizeof(char *));
-  if (markers!=NULL)
+/*
+ * Process the next option, and note it down for anything that's
+ * watching.
+ */
+
+struct coopt_return coopt(struct coopt_state * state)
+{
+  struct coopt_return result;
+
+  do
   {
-    markers[0]="L--";
-    markers[1]="S-";
-    markers[2]=NULL;
+    if (state!=NULL && state->max_results!=0 &&
+	state->num_results>=state->max_results)
+    {
+      result.result=COOPT_RESULT_TOOMANY;
+      result.ambigresult=COOPT_RESULT_OKAY;
+      result.opt=NULL;
+      result.param=NULL;
+      result.marker=NULL;
+      result.related=NULL;
+      return result;
+    }
+
+    result = coopt_next(state);
+    if (state!=NULL && state->trace!=NULL)
+      coopt_trace_result(state, result.opt, result.marker, result.result);
+    if (result.opt!=NULL && state->constraints!=NULL)
+      coopt_constraints_note(state->constraints, result.opt);
+    if (state!=NULL && state->parsed!=NULL)
+      coopt_parsed_note(state->parsed, &result);
+    if (state!=NULL && !coopt_is_termination(result.result))
+      state->num_results++;
+    if (state==NULL || state->diagnostics==NULL ||
+	!coopt_is_nonfatal(result.result))
+      return result;
+    /* note it down, and carry on */
+    coopt_diagnostics_note(state->diagnostics, state, &result);
   }
-  state->markers = markers;
+  while (1);
 }
 
 /*
- * Process the next option
+ * Do the actual work of coopt(). We recurse through here rather than
+ * coopt(), so each option is only noted once.
  */
-
-struct coopt_return coopt(struct coopt_state * state)
+static struct coopt_return coopt_next(struct coopt_state * state)
 {
   struct coopt_return result;
   result.result=COOPT_RESULT_OKAY; /* Look mummy! Optimistic code! */
@@ -103,6 +176,7 @@ struct coopt_return coopt(struct coopt_state * state)
   result.opt=NULL;
   result.param=NULL;
   result.marker=NULL;
+  result.related=NULL;
 
   if (state==NULL || state->argv==NULL)
   {
@@ -124,15 +198,17 @@ struct coopt_return coopt(struct coopt_state * state)
   if (state->char_within_arg < 0)
   {
 /*    printf("[coopt:automatic argument]\n");*/
-    state->argc--; /* fewer left */
-    result.param=state->argv++[0];
+    if (coopt_too_long(state, &result, 1))
+      return result;
+    result.param=state->argv[0];
+    coopt_advance(state, 1, 1);
     return result;
   }
 
   if (state->char_within_arg == 0)
   {
     int marker;
-    char const *m=NULL;
+    char const *m;
 
 /*    printf("[coopt:first char]\n");*/
     /* first, are we supposed to skip this arg? */
@@ -140,43 +216,54 @@ struct coopt_return coopt(struct coopt_state * state)
     {
 /*      printf("[coopt:skipping arg]\n");*/
       state->skip_next_arg=0; /* don't do it again! */
-      state->argc--;
-      state->argv++;
-      return coopt(state);
+      coopt_traced(state, COOPT_TRACE_SKIP, -1, 0);
+      coopt_advance(state, 1, 0);
+      return coopt_next(state);
     }
+    if (coopt_too_long(state, &result, 0))
+      return result;
     /* start of a new option - we need to (a) find out if this is
      * the separator, and then (b) find out which marker we're using
      * then we can worry about what option it is
      */
-    if (state->separator!=NULL && strcmp(state->argv[0], state->separator) == 0)
+    /* if we've classified this element up front as not being able to be
+     * the separator or start with a marker, it's an argument
+     */
+    if (state->classmap!=NULL)
+    {
+      int index = state->argv - state->classbase;
+      if (index>=0 && index<state->classcount &&
+	  !(state->classmap[index/COOPT_CLASSMAP_BITS] &
+	    (1UL<<(index%COOPT_CLASSMAP_BITS))))
+      {
+	result.param=state->argv[0];
+	coopt_advance(state, 1, 1);
+	return result;
+      }
+    }
+
+    if (state->separator!=NULL && coopt_strcmp(state->argv[0], state->separator) == 0)
     {
 /*      printf("[coopt:skipping separator]\n");*/
-      state->argc--; /* skip over this separator, which */
-      state->argv++; /* isn't return to the caller */
+      coopt_traced(state, COOPT_TRACE_SEPARATOR, -1, 0);
+      coopt_advance(state, 1, 0); /* skip over this separator, which
+				   * isn't return to the caller */
       state->char_within_arg = -1; /* will return the argument quickly */
-      return coopt(state);
+      return coopt_next(state);
     }
 
     /* let's find out which marker is involved */
-    marker=0;
-    while (state->markers[marker]!=NULL && m==NULL)
-    {
-      /* returns NULL or pointer to the character after the end of the
-       * second argument, found at the start of the first.
-       */
-      m = coopt_strstarts(state->argv[0], state->markers[marker]+1);
-      if (m==NULL)
-	marker++;
-    }
+    marker = coopt_marker(state, state->argv[0], &m);
+    coopt_traced(state, COOPT_TRACE_MARKER, -1, marker);
 
     /* if we didn't find a marker, or we found a marker with no option
      * after it, we consider it to be an argument not an option.
      */
-    if (state->markers[marker]==NULL || m[0]==0)
+    if (marker<0)
     {
       /* didn't find a marker - must be an argument */
-      state->argc--;
-      result.param=state->argv++[0];
+      result.param=state->argv[0];
+      coopt_advance(state, 1, 1);
       return result;
     }
 
@@ -184,9 +271,9 @@ struct coopt_return coopt(struct coopt_state * state)
     {
       /* Put it here ... it's ick, but it'll do for the moment */
       unsigned int length_to_test;
-      unsigned int i;
       struct coopt_option const *opt;
       int ambiguous;
+      struct coopt_namespace ns;
 
      case 'S':
       state->last_marker = state->markers[marker];
@@ -207,7 +294,7 @@ struct coopt_return coopt(struct coopt_state * state)
 
       if (state->flags.allow_long_eq_params && state->long_eq!=NULL)
       {
-	char const *r = strstr(m, state->long_eq);
+	char const *r = coopt_strstr(m, state->long_eq);
 	if (r!=NULL)
 	{
 /*	  printf("[coopt:found eq]\n");*/
@@ -216,65 +303,23 @@ struct coopt_return coopt(struct coopt_state * state)
 	else
 	{
 /*	  printf("[coopt:no eq]\n");*/
-	  length_to_test = strlen(m);
+	  length_to_test = coopt_strlen(m);
 	}
       }
       else
       {
 /*	printf("[coopt:eqs off]\n");*/
-	length_to_test = strlen(m);
+	length_to_test = coopt_strlen(m);
       }
 
-      /* opt==NULL - so stop after we've found one
-       * || state->allow_long_opts_breved - so don't actually stop if
-       * we're allowing abbreviated options, because we want to fault
-       * ambiguous abbreviations
-       */
-      for (i=0; i<state->num_options &&
-	        (opt==NULL || state->flags.allow_long_opts_breved); i++)
-      {
-	if (state->options[i].long_option!=NULL)
-	{
-	  if (state->flags.allow_long_opts_breved)
-	  {
-/*	    printf("[coopt:length_to_test=%i]\n", length_to_test);*/
-	    if (coopt_strnstarts(state->options[i].long_option,
-				 m,length_to_test)!=NULL)
-	    {
-	      if (opt==NULL)
-	      {
-/*		printf("[coopt:breved opt]\n");*/
-		/* Pointer arithmetic ... */
-		opt=state->options + i;
-	      }
-	      else
-	      {
-/*		printf("[coopt:ambiguous opt]\n");*/
-		ambiguous++;
-	      }
-	    }
-	  }
-	  else
-	  {
-	    /* We only want to test the section before the long_eq instance,
-	     * if any. So the length of the option we're looking at must be
-	     * the same as the space we're testing against.
-	     * This could be done faster in our own testing routine ...
-	     */
-	    if (strlen(state->options[i].long_option)==length_to_test &&
-		strncmp(m, state->options[i].long_option,length_to_test)==0)
-	    {
-/*	      printf("[coopt:long opt]\n");*/
-	      /* Bleurgh, pointer arithmetic ... */
-	      opt=state->options +i;
-	    }
-	  }
-        }
-      }
+      coopt_namespace(state, state->markers[marker], &ns);
+      opt = coopt_find_long(state, &ns, m, length_to_test, &ambiguous);
+      coopt_traced(state, COOPT_TRACE_LONG,
+		   (opt==NULL)?(-1):((int)(opt - ns.options)),
+		   (int)length_to_test);
 
       /* Do this now because it's applicable to all subsequent */
-      state->argc--;
-      state->argv++;
+      coopt_advance(state, 1, 0);
       result.marker=state->markers[marker];
 
       if (opt==NULL)
@@ -304,7 +349,7 @@ struct coopt_return coopt(struct coopt_state * state)
 	     * calculate length_to_test, so the whole of long_eq *must*
 	     * be present at m+length_to_test
 	     */
-	    result.param += strlen(state->long_eq);
+	    result.param += coopt_strlen(state->long_eq);
 	  }
 	  else
 	  {
@@ -343,8 +388,7 @@ struct coopt_return coopt(struct coopt_state * state)
 	      {
 /*	        printf("[coopt: got it]\n");*/
 	        result.param = state->argv[0];
-	        state->argc--;
-	        state->argv++;
+	        coopt_advance(state, 1, 0);
 	      }
 	    }
 	    else
@@ -395,6 +439,386 @@ struct coopt_return coopt(struct coopt_state * state)
   }
 }
 
+/*
+ * Step over (n) command line elements, which are arguments if (argument)
+ * is non-zero and otherwise part of an option. If we're building a
+ * permutation, option elements go on the front of it, and arguments on the
+ * back (in reverse; coopt_permuted() sorts that out).
+ */
+static void coopt_advance(struct coopt_state *state, int n, int argument)
+{
+  if (state->permutation!=NULL)
+  {
+    int index = state->argv - state->permbase;
+    int i;
+    for (i=0; i<n; i++)
+    {
+      if (argument)
+	state->permutation[state->perm_size - ++state->perm_arguments] =
+	  index+i;
+      else
+	state->permutation[state->perm_options++] = index+i;
+    }
+  }
+  state->argc -= n;
+  state->argv += n;
+}
+
+/*
+ * If the current element is longer than state->max_length, set up
+ * (result) to say so and step over it. We only look as far as the limit,
+ * so this takes no longer than the limit however long the element is.
+ */
+static int coopt_too_long(struct coopt_state *state,
+			  struct coopt_return *result, int argument)
+{
+  if (!coopt_over_length(state, state->argv[0]))
+    return 0;
+  result->result=COOPT_RESULT_TOOLONG;
+  result->param=state->argv[0];
+  coopt_advance(state, 1, argument);
+  return 1;
+}
+
+/*
+ * Look up options after state->markers[i] in namespaces[i], or after all
+ * of them in state->options again if (namespaces) is NULL.
+ */
+void coopt_use_namespaces(struct coopt_state *state,
+			  struct coopt_namespace const *namespaces)
+{
+  state->namespaces = namespaces;
+}
+
+/*
+ * Start building a permutation of the remaining elements in (index),
+ * which must have room for state->argc ints.
+ */
+void coopt_permute(struct coopt_state *state, int *index)
+{
+  state->permutation = index;
+  state->permbase = state->argv;
+  state->perm_options = 0;
+  state->perm_arguments = 0;
+  state->perm_size = state->argc;
+}
+
+/*
+ * Finish off the permutation: put the arguments, in order, straight after
+ * the options. Returns the number of elements in the permutation, and
+ * stores the number of option elements in *num_options.
+ */
+int coopt_permuted(struct coopt_state *state, int *num_options)
+{
+  if (state->permutation!=NULL)
+  {
+    int *index = state->permutation;
+    int from = state->perm_size - state->perm_arguments;
+    int to = state->perm_options;
+    int i;
+    for (i=0; i<state->perm_arguments/2; i++)
+    {
+      int t = index[from+i];
+      index[from+i] = index[state->perm_size-1-i];
+      index[state->perm_size-1-i] = t;
+    }
+    if (from!=to)
+      for (i=0; i<state->perm_arguments; i++)
+	index[to+i] = index[from+i];
+    state->permutation = NULL; /* we're done */
+  }
+  if (num_options!=NULL)
+    *num_options = state->perm_options;
+  return state->perm_options + state->perm_arguments;
+}
+
+/*
+ * Find which marker (if any) introduces an option in (element). Returns the
+ * index into state->markers, and sets *m to the first character after the
+ * marker; or returns -1 if (element) is an argument (including when it is
+ * nothing but a marker).
+ */
+static int coopt_marker(struct coopt_state *state, char const *element,
+			char const **m)
+{
+  int marker;
+  for (marker=0; state->markers[marker]!=NULL; marker++)
+  {
+    /* returns NULL or pointer to the character after the end of the
+     * second argument, found at the start of the first.
+     */
+    *m = coopt_strstarts(element, state->markers[marker]+1);
+    if (*m!=NULL)
+      return ((*m)[0]==0)?(-1):(marker);
+  }
+  return -1;
+}
+
+/*
+ * Return, in one go, the run of arguments starting at the current position
+ * (as coopt() would have returned them one at a time), and skip over them.
+ * If a classification map has been set up with coopt_classify(), most
+ * elements are dealt with by looking at a bit, and whole words of
+ * arguments at a time. The run stops short of an element coopt() would
+ * say was too long, and of state->max_results, leaving coopt() to return
+ * the error.
+ */
+int coopt_arguments(struct coopt_state *state, char const * const **args)
+{
+  int n=0, index=0, i;
+  char const *m;
+
+  *args = NULL;
+  if (state==NULL || state->argv==NULL || state->argc<=0)
+    return 0;
+
+  if (state->char_within_arg > 0 &&
+      state->argv[0][state->char_within_arg]==0)
+  {
+    /* finished a block of short options; tidy up as coopt_shortopt()
+     * would have done
+     */
+    coopt_advance(state, 1, 0);
+    state->char_within_arg=0;
+    state->last_marker=NULL;
+  }
+
+  if (state->char_within_arg < 0)
+  {
+    /* after the separator; everything's an argument */
+    n = state->argc;
+  }
+  else if (state->char_within_arg == 0 && state->argc>0)
+  {
+    if (state->skip_next_arg)
+    {
+      /* parameter we've already returned */
+      state->skip_next_arg=0;
+      coopt_traced(state, COOPT_TRACE_SKIP, -1, 0);
+      coopt_advance(state, 1, 0);
+    }
+    if (state->classmap!=NULL)
+      index = state->argv - state->classbase;
+    while (n<state->argc)
+    {
+      if (state->classmap!=NULL && index+n>=0 && index+n<state->classcount)
+      {
+	unsigned long word = state->classmap[(index+n)/COOPT_CLASSMAP_BITS]
+	                     >> ((index+n)%COOPT_CLASSMAP_BITS);
+	if (word==0)
+	{
+	  /* no candidates in the rest of this word */
+	  n += COOPT_CLASSMAP_BITS - (index+n)%COOPT_CLASSMAP_BITS;
+	  if (index+n > state->classcount)
+	    n = state->classcount - index;
+	  continue;
+	}
+	if ((word&1)==0)
+	{
+	  n++;
+	  continue;
+	}
+      }
+      /* a candidate; check it properly */
+      if ((state->separator!=NULL &&
+	   coopt_strcmp(state->argv[n], state->separator)==0) ||
+	  coopt_marker(state, state->argv[n], &m)>=0)
+	break;
+      n++;
+    }
+    if (n>state->argc) /* ran past the end in a single word */
+      n = state->argc;
+  }
+
+  if (state->max_results!=0)
+  {
+    if (state->num_results>=state->max_results)
+      n = 0;
+    else if ((unsigned long)n > state->max_results - state->num_results)
+      n = (int)(state->max_results - state->num_results);
+  }
+  if (state->max_length!=0)
+  {
+    for (i=0; i<n; i++)
+    {
+      if (coopt_over_length(state, state->argv[i]))
+	break;
+    }
+    n = i;
+  }
+
+  *args = state->argv;
+  if (state->parsed!=NULL)
+  {
+    /* note them as coopt() would have done */
+    struct coopt_return arg;
+    arg.result=COOPT_RESULT_OKAY;
+    arg.ambigresult=COOPT_RESULT_OKAY;
+    arg.opt=NULL;
+    arg.marker=NULL;
+    arg.related=NULL;
+    for (i=0; i<n; i++)
+    {
+      arg.param=state->argv[i];
+      coopt_parsed_note(state->parsed, &arg);
+    }
+  }
+  if (state->trace!=NULL)
+  {
+    /* an event for each, where coopt() would have written it */
+    for (i=0; i<n; i++)
+    {
+      coopt_advance(state, 1, 1);
+      coopt_trace_result(state, NULL, NULL, COOPT_RESULT_OKAY);
+    }
+  }
+  else
+    coopt_advance(state, n, 1);
+  state->num_results += n;
+  return n;
+}
+
+/*
+ * Like coopt(), except that short options without parameters are set in
+ * (flags) instead of being returned, until something else turns up. Runs
+ * of them in the middle of a block are found straight from a table, with
+ * none of the work of a call to coopt() each.
+ */
+struct coopt_return coopt_cluster(struct coopt_state *state,
+				  unsigned long *flags)
+{
+  struct coopt_return result;
+  struct coopt_namespace ns;
+  int local_map[256];
+  int const *map=NULL;
+  char const *map_marker=NULL; /* the one map is for */
+  unsigned int i;
+
+  if (state==NULL)
+    return coopt(state);
+  for (i=0; i<COOPT_FLAGMAP_WORDS(state->num_options); i++)
+    flags[i]=0;
+
+  for (;;)
+  {
+    if (state->char_within_arg>0 && state->constraints==NULL &&
+	state->parsed==NULL && state->trace==NULL)
+    {
+      if (map==NULL || map_marker!=state->last_marker)
+      {
+	map_marker = state->last_marker;
+	coopt_namespace(state, state->last_marker, &ns);
+	if (coopt_indexed(&ns))
+	  map = ns.index->short_map;
+	else
+	{
+	  /* backwards, so the first of any repeated option wins */
+	  for (i=0; i<256; i++)
+	    local_map[i] = -1;
+	  for (i=ns.num_options; i>0; i--)
+	    if (ns.options[i-1].short_option!=0)
+	      local_map[(unsigned char)ns.options[i-1].short_option] = i-1;
+	  map = local_map;
+	}
+      }
+      /* only flags from state->options have somewhere to go */
+      if (ns.options==state->options)
+      {
+	char const *element = state->argv[0];
+	int opt;
+	while (element[state->char_within_arg]!=0 &&
+	       (opt = map[(unsigned char)element[state->char_within_arg]])>=0 &&
+	       state->options[opt].has_param==COOPT_NO_PARAM &&
+	       (state->max_results==0 ||
+		state->num_results<state->max_results))
+	{
+	  flags[opt/COOPT_FLAGMAP_BITS] |= 1UL<<(opt%COOPT_FLAGMAP_BITS);
+	  state->char_within_arg++;
+	  state->num_results++;
+	}
+      }
+    }
+
+    /* anything else is coopt()'s business */
+    result = coopt(state);
+    if (result.result!=COOPT_RESULT_OKAY || result.opt==NULL ||
+	result.marker==NULL || result.marker[0]!='S' ||
+	result.opt->has_param!=COOPT_NO_PARAM ||
+	result.opt<state->options ||
+	result.opt>=state->options+state->num_options)
+      return result;
+    i = result.opt - state->options;
+    flags[i/COOPT_FLAGMAP_BITS] |= 1UL<<(i%COOPT_FLAGMAP_BITS);
+  }
+}
+
+/*
+ * Like coopt(), except that an element starting with an option we don't
+ * know is returned whole (with, if (take_params) is non-zero and it has no
+ * inline parameter, the element after it if that doesn't look like an
+ * option), as *count elements from *elements, so it can be passed on.
+ * coopt() has already looked the option up, and while state->passthrough
+ * is set it steps over the whole element for us, so known options cost no
+ * more than usual.
+ */
+struct coopt_return coopt_passthrough(struct coopt_state *state,
+				      int take_params,
+				      char const * const **elements,
+				      int *count)
+{
+  struct coopt_return result;
+  struct coopt_diagnostics *diagnostics;
+  char const *next;
+
+  *elements = NULL;
+  *count = 0;
+  if (state==NULL)
+    return coopt(state);
+
+  /*
+   * Unknown options aren't errors here, so we note anything else that is
+   * ourselves
+   */
+  diagnostics = state->diagnostics;
+  state->diagnostics = NULL;
+  state->passthrough = 1;
+  do
+  {
+    result = coopt(state);
+    if (result.result==COOPT_RESULT_BADOPTION && state->char_within_arg==0)
+      break;
+    if (diagnostics==NULL || !coopt_is_nonfatal(result.result))
+      break;
+    coopt_diagnostics_note(diagnostics, state, &result);
+  }
+  while (1);
+  state->passthrough = 0;
+  state->diagnostics = diagnostics;
+  if (result.result!=COOPT_RESULT_BADOPTION || state->char_within_arg!=0)
+    return result;
+
+  /* the whole element, just stepped over */
+  *elements = state->argv - 1;
+  *count = 1;
+  /* cheapest first: the next element usually looks like an option */
+  if (take_params && state->argc>0 &&
+      coopt_marker(state, state->argv[0], &next)<0 &&
+      (state->separator==NULL ||
+       coopt_strcmp(state->argv[0], state->separator)!=0))
+  {
+    if (result.marker[0]=='S')
+      take_params = (result.param[1]==0);
+    else if (state->flags.allow_long_eq_params && state->long_eq!=NULL)
+      take_params = (coopt_strstr(result.param, state->long_eq)==NULL);
+    if (take_params)
+    {
+      coopt_advance(state, 1, 0);
+      *count = 2;
+    }
+  }
+  return result;
+}
+
 /*
  * if we get a short option, we need to worry about
  * allow_mix_short_params or its alternative, ie -cfv has "v" as param
@@ -404,85 +828,217 @@ struct coopt_return coopt(struct coopt_state * state)
 static struct coopt_return coopt_shortopt(struct coopt_state *state)
 {
   unsigned int opt;
+  struct coopt_namespace ns;
   struct coopt_return result;
   result.result=COOPT_RESULT_OKAY;
   result.ambigresult=COOPT_RESULT_OKAY;
   result.opt=NULL;
   result.param=NULL;
   result.marker=state->last_marker; /* always gets used */
+  result.related=NULL;
 
   if (state->argv[0][state->char_within_arg]==0)
   {
     /* no more options here */
-    state->argv++;
-    state->argc--;
+    coopt_advance(state, 1, 0);
     state->char_within_arg=0;
     state->last_marker=NULL;
-    return coopt(state);
+    return coopt_next(state);
   }
 
-  for (opt=0; opt<state->num_options; opt++)
+  coopt_namespace(state, state->last_marker, &ns);
+  opt = coopt_find_short(&ns, state->argv[0][state->char_within_arg]);
+  coopt_traced(state, COOPT_TRACE_SHORT,
+	       (opt<ns.num_options)?((int)opt):(-1),
+	       (unsigned char)state->argv[0][state->char_within_arg]);
+  if (opt<ns.num_options)
   {
-    /* if short_option==0, it isn't a valid short option ... */
-    if (state->options[opt].short_option!=0 && state->options[opt].short_option==state->argv[0][state->char_within_arg])
+    state->char_within_arg++;
+    /* Bleurgh, pointer arithmetic ... */
+    result.opt=ns.options + opt; /* Always from now on in this block */
+    /* Found it! Hooray! */
+    if (ns.options[opt].has_param == COOPT_REQUIRED_PARAM)
     {
-      state->char_within_arg++;
-      /* Bleurgh, pointer arithmetic ... */
-      result.opt=state->options + opt; /* Always from now on in this block */
-      /* Found it! Hooray! */
-      if (state->options[opt].has_param == COOPT_REQUIRED_PARAM)
-      {
 /*	printf("[coopt:req param]\n");*/
-	/* First case: this is the last short option in this argument, so
-	 * its parameter *must* be the next argument. Second case: mixed
-	 * short parameters are on, so the parameter again has to be in the
-	 * next argument.
-	 */
-	if (state->argv[0][state->char_within_arg]==0
-	    || state->flags.allow_mix_short_params)
+      /* First case: this is the last short option in this argument, so
+       * its parameter *must* be the next argument. Second case: mixed
+       * short parameters are on, so the parameter again has to be in the
+       * next argument.
+       */
+      if (state->argv[0][state->char_within_arg]==0
+	  || state->flags.allow_mix_short_params)
+      {
+	if (state->argc<=1) /* run out of arguments */
 	{
-	  if (state->argc<=1) /* run out of arguments */
-	  {
-	    result.result=COOPT_RESULT_MISSINGPARAM;
-	    return result;
-	  }
-	  if (state->skip_next_arg>0) /* already had this once! death! */
-	  {
-	    result.result = COOPT_RESULT_MULTIMIXED;
-	    return result;
-	  }
-	  state->skip_next_arg=1;
-	  result.param=state->argv[1];
+	  result.result=COOPT_RESULT_MISSINGPARAM;
 	  return result;
 	}
-	else
+	if (state->skip_next_arg>0) /* already had this once! death! */
 	{
-	  /* Parameter is inline as part of the current argument.
-	   * state->char_within_arg is already right for this ...
-	   */
-	  result.param = state->argv[0] + state->char_within_arg;
-	  state->argc--;
-	  state->argv++;
-	  state->char_within_arg=0;
-	  state->last_marker=NULL;
+	  result.result = COOPT_RESULT_MULTIMIXED;
 	  return result;
 	}
+	state->skip_next_arg=1;
+	coopt_traced(state, COOPT_TRACE_SKIP, (int)opt, 1);
+	result.param=state->argv[1];
+	return result;
       }
       else
       {
-	/* No parameter - just return (we've already skipped this one) */
+	/* Parameter is inline as part of the current argument.
+	 * state->char_within_arg is already right for this ...
+	 */
+	result.param = state->argv[0] + state->char_within_arg;
+	coopt_advance(state, 1, 0);
+	state->char_within_arg=0;
+	state->last_marker=NULL;
 	return result;
       }
     }
+    else
+    {
+      /* No parameter - just return (we've already skipped this one) */
+      return result;
+    }
   }
 
   /* Didn't find one. Oh dear ... */
   result.result = COOPT_RESULT_BADOPTION;
   result.param = state->argv[0] + state->char_within_arg;
+  if (state->passthrough && (size_t)state->char_within_arg ==
+			    coopt_strlen(state->last_marker+1))
+  {
+    /* the first in the block; coopt_passthrough() wants all of it */
+    coopt_advance(state, 1, 0);
+    state->char_within_arg=0;
+    state->last_marker=NULL;
+    return result;
+  }
   state->char_within_arg++; /* skip the one we had trouble with */
   return result;
 }
 
+/*
+ * Find the long option given as (length_to_test) characters of (m), as
+ * an abbreviation if allow_long_opts_breved is on, in which case
+ * (*ambiguous) counts how many others it could also be. Only the options
+ * in (ns) are searched.
+ */
+static struct coopt_option const *coopt_find_long(struct coopt_state *state,
+						  struct coopt_namespace const *ns,
+						  char const *m,
+						  unsigned int length_to_test,
+						  int *ambiguous)
+{
+  struct coopt_option const *opt=NULL;
+  unsigned int i;
+  *ambiguous=0;
+
+  if (coopt_indexed(ns))
+  {
+    int found;
+    if (state->flags.allow_long_opts_breved)
+      found = coopt_index_abbrev(ns->index, m, length_to_test, ambiguous);
+    else
+      found = coopt_index_long(ns->index, m, length_to_test);
+    return (found<0)?(NULL):(ns->options + found);
+  }
+
+  /* opt==NULL - so stop after we've found one
+   * || state->allow_long_opts_breved - so don't actually stop if
+   * we're allowing abbreviated options, because we want to fault
+   * ambiguous abbreviations
+   */
+  for (i=0; i<ns->num_options &&
+	    (opt==NULL || state->flags.allow_long_opts_breved); i++)
+  {
+    if (ns->options[i].long_option!=NULL)
+    {
+      if (state->flags.allow_long_opts_breved)
+      {
+/*	    printf("[coopt:length_to_test=%i]\n", length_to_test);*/
+	if (coopt_strnstarts(ns->options[i].long_option,
+			     m,length_to_test)!=NULL)
+	{
+	  if (opt==NULL)
+	  {
+/*		printf("[coopt:breved opt]\n");*/
+	    /* Pointer arithmetic ... */
+	    opt=ns->options + i;
+	  }
+	  else
+	  {
+/*		printf("[coopt:ambiguous opt]\n");*/
+	    (*ambiguous)++;
+	  }
+	}
+      }
+      else
+      {
+	/* We only want to test the section before the long_eq instance,
+	 * if any. So the length of the option we're looking at must be
+	 * the same as the space we're testing against.
+	 * This could be done faster in our own testing routine ...
+	 */
+	if (coopt_strlen(ns->options[i].long_option)==length_to_test &&
+	    coopt_strncmp(m, ns->options[i].long_option,length_to_test)==0)
+	{
+/*	      printf("[coopt:long opt]\n");*/
+	  /* Bleurgh, pointer arithmetic ... */
+	  opt=ns->options +i;
+	}
+      }
+    }
+  }
+  return opt;
+}
+
+/*
+ * Position of the short option (c) in ns->options, or ns->num_options
+ * if there isn't one.
+ */
+static unsigned int coopt_find_short(struct coopt_namespace const *ns,
+				     char c)
+{
+  unsigned int opt;
+  if (coopt_indexed(ns))
+  {
+    int found = coopt_index_short(ns->index, c);
+    return (found<0)?(ns->num_options):((unsigned int)found);
+  }
+  /* if short_option==0, it isn't a valid short option ... */
+  for (opt=0; opt<ns->num_options; opt++)
+    if (ns->options[opt].short_option!=0 &&
+	ns->options[opt].short_option==c)
+      break;
+  return opt;
+}
+
+/*
+ * The options to look things up in after (marker), which is one of
+ * state->markers: its own namespace if it has one, otherwise
+ * state->options (and state->index).
+ */
+static void coopt_namespace(struct coopt_state *state, char const *marker,
+			    struct coopt_namespace *ns)
+{
+  int i;
+  ns->options = state->options;
+  ns->num_options = state->num_options;
+  ns->index = state->index;
+  if (state->namespaces==NULL)
+    return;
+  for (i=0; state->markers[i]!=NULL; i++)
+  {
+    if (state->markers[i]==marker)
+    {
+      if (state->namespaces[i].options!=NULL)
+	*ns = state->namespaces[i];
+      return;
+    }
+  }
+}
+
 /*
  * returns NULL, or pointer to the character after the end of (start),
  * found at the start of (target). If (target) is shorter than (start),
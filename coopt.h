@@ -66,6 +66,15 @@
 extern "C" {
 #endif
 
+/*
+ * Every function is declared with COOPT_API, which is normally empty.
+ * coopt_single.h defines it to make them all static inline instead, when
+ * compiling the whole of coopt into your program (see there).
+ */
+#ifndef COOPT_API
+#define COOPT_API
+#endif
+
 /*
  * note that the error case of an invalid combination of option
  * and marker need to be dealt with by the user
@@ -83,11 +92,24 @@ struct coopt_option
   void * data; /* can leave out completely in initialiser;
 		* this is private to the user - coopt won't touch it
 		*/
+  unsigned int attributes; /* COOPT_UNORDERED etc, or-ed together; can
+			    * also be left out
+			    */
 };
 
 #define COOPT_NO_PARAM		(0)
 #define COOPT_REQUIRED_PARAM	(1)
 
+/*
+ * Attributes of options, which don't change how they're parsed but are
+ * used by some of the support routines.
+ */
+#define COOPT_UNORDERED		(1) /* where it's given doesn't matter;
+				     * see coopt_fingerprint()
+				     */
+#define COOPT_SCOPE_OPEN	(2) /* starts a group, and ... */
+#define COOPT_SCOPE_CLOSE	(4) /* ... this ends it; see coopt_scopes() */
+
 /*
  * Note that unlike GNU getopt, we don't allow optional_argument.
  * This is because we believe it to be more confusing than it's worth.
@@ -112,10 +134,10 @@ struct coopt_state; /* declare this to prevent any possible problems
  * Note that argc and argv as passed to coopt_init() should be
  * argc-1 and argv+1 as passed to main().
  */
-void coopt_init(struct coopt_state * /*state*/,
-		struct coopt_option const * /*options*/,
-		unsigned int /*num_options*/,
-		int /*argc*/, char const * const * /*argv*/);
+COOPT_API void coopt_init(struct coopt_state * /*state*/,
+			  struct coopt_option const * /*options*/,
+			  unsigned int /*num_options*/,
+			  int /*argc*/, char const * const * /*argv*/);
 
 /*
  * structure returned by coopt() after each pass, indicating what was
@@ -144,6 +166,10 @@ struct coopt_return
   char const * marker; /* pointer to the marker definition (eg: "L--") that
   			* was used for this option (or NULL)
   			*/
+  struct coopt_option const * related; /* the other option involved in a
+					* constraint violation (or NULL);
+					* see coopt_check()
+					*/
 };
 
 /*
@@ -158,6 +184,12 @@ struct coopt_return
  */
 #define COOPT_RESULT_ERROR		(-1)
 
+/* coopt() has already returned state->max_results results, and won't
+ * return anything else. (Or, from coopt_scopes(), there wasn't room for
+ * any more results or scopes.)
+ */
+#define COOPT_RESULT_TOOMANY		(-3)
+
 /*
  * These are non-fatal errors
  */
@@ -197,6 +229,28 @@ struct coopt_return
  */
 #define COOPT_RESULT_BADOPTION		(-4)
 
+/* Constraint violations, from coopt_check() only. 'opt' and 'related' are
+ * the two options which can't both be given (_CONFLICT), or the option
+ * given and the option it needs (_REQUIRES). For _NONEOF, none of a group
+ * of options of which at least one is required was given; 'opt' is the
+ * first in the group, and 'related' the second (or NULL).
+ * 'marker' is set up so that coopt_sopt() will work on 'opt'.
+ */
+#define COOPT_RESULT_CONFLICT		(-12)
+#define COOPT_RESULT_REQUIRES		(-14)
+#define COOPT_RESULT_NONEOF		(-16)
+
+/* An element was longer than state->max_length, so we haven't looked at
+ * it; 'param' points to it. Carry on, and it'll be skipped.
+ */
+#define COOPT_RESULT_TOOLONG		(-18)
+
+/* From coopt_scopes() only: a COOPT_SCOPE_CLOSE option with no group
+ * open, or a COOPT_SCOPE_OPEN one whose group was never closed. The rest
+ * of the result is as coopt() returned it.
+ */
+#define COOPT_RESULT_UNBALANCED		(-20)
+
 /* --long with =-style parameter only. The option will be fully processed
  * other than this. You shouldn't use this to get optional parameters in
  * general, because with sep-parameters turned on this will never happen
@@ -225,6 +279,13 @@ struct coopt_return
  */
 #define COOPT_RESULT_END		(2)
 
+/*
+ * From coopt_feed_next() only: nothing more can be returned until you've
+ * fed in more of the command line, or told coopt_feed_end() there isn't
+ * any more.
+ */
+#define COOPT_RESULT_MORE		(3)
+
 /* Returns come in four sorts: fatal error, non-fatal error, okay, and
  * termination. Errors are < 0, okay ==0, termination > 0. This is a
  * defined part of the interface. The fatal/non-fatal error boundary isn't
@@ -256,7 +317,7 @@ struct coopt_return
  * main coopt processing routine. Just call this repeatedly to cycle
  * through all options and arguments.
  */
-struct coopt_return coopt(struct coopt_state * /*state*/);
+COOPT_API struct coopt_return coopt(struct coopt_state * /*state*/);
 
 /*
  * The number of badgers acts as a version indicator for the internal
@@ -266,7 +327,7 @@ struct coopt_return coopt(struct coopt_state * /*state*/);
  *
  * The badgers themselves are gratuitous.
  */
-#define COOPT_GRATUITOUS_BADGERS 5
+#define COOPT_GRATUITOUS_BADGERS 15
 
 /*
  * Complete coopt state. This is supplied by the user, but should be set
@@ -310,6 +371,9 @@ struct coopt_state
 				 * above list would cause "S-" to be used
 				 * even when the option started "--".)
   				 */
+  /* Limits, for command lines you don't trust; 0 for no limit */
+  size_t max_length; /* longest element coopt() will look at */
+  unsigned long max_results; /* most results coopt() will return */
 
   /* Ignore this if you're a user */
   int argc;
@@ -320,9 +384,27 @@ struct coopt_state
 			*/
   unsigned int skip_next_arg; /* non-zero to skip the next one on start of
 			       * processing */
+  int passthrough; /* set by coopt_passthrough() while it runs coopt() */
   char const * last_marker; /* used with multiple short options in one
 			     * argument
 			     */
+  unsigned long const * classmap; /* set up by coopt_classify() */
+  char const * const * classbase; /* argv that classmap starts at */
+  int classcount; /* number of elements in classmap */
+  int * permutation; /* set up by coopt_permute() */
+  char const * const * permbase; /* argv that permutation starts at */
+  int perm_options; /* option elements at the front of permutation */
+  int perm_arguments; /* argument elements at the back of permutation */
+  int perm_size;
+  struct coopt_constraints * constraints; /* set up by coopt_constrain() */
+  struct coopt_parsed * parsed; /* set up by coopt_collect() */
+  struct coopt_index const * index; /* set up by coopt_use_index() */
+  struct coopt_namespace const * namespaces; /* set up by
+					      * coopt_use_namespaces()
+					      */
+  struct coopt_diagnostics * diagnostics; /* set up by coopt_diagnose() */
+  struct coopt_trace * trace; /* set up by coopt_trace() */
+  unsigned long num_results; /* returned by coopt() so far */
 };
 
 /* And some support routines, which may make life easier on you */
@@ -341,9 +423,20 @@ struct coopt_state
  * a sprintf() if it can fit the entire string in.
  * Buffer is always NUL-terminated on exit.
  */
-size_t coopt_sopt(char * /*buffer*/, size_t /*bufsize*/,
-                  struct coopt_return * /*ret*/, int /*show_marker*/,
-                  struct coopt_state * /*state*/);
+COOPT_API size_t coopt_sopt(char * /*buffer*/, size_t /*bufsize*/,
+			    struct coopt_return * /*ret*/, int /*show_marker*/,
+			    struct coopt_state * /*state*/);
+
+/*
+ * The first of state->markers that could introduce (opt): a long option
+ * marker if it has a long option, otherwise a short option marker. NULL
+ * if there isn't one. With namespaces, only markers whose namespace
+ * contains (opt) count.
+ * This is useful for displaying options you haven't had returned from
+ * coopt(), eg: with coopt_sopt().
+ */
+COOPT_API char const * coopt_marker_for(struct coopt_state * /*state*/,
+					struct coopt_option const * /*opt*/);
 
 /*
  * Fill the buffer with a string describing the current state.
@@ -358,9 +451,980 @@ size_t coopt_sopt(char * /*buffer*/, size_t /*bufsize*/,
  * a sprintf() if it can fit the entire string in.
  * Buffer is always NUL-terminated on exit.
  */
-size_t coopt_serror(char * /*buffer*/, size_t /*bufsize*/,
-		    struct coopt_return * /*ret*/,
-		    struct coopt_state * /*state*/);
+COOPT_API size_t coopt_serror(char * /*buffer*/, size_t /*bufsize*/,
+			      struct coopt_return * /*ret*/,
+			      struct coopt_state * /*state*/);
+
+/* Optional extras, for when you need to go faster */
+
+/*
+ * Bulk classification of the remaining command line elements. Each bit
+ * of 'map' is set to say that the corresponding element might be the
+ * separator or start with a marker, and clear to say that it's definitely
+ * an argument; coopt() and coopt_arguments() then don't need to look at
+ * the clear ones any further. 'map' must have room for
+ * COOPT_CLASSMAP_WORDS(state->argc) words, and is yours to manage.
+ * Call this again if you change the separator or markers; call it with
+ * map==NULL to stop using a map.
+ */
+#define COOPT_CLASSMAP_BITS (8*sizeof(unsigned long))
+#define COOPT_CLASSMAP_WORDS(argc) \
+	(((argc)+COOPT_CLASSMAP_BITS-1)/COOPT_CLASSMAP_BITS)
+COOPT_API void coopt_classify(struct coopt_state * /*state*/,
+			      unsigned long * /*map*/);
+
+/*
+ * Skip over the run of arguments (possibly empty) starting at the current
+ * position, returning how many there were, and setting *args to point to
+ * the first of them. This gives exactly the arguments that coopt() would
+ * have returned one at a time, counting them in state->num_results. (Part
+ * way through a block of short options there can't be any arguments, so
+ * this returns 0.) The run stops short of an element longer than
+ * state->max_length, and at state->max_results, so that the next call of
+ * coopt() returns COOPT_RESULT_TOOLONG or COOPT_RESULT_TOOMANY.
+ */
+COOPT_API int coopt_arguments(struct coopt_state * /*state*/,
+			      char const * const ** /*args*/);
+
+/*
+ * Like coopt(), except that short options without a parameter (flags) are
+ * set in 'flags' (bit N for state->options[N]) rather than returned, so a
+ * block like "-xvzf file" comes back as x, v and z in 'flags' and a single
+ * result for f. It returns the first result that isn't such a flag (an
+ * option with a parameter, an argument, an error or a termination), and
+ * so may run through several blocks first; everything it returns, and
+ * where, is just as coopt() would. 'flags' must have room for
+ * COOPT_FLAGMAP_WORDS(state->num_options) words, and is cleared first. A
+ * flag given twice is only set once. Flags from other namespaces are
+ * returned as usual.
+ */
+#define COOPT_FLAGMAP_BITS (8*sizeof(unsigned long))
+#define COOPT_FLAGMAP_WORDS(num_options) \
+	(((num_options)+COOPT_FLAGMAP_BITS-1)/COOPT_FLAGMAP_BITS)
+#define coopt_flagmap_test(flags, n) \
+	(((flags)[(n)/COOPT_FLAGMAP_BITS]>>((n)%COOPT_FLAGMAP_BITS))&1)
+COOPT_API struct coopt_return coopt_cluster(struct coopt_state * /*state*/,
+					    unsigned long * /*flags*/);
+
+/*
+ * For wrappers, which handle some options and pass the rest on to another
+ * program: like coopt(), except that an element starting with an unknown
+ * option (eg: "--foreign=x", or "-Wall" if there's no -W) comes back as a
+ * single COOPT_RESULT_BADOPTION, with 'elements' pointing at it in argv
+ * and 'count' set to 1. With 'take_params', if it had no inline parameter
+ * and the next element doesn't look like an option (or the separator),
+ * that's taken as its parameter, and 'count' is 2. Otherwise 'elements'
+ * is NULL and 'count' 0, and the result is as coopt() would give; so an
+ * unknown option part way through a block of known short options is
+ * returned as usual. Elements passed through aren't noted as diagnostics.
+ * Each element is only looked up once, as coopt() would; use an index (see
+ * coopt_use_index()) so that's a single probe rather than a search.
+ */
+COOPT_API struct coopt_return coopt_passthrough(struct coopt_state * /*state*/,
+						int /*take_params*/,
+						char const * const ** /*elements*/,
+						int * /*count*/);
+
+/*
+ * GNU getopt-style "options first, then arguments", without touching
+ * argv. After coopt_permute(), coopt() notes the position of each element
+ * it steps over in 'index' (which must have room for state->argc ints,
+ * and is yours to manage). Once you've finished calling coopt(),
+ * coopt_permuted() arranges 'index' so that it lists the option elements
+ * (including separated parameters and the separator) in order, then the
+ * arguments in order; it returns the number of elements listed, and sets
+ * *num_options to the number of option elements at the front. Positions
+ * are relative to state->argv when coopt_permute() was called.
+ */
+COOPT_API void coopt_permute(struct coopt_state * /*state*/, int * /*index*/);
+COOPT_API int coopt_permuted(struct coopt_state * /*state*/,
+			     int * /*num_options*/);
+
+/*
+ * Constraints between options, checked once parsing is complete. Each
+ * constraint is on a NULL-terminated list of options; these (and
+ * 'option') are pointers into the same array you give to coopt_init().
+ *   COOPT_CONFLICTS: if 'option' is NULL, at most one of 'options' may
+ *                    be given; otherwise if 'option' is given, none of
+ *                    'options' may be
+ *   COOPT_REQUIRES:  if 'option' is given, all of 'options' must be
+ *   COOPT_ONE_OF:    exactly one of 'options' must be given
+ *   COOPT_ANY_OF:    at least one of 'options' must be given
+ */
+struct coopt_constraint
+{
+  unsigned int type;
+  struct coopt_option const * option;
+  struct coopt_option const * const * options;
+};
+
+#define COOPT_CONFLICTS		(1)
+#define COOPT_REQUIRES		(2)
+#define COOPT_ONE_OF		(3)
+#define COOPT_ANY_OF		(4)
+
+/*
+ * Constraints compiled against an option array by coopt_constraints_init()
+ * into bitsets, one bit per option. Memory for the bitsets is supplied by
+ * you, and must have room for
+ * COOPT_CONSTRAINTS_WORDS(num_options, num_constraints) words.
+ */
+struct coopt_constraints
+{
+  struct coopt_option const * options;
+  unsigned int num_options;
+  struct coopt_constraint const * constraints;
+  unsigned int num_constraints;
+  unsigned int words; /* in each bitset */
+  unsigned long * seen; /* options given so far */
+  unsigned long * sets; /* 'option' then 'options', for each constraint */
+  unsigned int next; /* next constraint for coopt_check() to look at */
+};
+
+#define COOPT_CONSTRAINTS_WORDS(num_options, num_constraints) \
+	((2*(num_constraints)+1)*COOPT_CLASSMAP_WORDS(num_options))
+
+/*
+ * Returns 0, or -1 if a constraint refers to an option that isn't in
+ * the array (in which case the constraints can't be used).
+ */
+COOPT_API int
+coopt_constraints_init(struct coopt_constraints * /*constraints*/,
+		       struct coopt_constraint const * /*constraint*/,
+		       unsigned int /*num_constraints*/,
+		       struct coopt_option const * /*options*/,
+		       unsigned int /*num_options*/,
+		       unsigned long * /*space*/);
+
+/*
+ * Have coopt() note every option it returns against these constraints
+ * (clearing any it's noted before). Pass NULL to stop.
+ */
+COOPT_API void coopt_constrain(struct coopt_state * /*state*/,
+			       struct coopt_constraints * /*constraints*/);
+
+/*
+ * Used by coopt() to note an option; you can call it yourself if you're
+ * processing options some other way.
+ */
+COOPT_API void
+coopt_constraints_note(struct coopt_constraints * /*constraints*/,
+		       struct coopt_option const * /*opt*/);
+
+/*
+ * Call repeatedly once parsing is complete, until it returns
+ * COOPT_RESULT_END, to get each constraint violation in turn. If there
+ * are no constraints in use, this returns COOPT_RESULT_END straight away.
+ */
+COOPT_API struct coopt_return coopt_check(struct coopt_state * /*state*/);
+
+/*
+ * A compiled index of an option array, to find an option from its short
+ * or long form in constant time, and a long option from an abbreviation
+ * by binary search. The long options are kept in an open hash table, and
+ * in order of name with the length of the shortest abbreviation of each
+ * that can't be confused with another. The arrays are in memory supplied
+ * by you, with room for COOPT_INDEX_SIZE(num_options) ints; or they can
+ * be generated in advance by coopt-gen.
+ */
+struct coopt_index
+{
+  struct coopt_option const * options;
+  unsigned int num_options;
+  int short_map[256]; /* position of the option for each short option
+		       * character, or -1
+		       */
+  int const * table; /* position of the option in each slot, or -1 */
+  unsigned long mask; /* number of slots - 1 (it's a power of two) */
+  unsigned long seed;
+  int const * lengths; /* of each long option, or -1 */
+  int const * sorted; /* positions of long options, in order of name */
+  unsigned int num_sorted;
+  int const * prefixes; /* for each of sorted, the shortest unambiguous
+			 * abbreviation (longer than the option if there
+			 * isn't one)
+			 */
+  int const * firsts; /* a tree over sorted: firsts[i] is the lesser of
+		       * nodes 2i and 2i+1, where node num_sorted+j is
+		       * sorted[j] (and firsts[0] isn't used)
+		       */
+};
+
+#define COOPT_INDEX_SIZE(num_options) (8*(num_options)+2)
+
+/*
+ * Returns the number of long options that couldn't go in their first
+ * choice of slot (so with 0, every lookup is a single probe). Trying
+ * different values of 'seed' changes which ones collide. If an option
+ * is repeated, the first one wins, as with coopt().
+ */
+COOPT_API int coopt_index_init(struct coopt_index * /*index*/,
+			       struct coopt_option const * /*options*/,
+			       unsigned int /*num_options*/,
+			       unsigned long /*seed*/, int * /*space*/);
+
+/*
+ * Position of the option in index->options, or -1 if there isn't one.
+ * The long option is given as 'len' characters of 'name', which don't
+ * need to be NUL-terminated.
+ * coopt_index_abbrev() finds the long option 'name' is an abbreviation of,
+ * as coopt() would with allow_long_opts_breved; *ambiguous is set
+ * non-zero if it's an abbreviation of more than one (in which case the
+ * first of them is returned).
+ */
+COOPT_API int coopt_index_short(struct coopt_index const * /*index*/,
+				char /*c*/);
+COOPT_API int coopt_index_long(struct coopt_index const * /*index*/,
+			       char const * /*name*/, size_t /*len*/);
+COOPT_API int coopt_index_abbrev(struct coopt_index const * /*index*/,
+				 char const * /*name*/, size_t /*len*/,
+				 int * /*ambiguous*/);
+
+/*
+ * Have coopt() use a compiled index to find options, instead of
+ * searching through them. This also sets state->options and
+ * state->num_options from the index; if you change them afterwards, the
+ * index won't be used.
+ */
+COOPT_API void coopt_use_index(struct coopt_state * /*state*/,
+			       struct coopt_index const * /*index*/);
+
+/*
+ * Binary images of an index, which can be written to a file and later
+ * mapped (read-only) into memory and used in place; see image.c for the
+ * format. Only the option array has to be built when you attach an image
+ * (in memory supplied by you, with room for the number of options given
+ * by coopt_image_num_options()); the index's tables and the long option
+ * strings stay in the image.
+ *
+ * coopt_image_write() returns the size of the image, and only writes it
+ * if 'size' is big enough. coopt_image_num_options() returns -1 if this
+ * isn't an image we can use (eg: one from a machine with a different byte
+ * order). coopt_image_attach() checks the image thoroughly, and returns
+ * 0, or -1 if it's unusable.
+ */
+#define COOPT_IMAGE_MAGIC	(0x54504f43) /* "COPT" */
+#define COOPT_IMAGE_VERSION	(3)
+
+COOPT_API size_t coopt_image_write(struct coopt_index const * /*index*/,
+				   void * /*buffer*/, size_t /*size*/);
+COOPT_API int coopt_image_num_options(void const * /*image*/, size_t /*size*/);
+COOPT_API int coopt_image_attach(struct coopt_index * /*index*/,
+				 struct coopt_option * /*options*/,
+				 unsigned int /*num_options*/,
+				 void const * /*image*/, size_t /*size*/);
+
+/*
+ * Option namespaces: normally every marker looks options up in
+ * state->options, but each one can be given its own table (with its own
+ * index, if you like) instead. Pass coopt_use_namespaces() an array with
+ * an entry for each marker, in the same order as state->markers; an entry
+ * whose options are NULL uses state->options and state->index as usual.
+ * Options found are returned pointing into the table they came from, and
+ * the marker in the return says which namespace that was. Pass NULL to go
+ * back to a single table.
+ */
+struct coopt_namespace
+{
+  struct coopt_option const * options; /* or NULL for state->options */
+  unsigned int num_options;
+  struct coopt_index const * index; /* or NULL to search options */
+};
+
+COOPT_API void coopt_use_namespaces(struct coopt_state * /*state*/,
+				    struct coopt_namespace const * /*ns*/);
+
+/*
+ * Push parsing, for command lines that arrive a piece at a time as
+ * NUL-terminated elements (eg: over a socket). Bytes are fed in with
+ * coopt_feed(), which copies them into a buffer supplied by you; results
+ * are then drained with coopt_feed_next() until it returns
+ * COOPT_RESULT_MORE (or terminates). Only a few elements are held at a
+ * time, so the buffer needs to be at least COOPT_FEED_TOKENS times the
+ * longest element you'll accept; if it fills up before coopt can decide
+ * what's what, coopt_feed_next() returns COOPT_RESULT_ERROR.
+ *
+ * 'state' can be configured as usual after coopt_feed_init(), except that
+ * coopt_classify(), coopt_permute(), coopt_collect() and coopt_diagnose()
+ * can't be used with it. Strings in results point into the buffer, and
+ * are only valid until the next call to coopt_feed() or
+ * coopt_feed_next().
+ */
+#define COOPT_FEED_TOKENS (2) /* the most coopt() needs to look at */
+
+struct coopt_feed
+{
+  struct coopt_state state;
+  char * buffer;
+  size_t size;
+  size_t used; /* bytes in buffer */
+  size_t partial; /* start of the element not yet terminated */
+  char const * tokens[COOPT_FEED_TOKENS]; /* complete elements in buffer */
+  int num_tokens;
+  int ended; /* non-zero once coopt_feed_end() has been called */
+};
+
+COOPT_API void coopt_feed_init(struct coopt_feed * /*feed*/,
+			       struct coopt_option const * /*options*/,
+			       unsigned int /*num_options*/,
+			       char * /*buffer*/, size_t /*size*/);
+
+/*
+ * Returns how many bytes were taken; if that's less than 'len', drain
+ * some results and feed the rest in again.
+ */
+COOPT_API size_t coopt_feed(struct coopt_feed * /*feed*/,
+			    char const * /*bytes*/, size_t /*len*/);
+
+/* No more to come; any unterminated element is taken to be complete */
+COOPT_API void coopt_feed_end(struct coopt_feed * /*feed*/);
+
+COOPT_API struct coopt_return coopt_feed_next(struct coopt_feed * /*feed*/);
+
+/*
+ * Split a command line held as a single string into elements, following
+ * POSIX sh quoting rules (single quotes, double quotes and backslashes),
+ * ready to pass to coopt_init(). 'line' is modified in place, and the
+ * elements point into it; those without any quoting aren't moved at all.
+ * Nothing else is special, so there's no expansion of any sort.
+ *
+ * Returns the number of elements, of which at most 'max_argv' are stored
+ * in 'argv' (so if it's more, you need a bigger array and a fresh copy
+ * of the line), or -1 if a quote isn't closed or the line ends with a
+ * backslash.
+ */
+COOPT_API int coopt_tokenise(char * /*line*/, char const ** /*argv*/,
+			     int /*max_argv*/);
+
+/* The (32 bit FNV-1a) hash used by the index */
+COOPT_API unsigned long coopt_index_hash(unsigned long /*seed*/,
+					 char const * /*name*/,
+					 size_t /*len*/);
+
+/*
+ * Everything coopt() returned successfully, collected as it goes so you
+ * can ask about any option afterwards in constant time. There's one
+ * coopt_parsed_option for each option in the index, in the same order;
+ * parameters (and arguments) given are kept in 'values', each chained to
+ * the next one for the same option.
+ */
+struct coopt_parsed_option
+{
+  unsigned int count; /* number of times given */
+  int first; /* first of its parameters in 'values', or -1 */
+  int last; /* last of its parameters in 'values', or -1 */
+};
+
+struct coopt_parsed_value
+{
+  char const * param;
+  int next; /* next parameter for the same option, or -1 */
+};
+
+/*
+ * The values and options arrays are kept together in one block of memory
+ * supplied by you, of COOPT_PARSED_SIZE(num_options, argc) bytes, where
+ * argc is as given to coopt_init(); this is always enough.
+ */
+struct coopt_parsed
+{
+  struct coopt_index const * index;
+  struct coopt_parsed_option * options;
+  struct coopt_parsed_option arguments; /* arguments, chained as above */
+  struct coopt_parsed_value * values;
+  unsigned int num_values;
+  unsigned int max_values;
+};
+
+#define COOPT_PARSED_SIZE(num_options, argc) \
+	((argc)*sizeof(struct coopt_parsed_value) + \
+	 (num_options)*sizeof(struct coopt_parsed_option))
+
+COOPT_API void coopt_parsed_init(struct coopt_parsed * /*parsed*/,
+				 struct coopt_index const * /*index*/,
+				 int /*argc*/, void * /*space*/);
+
+/*
+ * Have coopt() (and coopt_arguments()) note everything they return
+ * successfully in 'parsed' (clearing anything noted before). Pass NULL
+ * to stop.
+ */
+COOPT_API void coopt_collect(struct coopt_state * /*state*/,
+			     struct coopt_parsed * /*parsed*/);
+
+/* Used by coopt() to note a result; only COOPT_RESULT_OKAY is noted */
+COOPT_API void coopt_parsed_note(struct coopt_parsed * /*parsed*/,
+				 struct coopt_return const * /*ret*/);
+
+/*
+ * Find an option's entry, from a pointer into the option array, its short
+ * option or its long option. NULL if there's no such option (so it can't
+ * have been given); otherwise look at 'count' to see if it was.
+ */
+COOPT_API struct coopt_parsed_option const *
+coopt_parsed_option(struct coopt_parsed const * /*parsed*/,
+		    struct coopt_option const * /*opt*/);
+COOPT_API struct coopt_parsed_option const *
+coopt_parsed_short(struct coopt_parsed const * /*parsed*/, char /*c*/);
+COOPT_API struct coopt_parsed_option const *
+coopt_parsed_long(struct coopt_parsed const * /*parsed*/,
+		  char const * /*name*/);
+
+/*
+ * The last parameter given to an option (or argument, if you pass
+ * &parsed->arguments), or NULL. Follow 'first' and 'next' through
+ * parsed->values for all of them.
+ */
+COOPT_API char const *
+coopt_parsed_param(struct coopt_parsed const * /*parsed*/,
+		   struct coopt_parsed_option const * /*o*/);
+
+/*
+ * Every non-fatal error (see coopt_is_nonfatal()) coopt() runs into,
+ * noted down with where it was, while coopt() carries on past it; so
+ * you get back only successes, fatal errors and terminations, and can
+ * report all the problems at the end. 'element' counts from where argv
+ * was when coopt_diagnose() was called, and 'offset' is the number of
+ * characters into that element of the option's character (for short
+ * options) or name (for long ones), or 0 for an element too long to look
+ * at.
+ */
+struct coopt_diagnostic
+{
+  int result;
+  int ambigresult;
+  int element;
+  int offset;
+  struct coopt_option const * opt;
+  char const * param;
+  char const * marker;
+};
+
+/*
+ * Up to 'max_entries' diagnostics are kept, in an array supplied by you;
+ * 'count' is how many there were, which may be more.
+ */
+struct coopt_diagnostics
+{
+  struct coopt_diagnostic * entries;
+  unsigned int max_entries;
+  unsigned int num_entries;
+  unsigned long count;
+  char const * const * argv; /* where elements are counted from */
+};
+
+COOPT_API void coopt_diagnostics_init(struct coopt_diagnostics * /*diag*/,
+				      struct coopt_diagnostic * /*entries*/,
+				      unsigned int /*max_entries*/);
+
+/*
+ * Have coopt() note non-fatal errors in 'diag' (clearing anything noted
+ * before) and carry on. Pass NULL to go back to returning them.
+ */
+COOPT_API void coopt_diagnose(struct coopt_state * /*state*/,
+			      struct coopt_diagnostics * /*diag*/);
+
+/* Used by coopt() to note a non-fatal error, just after it happened */
+COOPT_API void coopt_diagnostics_note(struct coopt_diagnostics * /*diag*/,
+				      struct coopt_state const * /*state*/,
+				      struct coopt_return const * /*ret*/);
+
+/* A diagnostic as coopt() would have returned it */
+COOPT_API struct coopt_return
+coopt_diagnostic_return(struct coopt_diagnostic const * /*d*/);
+
+/*
+ * All the diagnostics kept, each as coopt_serror() would describe it,
+ * preceded by where it was ("3:1: ") and followed by a newline. Like
+ * coopt_serror(), it returns the number of characters written, and
+ * stops when it runs out of room; a last line without its newline was
+ * cut short.
+ */
+COOPT_API size_t
+coopt_serror_diagnostics(char * /*buffer*/, size_t /*bufsize*/,
+			 struct coopt_diagnostics const * /*diag*/,
+			 struct coopt_state * /*state*/);
+
+/*
+ * A cache of the results of whole command lines, for programs that parse
+ * the same ones over and over. Each entry is keyed by the contents of argv
+ * and the state's configuration (flags, separator, long_eq, markers and
+ * limits), and holds the results as coopt() returned them; a hit just
+ * copies them out, pointed at the new argv, without running coopt() at
+ * all. Entries go in a fixed number of fixed-size slots, in a block of
+ * memory supplied by you of COOPT_CACHE_SIZE(slots, slot_size) bytes
+ * (aligned as from malloc()), and the least recently used is thrown out
+ * when a new one needs the space. Command lines too big for a slot just
+ * aren't cached.
+ *
+ * Set 'lock' and 'unlock' if the cache is shared between threads; they're
+ * called with 'lock_data' around everything that looks at the slots.
+ */
+struct coopt_cache_slot
+{
+  unsigned long hash;
+  size_t key_size; /* bytes of key at the start of the data */
+  size_t size; /* bytes of data in all */
+  unsigned int num_results;
+  unsigned long counted; /* state->num_results after them */
+  int newer, older; /* in order of use, or the free list (older only) */
+  int chain; /* next slot in the same bucket, or -1 */
+};
+
+struct coopt_cache
+{
+  /* Counters, which you can read (or reset) whenever you like */
+  unsigned long lookups; /* calls that could use the cache */
+  unsigned long hits;
+  unsigned long collisions; /* slots with the right hash but wrong key */
+  unsigned long evictions;
+
+  void (*lock)(void *); /* or NULL */
+  void (*unlock)(void *);
+  void * lock_data;
+
+  /* Ignore this if you're a user */
+  struct coopt_option const * options;
+  unsigned int num_options;
+  unsigned long fingerprint; /* hash of the options */
+  struct coopt_cache_slot * slots;
+  int * buckets;
+  unsigned char * data;
+  unsigned int num_slots;
+  size_t slot_size;
+  unsigned long mask; /* number of buckets - 1 (it's a power of two) */
+  int newest, oldest; /* slots in use, or -1 */
+  int free; /* unused slots, or -1 */
+};
+
+#define COOPT_CACHE_SIZE(slots, slot_size) \
+	((slots)*(sizeof(struct coopt_cache_slot) + 2*sizeof(int) + \
+		  (slot_size)))
+
+COOPT_API void coopt_cache_init(struct coopt_cache * /*cache*/,
+				struct coopt_option const * /*options*/,
+				unsigned int /*num_options*/,
+				unsigned int /*slots*/, size_t /*slot_size*/,
+				void * /*space*/);
+
+/*
+ * Run 'state', which must be fresh from coopt_init(), until it terminates
+ * or has a fatal error (as repeated calls of coopt() would), from the
+ * cache if possible. Up to 'max_results' results are stored in 'results',
+ * and the number there were is returned (counting the termination, or
+ * the fatal error that stopped it); if that's more, call it again on a
+ * fresh state with a bigger array, which will be a hit. The state is
+ * used up either way, with state->num_results as coopt() would have
+ * left it.
+ *
+ * The cache is only used if the state's options are those the cache was
+ * set up with, and nothing else is watching the parse: with
+ * coopt_use_namespaces(), coopt_constrain(), coopt_collect(),
+ * coopt_diagnose(), coopt_trace(), coopt_classify() or coopt_permute(), it
+ * just runs coopt().
+ */
+COOPT_API int coopt_cache_run(struct coopt_cache * /*cache*/,
+			      struct coopt_state * /*state*/,
+			      struct coopt_return * /*results*/,
+			      int /*max_results*/);
+
+/*
+ * The cache can be saved (eg: to a file) and loaded back into another
+ * with the same options, so it's warm from the start. Like index images,
+ * saved caches are only portable between machines with the same byte
+ * order and size of int. coopt_cache_write() returns the size needed, and
+ * only writes it if 'size' is big enough; coopt_cache_read() returns the
+ * number of entries loaded (the most recently used last, so they're
+ * the ones that stay if there's no room for all of them), or -1 if it
+ * can't be used with this cache. Entries read are checked to be safe, but
+ * not to be right, so only read what you wrote.
+ */
+#define COOPT_CACHE_MAGIC	(0x48434143) /* "CACH" */
+#define COOPT_CACHE_VERSION	(1)
+
+COOPT_API size_t coopt_cache_write(struct coopt_cache * /*cache*/,
+				   void * /*buffer*/, size_t /*size*/);
+COOPT_API int coopt_cache_read(struct coopt_cache * /*cache*/,
+			       void const * /*image*/, size_t /*size*/);
+
+/*
+ * Option tables that can be replaced while other threads are parsing
+ * with them. A reader takes the current table with coopt_table_acquire(),
+ * parses with it (coopt_table_init() sets up a state for it) and gives it
+ * back with coopt_table_release(); coopt_tables_swap() puts a new table
+ * in place for readers that come after. A table swapped out is handed to
+ * 'retire' once no reader can be using it, so you can free it.
+ *
+ * Readers never wait: each one is counted against the parity of 'epoch'
+ * it started in, and the epoch only moves on once the readers from the
+ * epoch before last have all gone, so a table swapped out in epoch e is
+ * finished with once the epoch reaches e+2. That's checked whenever a
+ * table is swapped, and by coopt_tables_reclaim(); swaps and reclaims
+ * must be made by one thread at a time.
+ *
+ * This uses GCC's __atomic builtins. Other compilers call 'lock' and
+ * 'unlock' (if set) with 'lock_data' around readers' and swaps' changes.
+ */
+struct coopt_table
+{
+  struct coopt_option const * options;
+  unsigned int num_options;
+  struct coopt_index const * index; /* or NULL */
+  void * data; /* for your own use */
+  unsigned long version; /* set by coopt_tables_init() and _swap() */
+
+  /* Ignore this if you're a user */
+  unsigned long retired_epoch;
+  struct coopt_table * next_retired;
+};
+
+struct coopt_tables
+{
+  void (*retire)(void *, struct coopt_table *); /* or NULL */
+  void * retire_data;
+
+  void (*lock)(void *); /* or NULL */
+  void (*unlock)(void *);
+  void * lock_data;
+
+  /* Ignore this if you're a user */
+  struct coopt_table * current;
+  unsigned long version;
+  unsigned long epoch;
+  unsigned long readers[2]; /* by parity of epoch */
+  struct coopt_table * retired; /* oldest first */
+  struct coopt_table * last_retired;
+};
+
+COOPT_API void coopt_tables_init(struct coopt_tables * /*tables*/,
+				 struct coopt_table * /*first*/);
+
+/*
+ * The current table, which stays usable until you release it; pass
+ * release the same 'ticket' you got from acquire.
+ */
+COOPT_API struct coopt_table const *
+coopt_table_acquire(struct coopt_tables * /*tables*/,
+		    unsigned int * /*ticket*/);
+COOPT_API void coopt_table_release(struct coopt_tables * /*tables*/,
+				   unsigned int /*ticket*/);
+
+/* coopt_init() with the table's options, and its index if it has one */
+COOPT_API void coopt_table_init(struct coopt_state * /*state*/,
+				struct coopt_table const * /*table*/,
+				int /*argc*/, char const * const * /*argv*/);
+
+/*
+ * Put 'next' in place of the current table, returning its version; then
+ * retire whatever can be. coopt_tables_reclaim() just does the latter,
+ * returning the number of tables still waiting to be retired.
+ */
+COOPT_API unsigned long coopt_tables_swap(struct coopt_tables * /*tables*/,
+					  struct coopt_table * /*next*/);
+COOPT_API unsigned int coopt_tables_reclaim(struct coopt_tables * /*tables*/);
+
+/*
+ * Turning results back into a command line, eg: to pass on to another
+ * program. Options are written in a canonical form (long if they have a
+ * long option, unless prefer_short is set), with their parameters as the
+ * flags say, into an arena of 'size' bytes supplied by you; everything
+ * else, including arguments and parameters in elements of their own, is
+ * pointed at where coopt() found it, without being copied. 'argv' has
+ * room for 'max_argc' pointers, and is always NULL-terminated, so it can
+ * be given to execve() (cast to char * const *) whenever you like.
+ *
+ * An argument that could be taken for an option has 'separator' put in
+ * front of it; after that, no more options can be emitted.
+ */
+struct coopt_emitter
+{
+  /* You can change these having initialised it with coopt_emitter_init() */
+  struct coopt_emitter_flags
+  {
+    unsigned int prefer_short		: 1; /* "-v", not "--verbose" */
+    unsigned int long_eq_params		: 1; /* "--value=this", not
+					      * "--value" "this"
+					      */
+    unsigned int short_inline_params	: 1; /* "-vthis", not "-v" "this" */
+  } flags;
+  char const * separator; /* or NULL to never put one in */
+  char const * long_eq;
+  char const * long_marker; /* a marker definition, eg: "L--" */
+  char const * short_marker; /* eg: "S-" */
+
+  /* Ignore this if you're a user */
+  char const ** argv;
+  int argc;
+  int max_argc;
+  char * arena;
+  size_t used; /* bytes of arena used */
+  size_t size;
+  int separated; /* non-zero once we've put the separator in */
+};
+
+COOPT_API void coopt_emitter_init(struct coopt_emitter * /*emitter*/,
+				  char const ** /*argv*/, int /*max_argc*/,
+				  char * /*arena*/, size_t /*size*/);
+
+/*
+ * Add a result (an option or argument, as returned by coopt()) to the
+ * end. Returns 0, or -1 if there isn't room in argv or the arena, or -2
+ * if it isn't something that can be emitted (an error, or an option
+ * after the separator); either way, nothing is added.
+ */
+COOPT_API int coopt_emit(struct coopt_emitter * /*emitter*/,
+			 struct coopt_return const * /*ret*/);
+
+/* Add an element as it is (eg: the program name); 0, or -1 if no room */
+COOPT_API int coopt_emit_element(struct coopt_emitter * /*emitter*/,
+				 char const * /*element*/);
+
+/* The number of elements in argv so far */
+COOPT_API int coopt_emitted(struct coopt_emitter const * /*emitter*/);
+
+/*
+ * A fingerprint of a command line: the same for any two command lines that
+ * mean the same thing, however they were written. Short and long forms,
+ * abbreviations, and the different ways of giving a parameter all come to
+ * the same thing, and COOPT_UNORDERED options (with their parameters) can
+ * come in any order; other options and arguments can't. The option table
+ * itself isn't part of it, so fold in something identifying the program if
+ * fingerprints from different ones might meet.
+ *
+ * Runs the state to the end of the command line (or a fatal error), and
+ * returns the result it stopped on; errors before that are part of the
+ * fingerprint. The hash is the same on any machine.
+ */
+struct coopt_fingerprint
+{
+  unsigned long hash[4]; /* 32 bits in each */
+};
+
+COOPT_API int coopt_fingerprint(struct coopt_state * /*state*/,
+				struct coopt_fingerprint * /*fingerprint*/);
+
+/*
+ * Scopes: where options apply to the next argument (as in
+ * "-c:v x in1 -c:v y in2"), or to everything between a pair of options
+ * (as in "--start-group a b --end-group"), coopt_scopes() works out which
+ * options go with what in one pass, into arrays you supply.
+ *
+ * Each argument's scope is the run of options just before it (and the
+ * argument itself); a run of options with no argument after it gets a
+ * scope of its own, with an 'argument' of -1. An option with the
+ * COOPT_SCOPE_OPEN attribute starts a group, which runs up to and
+ * including the next COOPT_SCOPE_CLOSE option; groups can be nested, and
+ * an option with both attributes ends one group and starts the next.
+ * Options before a group's opening or closing option don't carry over to
+ * the argument after it.
+ *
+ * Scopes are stored in the order they start, so a group comes before the
+ * scopes in it, and each covers 'num' results from 'first', including any
+ * scopes in it. No scope is empty, so there are never more scopes than
+ * results.
+ */
+struct coopt_scope
+{
+  int first; /* index in results of its first result */
+  int num; /* the number of results in it */
+  int argument; /* index in results of its argument, or -1 */
+  int parent; /* index in scopes of the group it's in, or -1 */
+  int group; /* non-zero for a group, whose first result is the option
+	      * that opened it
+	      */
+};
+
+struct coopt_scopes
+{
+  struct coopt_return * results;
+  int max_results;
+  int num_results;
+  struct coopt_scope * scopes;
+  int max_scopes;
+  int num_scopes;
+};
+
+COOPT_API void coopt_scopes_init(struct coopt_scopes * /*scopes*/,
+				 struct coopt_return * /*results*/,
+				 int /*max_results*/,
+				 struct coopt_scope * /*scope*/,
+				 int /*max_scopes*/);
+
+/*
+ * Run 'state' until it terminates or has a fatal error (as repeated calls
+ * of coopt() would), storing the results and building the scopes. Returns
+ * the result it stopped on, or COOPT_RESULT_TOOMANY if there wasn't room.
+ * Non-fatal errors (and a missing parameter) are stored like anything
+ * else, and unbalanced groups are marked as COOPT_RESULT_UNBALANCED in
+ * place; COOPT_RESULT_END, and fatal errors, aren't stored.
+ */
+COOPT_API int coopt_scopes(struct coopt_state * /*state*/,
+			   struct coopt_scopes * /*scopes*/);
+
+/*
+ * Tracing: to find out what coopt() did, and when, give the state a ring
+ * buffer of events with coopt_trace(). Each event records the cycle
+ * counter (where we know how to read one; otherwise it counts events),
+ * which element and character coopt() was on, counting elements from
+ * where tracing started, and what happened:
+ *
+ *   COOPT_TRACE_MARKER		'detail' is the marker matched, as an index
+ *				into state->markers, or -1 for an argument
+ *   COOPT_TRACE_SEPARATOR	the separator
+ *   COOPT_TRACE_SHORT		a short option was looked up; 'option' is
+ *				what was found, and 'detail' the character
+ *   COOPT_TRACE_LONG		likewise a long option, and 'detail' the
+ *				length looked up (before any long_eq)
+ *   COOPT_TRACE_SKIP		'detail' is 1 when skip_next_arg is set (the
+ *				next element is a short option's
+ *				parameter), and 0 when it's skipped
+ *   COOPT_TRACE_RESULT		'detail' is the result code
+ *
+ * 'option' is an index into the table the option came from (its namespace
+ * if there are any), or -1. Once the ring is full, each event overwrites
+ * the oldest. Only the thread parsing writes events, without locking;
+ * coopt_trace_write() can be called from anywhere, and leaves out any that
+ * were overwritten while it was copying them. It writes a header (native
+ * byte order and sizes, as with images) and the events, oldest first,
+ * returning the size it needs; room for COOPT_TRACE_SIZE(max_events)
+ * bytes is always enough. coopt_trace_events() finds the events in what
+ * it wrote, returning how many there are, or -1 if it isn't a trace.
+ *
+ * With no trace (the default), each place an event could be written costs
+ * a single test. Tracing doesn't work with coopt_feed_init().
+ */
+#define COOPT_TRACE_MARKER	(1)
+#define COOPT_TRACE_SEPARATOR	(2)
+#define COOPT_TRACE_SHORT	(3)
+#define COOPT_TRACE_LONG	(4)
+#define COOPT_TRACE_SKIP	(5)
+#define COOPT_TRACE_RESULT	(6)
+
+struct coopt_trace_event
+{
+  unsigned long time_hi, time_lo; /* 32 bits of the cycle counter in each */
+  int kind; /* COOPT_TRACE_MARKER etc */
+  int element;
+  int offset; /* char_within_arg */
+  int option;
+  int detail;
+};
+
+struct coopt_trace
+{
+  struct coopt_trace_event * events;
+  unsigned long mask; /* size of events - 1 (it's a power of two) */
+  unsigned long head; /* the number of events ever written */
+  char const * const * argv; /* where elements are counted from */
+};
+
+#define COOPT_TRACE_MAGIC	(0x43525443) /* "CTRC" */
+#define COOPT_TRACE_VERSION	(1)
+#define COOPT_TRACE_SIZE(max_events) \
+	(6*sizeof(unsigned long) + \
+	 (max_events)*sizeof(struct coopt_trace_event))
+
+/*
+ * Only the largest power of two up to max_events are used, and the last
+ * one fewer than that number of events are kept
+ */
+COOPT_API void coopt_trace_init(struct coopt_trace * /*trace*/,
+				struct coopt_trace_event * /*events*/,
+				unsigned long /*max_events*/);
+
+/* Start tracing 'state' into 'trace' (or stop, if it's NULL) */
+COOPT_API void coopt_trace(struct coopt_state * /*state*/,
+			   struct coopt_trace * /*trace*/);
+
+COOPT_API size_t coopt_trace_write(struct coopt_trace * /*trace*/,
+				   void * /*buffer*/, size_t /*size*/);
+COOPT_API int coopt_trace_events(void const * /*buffer*/, size_t /*size*/,
+				 struct coopt_trace_event const ** /*events*/);
+
+/* Used by coopt() to write events */
+COOPT_API void coopt_trace_note(struct coopt_state * /*state*/, int /*kind*/,
+				int /*option*/, int /*detail*/);
+COOPT_API void coopt_trace_result(struct coopt_state * /*state*/,
+				  struct coopt_option const * /*opt*/,
+				  char const * /*marker*/, int /*result*/);
+
+/*
+ * Incremental re-parsing: for a command line being edited (as in a shell
+ * or an IDE), coopt_incremental() parses it much as coopt_scopes() does,
+ * storing the results in an array you supply, and noting checkpoints
+ * along the way at boundaries between elements. When elements in the
+ * middle change, coopt_reparse() starts again from the last checkpoint
+ * before them, and stops as soon as it reaches a boundary after them that
+ * it was at before, in the same state; everything from there on is kept,
+ * moved along if the number of results before it changed.
+ *
+ * The first parse should be of a state as coopt_init() left it; neither
+ * works with classification, permutation, constraints, collection or
+ * diagnostics (they return COOPT_RESULT_ERROR). When the checkpoints run
+ * out, every other one is dropped and the rest kept twice as far apart,
+ * so any number of them is enough, but the more there are the less is
+ * parsed again.
+ */
+struct coopt_checkpoint
+{
+  int element; /* the next element to be started on */
+  int result; /* index in results of the next result */
+  int separated; /* non-zero after the separator */
+  unsigned long num_results; /* state->num_results at this point */
+};
+
+struct coopt_incremental
+{
+  struct coopt_return * results;
+  int max_results;
+  int num_results;
+  struct coopt_checkpoint * checkpoints;
+  int max_checkpoints;
+  int num_checkpoints;
+  int first_changed; /* results parsed by the last call start here */
+  int num_changed; /* and there are this many */
+
+  /* Ignore this if you're a user */
+  char const * const * argv;
+  int argc;
+  int spacing;
+  int end_result; /* what the last call returned */
+  int ran_out; /* non-zero if that was for want of room */
+  int end_element; /* and where it left the state */
+  int end_char_within_arg;
+  unsigned int end_skip_next_arg;
+  char const * end_marker;
+  unsigned long end_num_results;
+};
+
+COOPT_API void coopt_incremental_init(struct coopt_incremental * /*inc*/,
+				      struct coopt_return * /*results*/,
+				      int /*max_results*/,
+				      struct coopt_checkpoint * /*checkpoints*/,
+				      int /*max_checkpoints*/);
+
+/*
+ * Run 'state' until it terminates or has a fatal error, storing the
+ * results, just as coopt_scopes() would. Returns the result it stopped
+ * on, or COOPT_RESULT_TOOMANY if there wasn't room.
+ */
+COOPT_API int coopt_incremental(struct coopt_state * /*state*/,
+				struct coopt_incremental * /*inc*/);
+
+/*
+ * The command line is now 'argc' elements in 'argv' (which needn't be
+ * where it was before), 'removed' elements from 'first' having been
+ * replaced by 'added' new ones; elements before 'first', and after those
+ * removed, must be the same strings as before (not copies, since results
+ * kept point into them). The results, and 'state', end up as a full parse
+ * of the new command line would leave them, and the return value is the
+ * same; the results parsed again are described by first_changed and
+ * num_changed.
+ */
+COOPT_API int coopt_reparse(struct coopt_state * /*state*/,
+			    struct coopt_incremental * /*inc*/,
+			    int /*argc*/, char const * const * /*argv*/,
+			    int /*first*/, int /*removed*/, int /*added*/);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,369 @@
+/*
+ * $Id$
+ * coopt.hpp
+ *
+ * C++ interface to coopt, the Tartarus option parsing library
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Parsing as a C++20 range:
+ *
+ *   for (auto &&r : coopt_cxx::parse(options, argc-1, argv+1))
+ *   {
+ *     if (r.is_error())
+ *       ...
+ *     else if (r.is_argument())
+ *       use(r.param());
+ *     else
+ *       ...
+ *   }
+ *
+ * Each step is one call to coopt(), made when the iterator is
+ * incremented; nothing is allocated. You get every result coopt() returns
+ * up to COOPT_RESULT_END (which isn't yielded), or up to and including
+ * the first error. Strings are std::string_views onto argv, so they live
+ * as long as argv does.
+ *
+ * coopt_cxx::generate() does the same as a coroutine, for use in range
+ * pipelines. Unlike the range, its coroutine frame is allocated (unless
+ * your compiler manages to elide it).
+ */
+
+#ifndef COOPT_HPP
+#define COOPT_HPP
+
+#include "coopt.h"
+
+#include <cstddef>
+#include <iterator>
+#include <ranges>
+#include <span>
+#include <string_view>
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+#include <coroutine>
+#include <exception>
+#define COOPT_HPP_GENERATOR 1
+#endif
+
+/* not 'coopt', which would clash with coopt() */
+namespace coopt_cxx
+{
+
+/* One coopt_return, with its strings as std::string_views */
+class result
+{
+public:
+  result() noexcept : ret_() {}
+  explicit result(coopt_return const &ret) noexcept : ret_(ret) {}
+
+  int code() const noexcept { return ret_.result; }
+  int ambigcode() const noexcept { return ret_.ambigresult; }
+  coopt_option const *opt() const noexcept { return ret_.opt; }
+  coopt_option const *related() const noexcept { return ret_.related; }
+
+  bool is_okay() const noexcept { return coopt_is_okay(ret_.result); }
+  bool is_error() const noexcept { return coopt_is_error(ret_.result); }
+  bool is_argument() const noexcept
+  {
+    return ret_.result==COOPT_RESULT_OKAY && ret_.opt==nullptr;
+  }
+  bool is_option() const noexcept
+  {
+    return ret_.result==COOPT_RESULT_OKAY && ret_.opt!=nullptr;
+  }
+
+  /* argument text, or the option's parameter; empty if there wasn't one */
+  bool has_param() const noexcept { return ret_.param!=nullptr; }
+  std::string_view param() const noexcept
+  {
+    return view(ret_.param);
+  }
+  /* the marker as given to coopt, eg: "L--" (empty for an argument) */
+  std::string_view marker() const noexcept
+  {
+    return view(ret_.marker);
+  }
+  /* what the user actually typed to introduce the option, eg: "--" */
+  std::string_view marker_text() const noexcept
+  {
+    return (ret_.marker==nullptr) ? std::string_view() : view(ret_.marker+1);
+  }
+  bool is_long() const noexcept
+  {
+    return ret_.marker!=nullptr && ret_.marker[0]=='L';
+  }
+
+  coopt_return const &raw() const noexcept { return ret_; }
+
+private:
+  static std::string_view view(char const *s) noexcept
+  {
+    return (s==nullptr) ? std::string_view() : std::string_view(s);
+  }
+
+  coopt_return ret_;
+};
+
+/*
+ * The range returned by parse(). It owns the coopt_state, which you can
+ * get at with state() to change the flags, separator or markers before
+ * you start iterating. It can't be copied or moved, as its iterators
+ * point back into it.
+ */
+class range
+{
+public:
+  class iterator
+  {
+  public:
+    using value_type = result;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::input_iterator_tag;
+
+    iterator() noexcept : range_(nullptr) {}
+    explicit iterator(range *r) noexcept : range_(r) {}
+
+    result const &operator*() const noexcept { return range_->current_; }
+    result const *operator->() const noexcept { return &range_->current_; }
+    iterator &operator++() noexcept
+    {
+      range_->next();
+      return *this;
+    }
+    void operator++(int) noexcept { range_->next(); }
+
+    friend bool operator==(iterator const &i, std::default_sentinel_t) noexcept
+    {
+      return i.at_end();
+    }
+
+  private:
+    bool at_end() const noexcept
+    {
+      return range_==nullptr || range_->done_;
+    }
+
+    range *range_;
+  };
+
+  range(coopt_option const *options, unsigned int num_options,
+	int argc, char const * const *argv) noexcept
+    : current_(), started_(false), done_(false)
+  {
+    coopt_init(&state_, options, num_options, argc, argv);
+  }
+  range(range const &) = delete;
+  range &operator=(range const &) = delete;
+
+  coopt_state &state() noexcept { return state_; }
+
+  iterator begin() noexcept
+  {
+    if (!started_)
+      next();
+    return iterator(this);
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  void next() noexcept
+  {
+    if (done_)
+      return;
+    if (started_ && !current_.is_okay())
+    {
+      /* we've just yielded an error */
+      done_ = true;
+      return;
+    }
+    started_ = true;
+    current_ = result(::coopt(&state_));
+    if (current_.code()==COOPT_RESULT_END)
+      done_ = true;
+  }
+
+  coopt_state state_;
+  result current_;
+  bool started_;
+  bool done_;
+};
+
+/* Note that as with coopt_init(), argc and argv don't include argv[0] */
+inline range parse(std::span<coopt_option const> options,
+		   int argc, char const * const *argv) noexcept
+{
+  return range(options.data(), static_cast<unsigned int>(options.size()),
+	       argc, argv);
+}
+
+inline range parse(std::span<coopt_option const> options,
+		   int argc, char **argv) noexcept
+{
+  return parse(options, argc, const_cast<char const * const *>(argv));
+}
+
+#ifdef COOPT_HPP_GENERATOR
+
+/*
+ * A minimal single-pass generator (std::generator is C++23). It's a
+ * view, so it can be used in pipelines:
+ *
+ *   for (auto &&arg : coopt_cxx::generate(options, argc-1, argv+1)
+ *                     | std::views::filter(&coopt_cxx::result::is_argument))
+ */
+template <typename T>
+class generator : public std::ranges::view_base
+{
+public:
+  struct promise_type
+  {
+    T const *value = nullptr;
+
+    generator get_return_object() noexcept
+    {
+      return generator(handle::from_promise(*this));
+    }
+    std::suspend_always initial_suspend() const noexcept { return {}; }
+    std::suspend_always final_suspend() const noexcept { return {}; }
+    std::suspend_always yield_value(T const &v) noexcept
+    {
+      value = &v;
+      return {};
+    }
+    void return_void() const noexcept {}
+    void unhandled_exception() { throw; }
+  };
+  using handle = std::coroutine_handle<promise_type>;
+
+  class iterator
+  {
+  public:
+    using value_type = T;
+    using difference_type = std::ptrdiff_t;
+    using iterator_concept = std::input_iterator_tag;
+
+    iterator() noexcept : coro_(nullptr) {}
+    explicit iterator(handle coro) noexcept : coro_(coro) {}
+
+    T const &operator*() const noexcept { return *coro_.promise().value; }
+    T const *operator->() const noexcept { return coro_.promise().value; }
+    iterator &operator++()
+    {
+      coro_.resume();
+      return *this;
+    }
+    void operator++(int) { coro_.resume(); }
+
+    friend bool operator==(iterator const &i, std::default_sentinel_t) noexcept
+    {
+      return !i.coro_ || i.coro_.done();
+    }
+
+  private:
+    handle coro_;
+  };
+
+  generator() noexcept : coro_(nullptr) {}
+  generator(generator &&other) noexcept : coro_(other.coro_)
+  {
+    other.coro_ = nullptr;
+  }
+  generator &operator=(generator &&other) noexcept
+  {
+    if (this!=&other)
+    {
+      if (coro_)
+	coro_.destroy();
+      coro_ = other.coro_;
+      other.coro_ = nullptr;
+    }
+    return *this;
+  }
+  ~generator()
+  {
+    if (coro_)
+      coro_.destroy();
+  }
+
+  iterator begin()
+  {
+    if (coro_)
+      coro_.resume();
+    return iterator(coro_);
+  }
+  std::default_sentinel_t end() const noexcept { return {}; }
+
+private:
+  explicit generator(handle coro) noexcept : coro_(coro) {}
+
+  handle coro_;
+};
+
+/*
+ * Drive a coopt_state you've already initialised (and configured); it
+ * must outlive the generator.
+ */
+inline generator<result> generate(coopt_state &state)
+{
+  for (;;)
+  {
+    result r(::coopt(&state));
+    if (r.code()==COOPT_RESULT_END)
+      co_return;
+    co_yield r;
+    if (!r.is_okay())
+      co_return;
+  }
+}
+
+inline generator<result> generate(std::span<coopt_option const> options,
+				  int argc, char const * const *argv)
+{
+  coopt_state state;
+  coopt_init(&state, options.data(),
+	     static_cast<unsigned int>(options.size()), argc, argv);
+  for (;;)
+  {
+    result r(::coopt(&state));
+    if (r.code()==COOPT_RESULT_END)
+      co_return;
+    co_yield r;
+    if (!r.is_okay())
+      co_return;
+  }
+}
+
+#endif /* COOPT_HPP_GENERATOR */
+
+} /* namespace coopt_cxx */
+
+#endif /* COOPT_HPP */
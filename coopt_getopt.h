@@ -0,0 +1,152 @@
+/*
+ * $Id$
+ * coopt_getopt.h
+ *
+ * getopt() and getopt_long() compatibility layer for coopt, the Tartarus
+ * option parsing library.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Include this instead of <unistd.h>'s getopt() or <getopt.h>, and link
+ * against libcoopt, and existing getopt()/getopt_long() code will run on
+ * coopt without further changes. The usual globals (optind, optarg,
+ * optopt, opterr) are provided, but they're only a view onto a default
+ * struct coopt_getopt_data; the _r variants take that structure
+ * explicitly, so there's no hidden global state if you use them.
+ *
+ * Differences from GNU getopt:
+ *   argv is only permuted once, when all options have been processed,
+ *   rather than being shuffled as we go (so it's O(n), not O(n^2))
+ *   getopt_long_only() and the "W;" extension aren't supported
+ *   error messages come from coopt_serror()
+ */
+
+#ifndef COOPT_GETOPT_H
+#define COOPT_GETOPT_H
+
+#include "coopt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * As for <getopt.h>. Don't include both.
+ */
+struct option
+{
+  char const * name;
+  int has_arg; /* no_argument, required_argument or optional_argument */
+  int * flag; /* if non-NULL, *flag=val and getopt_long() returns 0 */
+  int val;
+};
+
+#define no_argument		(0)
+#define required_argument	(1)
+#define optional_argument	(2)
+
+/*
+ * Everything getopt() would normally keep in globals. Initialise with
+ * COOPT_GETOPT_DATA_INITIALISER; the first four members behave exactly
+ * like the globals (so set ind to 0 or 1 to restart). They aren't called
+ * optind and so on because those may well be macros.
+ */
+struct coopt_getopt_data
+{
+  int ind; /* optind */
+  int err; /* opterr */
+  int opt; /* optopt */
+  char * arg; /* optarg */
+
+  /* Ignore this if you're a user */
+  int last_ind; /* what we last set ind to; if it's changed, restart */
+  int ordering; /* '+', '-' or 0 for permute */
+  int colon; /* non-zero if optstring started with ':' */
+  int finished; /* returned -1 once already */
+  char * const * argv;
+  struct coopt_state state;
+  struct coopt_option * options; /* malloc()ed: options, then permutation,
+				  * then the index's table
+				  */
+  unsigned int num_options;
+  char const * optstring;
+  struct option const * longopts;
+  int * permutation; /* for coopt_permute() (same block) */
+  int start; /* where in argv we started */
+  struct coopt_index index; /* of options */
+};
+
+#define COOPT_GETOPT_DATA_INITIALISER \
+	{ 1, 1, '?', NULL, 0, 0, 0, 0, NULL, { 0 }, NULL, 0, NULL, NULL, \
+	  NULL, 0, { 0 } }
+
+int coopt_getopt_r(int /*argc*/, char * const /*argv*/[],
+		   char const * /*optstring*/,
+		   struct coopt_getopt_data * /*data*/);
+int coopt_getopt_long_r(int /*argc*/, char * const /*argv*/[],
+			char const * /*optstring*/,
+			struct option const * /*longopts*/,
+			int * /*longindex*/,
+			struct coopt_getopt_data * /*data*/);
+
+/*
+ * The traditional interface, which isn't thread safe (because it uses
+ * the globals).
+ */
+extern int coopt_optind;
+extern int coopt_opterr;
+extern int coopt_optopt;
+extern char * coopt_optarg;
+
+int coopt_getopt(int /*argc*/, char * const /*argv*/[],
+		 char const * /*optstring*/);
+int coopt_getopt_long(int /*argc*/, char * const /*argv*/[],
+		      char const * /*optstring*/,
+		      struct option const * /*longopts*/,
+		      int * /*longindex*/);
+
+/*
+ * Unless told otherwise, map the usual names onto ours, so that we don't
+ * fight with the C library over who owns getopt() and optind.
+ */
+#ifndef COOPT_GETOPT_NO_RENAME
+#define getopt coopt_getopt
+#define getopt_long coopt_getopt_long
+#define optind coopt_optind
+#define opterr coopt_opterr
+#define optopt coopt_optopt
+#define optarg coopt_optarg
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* COOPT_GETOPT_H */
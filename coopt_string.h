@@ -0,0 +1,92 @@
+/*
+ * $Id$
+ * coopt_string.h
+ *
+ * The few C library string routines used inside coopt; not installed.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Normally these are just the C library's own. A freestanding build
+ * (configure --enable-freestanding, which defines COOPT_FREESTANDING)
+ * uses simple versions of our own instead, in freestanding.c, so that
+ * libcoopt doesn't need the C library at all.
+ */
+
+#ifndef COOPT_STRING_H
+#define COOPT_STRING_H
+
+#include <stddef.h>
+
+#ifndef COOPT_API
+#define COOPT_API
+#endif
+
+#ifdef COOPT_FREESTANDING
+
+COOPT_API size_t coopt_strlen(char const *);
+COOPT_API int coopt_strcmp(char const *, char const *);
+COOPT_API int coopt_strncmp(char const *, char const *, size_t);
+COOPT_API char *coopt_strchr(char const *, int);
+COOPT_API size_t coopt_strcspn(char const *, char const *);
+COOPT_API int coopt_memcmp(void const *, void const *, size_t);
+COOPT_API void *coopt_memchr(void const *, int, size_t);
+COOPT_API void *coopt_memcpy(void *, void const *, size_t);
+COOPT_API void *coopt_memmove(void *, void const *, size_t);
+COOPT_API void *coopt_memset(void *, int, size_t);
+
+#else
+
+#include <string.h>
+
+#define coopt_strlen strlen
+#define coopt_strcmp strcmp
+#define coopt_strncmp strncmp
+#define coopt_strchr strchr
+#define coopt_strcspn strcspn
+#define coopt_memcmp memcmp
+#define coopt_memchr memchr
+#define coopt_memcpy memcpy
+#define coopt_memmove memmove
+#define coopt_memset memset
+
+#endif
+
+/* Always ours (in strstr.c), so it's always linear */
+COOPT_API char *coopt_strstr(char const *, char const *);
+
+/*
+ * Copy 'n' characters of 's' to 'buffer' at 'written' and terminate it,
+ * giving 'n'; the caller has checked there's room.
+ */
+#define coopt_append(buffer, written, s, n) \
+	(coopt_memcpy((buffer)+(written), (s), (n)), \
+	 (buffer)[(written)+(n)]=0, (n))
+
+#endif /* COOPT_STRING_H */
@@ -0,0 +1,116 @@
+/*
+ * $Id$
+ * diagnose.c
+ *
+ * Implementation of coopt_diagnostics, the non-fatal errors found while
+ * parsing, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+void coopt_diagnostics_init(struct coopt_diagnostics *diag,
+			    struct coopt_diagnostic *entries,
+			    unsigned int max_entries)
+{
+  diag->entries = entries;
+  diag->max_entries = max_entries;
+  diag->argv = NULL;
+  coopt_diagnose(NULL, diag);
+}
+
+void coopt_diagnose(struct coopt_state *state, struct coopt_diagnostics *diag)
+{
+  if (state!=NULL)
+    state->diagnostics = diag;
+  if (diag!=NULL)
+  {
+    if (state!=NULL)
+      diag->argv = state->argv;
+    diag->num_entries = 0;
+    diag->count = 0;
+  }
+}
+
+/*
+ * Work out where (ret) was from how far coopt() has got. A short option
+ * leaves us just after its character (even if it's missing a parameter);
+ * a long option has been stepped over, along with its parameter if that
+ * was the next element; and an element that was too long has been
+ * stepped over.
+ */
+void coopt_diagnostics_note(struct coopt_diagnostics *diag,
+			    struct coopt_state const *state,
+			    struct coopt_return const *ret)
+{
+  struct coopt_diagnostic *d;
+  int element = state->argv - diag->argv;
+
+  diag->count++;
+  if (diag->num_entries>=diag->max_entries)
+    return;
+  d = diag->entries + diag->num_entries++;
+  d->result = ret->result;
+  d->ambigresult = ret->ambigresult;
+  d->opt = ret->opt;
+  d->param = ret->param;
+  d->marker = ret->marker;
+  if (ret->marker!=NULL && ret->marker[0]=='S')
+  {
+    d->element = element;
+    d->offset = state->char_within_arg - 1;
+  }
+  else if (ret->marker!=NULL)
+  {
+    if (ret->param!=NULL && ret->param==state->argv[-1])
+      element--;
+    d->element = element - 1;
+    d->offset = coopt_strlen(ret->marker+1);
+  }
+  else
+  {
+    d->element = element - 1;
+    d->offset = 0;
+  }
+}
+
+struct coopt_return coopt_diagnostic_return(struct coopt_diagnostic const *d)
+{
+  struct coopt_return ret;
+  ret.result = d->result;
+  ret.ambigresult = d->ambigresult;
+  ret.opt = d->opt;
+  ret.param = d->param;
+  ret.marker = d->marker;
+  ret.related = NULL;
+  return ret;
+}
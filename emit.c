@@ -0,0 +1,186 @@
+/*
+ * $Id$
+ * emit.c
+ *
+ * Implementation of coopt_emitter, which turns results back into a
+ * command line, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+static int coopt_emit_argument(struct coopt_emitter *, char const *);
+static char *coopt_emit_copy(char *, char const *, char const *);
+
+void coopt_emitter_init(struct coopt_emitter *emitter, char const **argv,
+			int max_argc, char *arena, size_t size)
+{
+  emitter->flags.prefer_short = 0;
+  emitter->flags.long_eq_params = 0;
+  emitter->flags.short_inline_params = 0;
+  emitter->separator = "--";
+  emitter->long_eq = "=";
+  emitter->long_marker = "L--";
+  emitter->short_marker = "S-";
+  emitter->argv = argv;
+  emitter->argc = 0;
+  emitter->max_argc = max_argc;
+  emitter->arena = arena;
+  emitter->used = 0;
+  emitter->size = size;
+  emitter->separated = 0;
+  if (max_argc>0)
+    argv[0] = NULL;
+}
+
+/*
+ * An option is written out in one piece of the arena, with its parameter
+ * if that goes in the same element; otherwise the parameter is the next
+ * element, pointing at wherever coopt() found it (which is always the
+ * end of an element of the original argv, so is terminated already).
+ * The pieces are short, so we copy them a character at a time, which
+ * also finds out if they fit as we go.
+ */
+int coopt_emit(struct coopt_emitter *emitter, struct coopt_return const *ret)
+{
+  struct coopt_option const *opt = ret->opt;
+  char const *end = emitter->arena + emitter->size;
+  char *start = emitter->arena + emitter->used, *out;
+  char name[2];
+  int same_element, elements;
+
+  if (ret->result!=COOPT_RESULT_OKAY)
+    return -2;
+  if (opt==NULL)
+    return coopt_emit_argument(emitter, ret->param);
+  if (emitter->separated)
+    return -2; /* it would be taken as an argument */
+
+  if (opt->long_option!=NULL &&
+      (opt->short_option==0 || !emitter->flags.prefer_short))
+  {
+    same_element = (ret->param!=NULL && emitter->flags.long_eq_params &&
+		    emitter->long_eq!=NULL);
+    out = coopt_emit_copy(start, end, emitter->long_marker+1);
+    out = coopt_emit_copy(out, end, opt->long_option);
+    if (same_element)
+      out = coopt_emit_copy(out, end, emitter->long_eq);
+  }
+  else
+  {
+    /* "-f" followed by nothing would take the next element instead */
+    same_element = (ret->param!=NULL && ret->param[0]!=0 &&
+		    emitter->flags.short_inline_params);
+    name[0] = opt->short_option;
+    name[1] = 0;
+    out = coopt_emit_copy(start, end, emitter->short_marker+1);
+    out = coopt_emit_copy(out, end, name);
+  }
+  if (same_element)
+    out = coopt_emit_copy(out, end, ret->param);
+  elements = (ret->param!=NULL && !same_element)?(2):(1);
+  if (out==NULL || out==end || emitter->argc+elements>=emitter->max_argc)
+    return -1;
+
+  *out++ = 0;
+  emitter->used = out - emitter->arena;
+  emitter->argv[emitter->argc++] = start;
+  if (!same_element && ret->param!=NULL)
+    emitter->argv[emitter->argc++] = ret->param;
+  emitter->argv[emitter->argc] = NULL;
+  return 0;
+}
+
+int coopt_emit_element(struct coopt_emitter *emitter, char const *element)
+{
+  if (emitter->argc+1>=emitter->max_argc)
+    return -1;
+  emitter->argv[emitter->argc++] = element;
+  emitter->argv[emitter->argc] = NULL;
+  return 0;
+}
+
+int coopt_emitted(struct coopt_emitter const *emitter)
+{
+  return emitter->argc;
+}
+
+/*
+ * Arguments are used as they are, but if one could be taken for an
+ * option (or the separator), the separator goes in front of it first.
+ * Most don't even start like one.
+ */
+static int coopt_emit_argument(struct coopt_emitter *emitter,
+			       char const *argument)
+{
+  char const *m[2];
+  int i, protect = 0;
+
+  if (!emitter->separated && emitter->separator!=NULL &&
+      (argument[0]==emitter->separator[0] ||
+       argument[0]==emitter->long_marker[1] ||
+       argument[0]==emitter->short_marker[1]))
+  {
+    m[0] = emitter->long_marker+1;
+    m[1] = emitter->short_marker+1;
+    protect = (coopt_strcmp(argument, emitter->separator)==0);
+    for (i=0; i<2 && !protect; i++)
+    {
+      size_t n = coopt_strlen(m[i]);
+      protect = (coopt_strncmp(argument, m[i], n)==0 && argument[n]!=0);
+    }
+  }
+  if (emitter->argc+1+protect>=emitter->max_argc)
+    return -1;
+  if (protect)
+  {
+    emitter->argv[emitter->argc++] = emitter->separator;
+    emitter->separated = 1;
+  }
+  emitter->argv[emitter->argc++] = argument;
+  emitter->argv[emitter->argc] = NULL;
+  return 0;
+}
+
+/* Copy (s), without its terminator, to (out); NULL if it won't fit */
+static char *coopt_emit_copy(char *out, char const *end, char const *s)
+{
+  if (out==NULL)
+    return NULL;
+  for (; *s!=0; s++)
+  {
+    if (out==end)
+      return NULL;
+    *out++ = *s;
+  }
+  return out;
+}
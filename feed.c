@@ -0,0 +1,200 @@
+/*
+ * $Id$
+ * feed.c
+ *
+ * Implementation of push parsing (coopt_feed()) for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * We keep up to COOPT_FEED_TOKENS complete elements, and run coopt() on
+ * a copy of the state over those we have. If it runs out (returning
+ * COOPT_RESULT_END or COOPT_RESULT_MISSINGPARAM, or an ambiguous option
+ * whose first match is missing its parameter) before the end of the
+ * stream, the answer might change when more arrives, so we throw the
+ * copy away and try again later; otherwise the result is final.
+ * Before each try, we step over anything coopt() has finished with (the
+ * end of a block of short options, and a parameter it has already
+ * returned), so one call to coopt() only ever needs two elements: an
+ * option and its parameter, or the separator and an argument.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+static void coopt_feed_compact(struct coopt_feed *);
+static void coopt_feed_token(struct coopt_feed *);
+
+void coopt_feed_init(struct coopt_feed *feed,
+		     struct coopt_option const *options,
+		     unsigned int num_options, char *buffer, size_t size)
+{
+  feed->buffer = buffer;
+  feed->size = size;
+  feed->used = 0;
+  feed->partial = 0;
+  feed->num_tokens = 0;
+  feed->ended = 0;
+  coopt_init(&feed->state, options, num_options, 0, feed->tokens);
+}
+
+size_t coopt_feed(struct coopt_feed *feed, char const *bytes, size_t len)
+{
+  size_t taken=0;
+
+  coopt_feed_compact(feed);
+  if (feed->ended)
+    return 0;
+  /* always leave room to terminate the last element */
+  while (taken<len && feed->num_tokens<COOPT_FEED_TOKENS &&
+	 feed->used+1 < feed->size)
+  {
+    size_t n = len-taken;
+    char const *nul = (char const *)coopt_memchr(bytes+taken, 0, n);
+    if (nul!=NULL)
+      n = nul-(bytes+taken)+1;
+    if (n > feed->size-1-feed->used)
+    {
+      n = feed->size-1-feed->used;
+      nul = NULL;
+    }
+    coopt_memcpy(feed->buffer+feed->used, bytes+taken, n);
+    feed->used += n;
+    taken += n;
+    if (nul!=NULL)
+      coopt_feed_token(feed);
+  }
+  return taken;
+}
+
+void coopt_feed_end(struct coopt_feed *feed)
+{
+  feed->ended = 1;
+}
+
+struct coopt_return coopt_feed_next(struct coopt_feed *feed)
+{
+  struct coopt_state trial;
+  struct coopt_return result;
+  int eof;
+
+  coopt_feed_compact(feed);
+  if (feed->ended && feed->partial<feed->used &&
+      feed->num_tokens<COOPT_FEED_TOKENS)
+  {
+    feed->buffer[feed->used++] = 0;
+    coopt_feed_token(feed);
+  }
+  eof = (feed->ended && feed->partial==feed->used);
+
+  trial = feed->state;
+  trial.argc = feed->num_tokens;
+  trial.constraints = NULL;
+  trial.parsed = NULL;
+  trial.diagnostics = NULL;
+  trial.trace = NULL;
+  result = coopt(&trial);
+  if (!eof && (result.result==COOPT_RESULT_END ||
+	       result.result==COOPT_RESULT_MISSINGPARAM ||
+	       (result.result==COOPT_RESULT_AMBIGUOUSOPT &&
+		result.ambigresult==COOPT_RESULT_MISSINGPARAM)))
+  {
+    /* not final; wait for more */
+    result.result = (feed->used+1 < feed->size)?(COOPT_RESULT_MORE):
+		    (COOPT_RESULT_ERROR);
+    result.ambigresult = COOPT_RESULT_OKAY;
+    result.opt = NULL;
+    result.param = NULL;
+    result.marker = NULL;
+    return result;
+  }
+
+  trial.constraints = feed->state.constraints;
+  trial.parsed = feed->state.parsed;
+  trial.diagnostics = feed->state.diagnostics;
+  trial.trace = feed->state.trace;
+  feed->state = trial;
+  if (result.opt!=NULL && feed->state.constraints!=NULL)
+    coopt_constraints_note(feed->state.constraints, result.opt);
+  return result;
+}
+
+/*
+ * Drop the elements coopt() has finished with. Anything we returned from
+ * them is no longer valid after this.
+ */
+static void coopt_feed_compact(struct coopt_feed *feed)
+{
+  struct coopt_state *state = &feed->state;
+  int done;
+  size_t bytes;
+  int i;
+
+  /* tidy up as coopt() would next time round; this doesn't depend on
+   * anything we haven't seen yet
+   */
+  if (state->char_within_arg > 0 &&
+      state->argv < feed->tokens+feed->num_tokens &&
+      state->argv[0][state->char_within_arg]==0)
+  {
+    state->argv++;
+    state->char_within_arg=0;
+    state->last_marker=NULL;
+  }
+  if (state->skip_next_arg && state->char_within_arg==0 &&
+      state->argv < feed->tokens+feed->num_tokens)
+  {
+    state->argv++;
+    state->skip_next_arg=0;
+  }
+
+  done = state->argv - feed->tokens;
+  if (done<=0)
+    return;
+  bytes = (done<feed->num_tokens)?
+	  ((size_t)(feed->tokens[done]-feed->buffer)):(feed->partial);
+  coopt_memmove(feed->buffer, feed->buffer+bytes, feed->used-bytes);
+  feed->used -= bytes;
+  feed->partial -= bytes;
+  for (i=done; i<feed->num_tokens; i++)
+    feed->tokens[i-done] = feed->tokens[i]-bytes;
+  feed->num_tokens -= done;
+  state->argv = feed->tokens;
+}
+
+/*
+ * The element from 'partial' to 'used' is now NUL-terminated
+ */
+static void coopt_feed_token(struct coopt_feed *feed)
+{
+  feed->tokens[feed->num_tokens++] = feed->buffer+feed->partial;
+  feed->partial = feed->used;
+}
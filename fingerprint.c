@@ -0,0 +1,212 @@
+/*
+ * $Id$
+ * fingerprint.c
+ *
+ * Implementation of coopt_fingerprint(), a hash of what a command line
+ * means rather than how it was written, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Each result becomes a record, hashed into four 32 bit lanes a word at a
+ * time (with each word's bytes taken in the same order on any machine, so
+ * fingerprints can be shared between them):
+ *
+ *   kind	FP_OPTION, FP_ARGUMENT or FP_ERROR, and the result code
+ *   option	which namespace (if there are any) and which option in it,
+ *		or 0xffffffff for none
+ *   param	its length, then its bytes
+ *
+ * Records go straight into the fingerprint, in order, except for those of
+ * COOPT_UNORDERED options: each of those is hashed on its own and they're
+ * added up, so their order doesn't matter, with the total going in at the
+ * end. Since every record starts the same way and says how long its
+ * parameter is, a run of them can't be mistaken for a different run. The
+ * mixing is MurmurHash3's.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+#define FP_MASK		0xffffffffUL
+#define FP_OPTION	1
+#define FP_ARGUMENT	2
+#define FP_ERROR	3
+#define FP_NONE		0xffffffffUL
+
+static unsigned long const fp_multiplier[4] =
+{
+  0x9e3779b1UL, 0x85ebca77UL, 0xc2b2ae3dUL, 0x27d4eb2fUL
+};
+
+#define fp_rotl(h, n) ((((h)<<(n)) | ((h)>>(32-(n)))) & FP_MASK)
+#define fp_mix(h, w, i) \
+	((h) = fp_rotl(((h) ^ (w)) * fp_multiplier[i] & FP_MASK, 13), \
+	 (h) = ((h)*5 + 0xe6546b64UL) & FP_MASK)
+
+static void coopt_fp_word(unsigned long *, unsigned long);
+static void coopt_fp_record(struct coopt_state *, struct coopt_return const *,
+			    unsigned long *);
+static void coopt_fp_finish(unsigned long *);
+static unsigned long coopt_fp_fmix(unsigned long);
+
+int coopt_fingerprint(struct coopt_state *state,
+		      struct coopt_fingerprint *fingerprint)
+{
+  struct coopt_return ret;
+  unsigned long *h = fingerprint->hash;
+  unsigned long sum[4], record[4];
+  unsigned long ordered=0, unordered=0;
+  int i;
+
+  for (i=0; i<4; i++)
+  {
+    h[i] = 0;
+    sum[i] = 0;
+  }
+  for (;;)
+  {
+    ret = coopt(state);
+    if (coopt_is_fatal(ret.result) || ret.result==COOPT_RESULT_END)
+      break;
+    if (ret.result==COOPT_RESULT_OKAY && ret.opt!=NULL &&
+	(ret.opt->attributes & COOPT_UNORDERED))
+    {
+      for (i=0; i<4; i++)
+	record[i] = fp_multiplier[3-i];
+      coopt_fp_record(state, &ret, record);
+      coopt_fp_finish(record);
+      for (i=0; i<4; i++)
+	sum[i] = (sum[i] + record[i]) & FP_MASK;
+      unordered++;
+    }
+    else
+    {
+      coopt_fp_record(state, &ret, h);
+      ordered++;
+    }
+    if (coopt_is_termination(ret.result))
+      break; /* eg: a missing parameter */
+  }
+  for (i=0; i<4; i++)
+    fp_mix(h[i], sum[i], i);
+  coopt_fp_word(h, ordered & FP_MASK);
+  coopt_fp_word(h, unordered & FP_MASK);
+  coopt_fp_word(h, (unsigned long)(ret.result+128));
+  coopt_fp_finish(h);
+  return ret.result;
+}
+
+static void coopt_fp_word(unsigned long *h, unsigned long w)
+{
+  fp_mix(h[0], w, 0);
+  fp_mix(h[1], w, 1);
+  fp_mix(h[2], w, 2);
+  fp_mix(h[3], w, 3);
+}
+
+/*
+ * Hash the record for (ret) into (r). Short and long forms of an option, and
+ * abbreviations, all come back from coopt() as the same option, and a
+ * parameter is the same string however it was given, so all that's left
+ * is to say which option it is in a way that doesn't depend on where
+ * the options are in memory.
+ */
+static void coopt_fp_record(struct coopt_state *state,
+			    struct coopt_return const *ret,
+			    unsigned long *r)
+{
+  unsigned long kind, option = FP_NONE;
+  unsigned char const *p;
+  size_t len, i;
+
+  if (ret->result!=COOPT_RESULT_OKAY)
+    kind = FP_ERROR;
+  else
+    kind = (ret->opt!=NULL)?(FP_OPTION):(FP_ARGUMENT);
+  coopt_fp_word(r, kind<<8 | (unsigned long)((ret->result+128) & 0xff));
+
+  if (ret->opt!=NULL)
+  {
+    struct coopt_option const *base = state->options;
+    unsigned long ns = 0;
+    if (state->namespaces!=NULL && ret->marker!=NULL)
+    {
+      while (state->markers[ns]!=NULL && state->markers[ns]!=ret->marker)
+	ns++;
+      if (state->namespaces[ns].options!=NULL)
+	base = state->namespaces[ns].options;
+      ns++;
+    }
+    option = (ns<<24 ^ (unsigned long)(ret->opt - base)) & FP_MASK;
+  }
+  coopt_fp_word(r, option);
+
+  p = (unsigned char const *)ret->param;
+  len = (p==NULL)?(0):(coopt_strlen(ret->param));
+  coopt_fp_word(r, (p==NULL)?(FP_NONE):(len & FP_MASK));
+  for (i=0; i+4<=len; i+=4)
+    coopt_fp_word(r, (unsigned long)p[i] | (unsigned long)p[i+1]<<8 |
+		     (unsigned long)p[i+2]<<16 | (unsigned long)p[i+3]<<24);
+  if (i<len)
+  {
+    unsigned long w = 0;
+    int shift = 0;
+    for (; i<len; i++, shift+=8)
+      w |= (unsigned long)p[i]<<shift;
+    coopt_fp_word(r, w);
+  }
+}
+
+/* Mix the lanes into each other, as MurmurHash3's x86_128 does */
+static void coopt_fp_finish(unsigned long *h)
+{
+  int i;
+
+  h[0] = (h[0] + h[1] + h[2] + h[3]) & FP_MASK;
+  for (i=1; i<4; i++)
+    h[i] = (h[i] + h[0]) & FP_MASK;
+  for (i=0; i<4; i++)
+    h[i] = coopt_fp_fmix(h[i]);
+  h[0] = (h[0] + h[1] + h[2] + h[3]) & FP_MASK;
+  for (i=1; i<4; i++)
+    h[i] = (h[i] + h[0]) & FP_MASK;
+}
+
+static unsigned long coopt_fp_fmix(unsigned long h)
+{
+  h ^= h >> 16;
+  h = (h * 0x85ebca6bUL) & FP_MASK;
+  h ^= h >> 13;
+  h = (h * 0xc2b2ae35UL) & FP_MASK;
+  h ^= h >> 16;
+  return h;
+}
@@ -0,0 +1,150 @@
+/*
+ * $Id$
+ * freestanding.c
+ *
+ * Our own string routines, for building coopt without the C library.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * These are the obvious byte at a time versions; they only have to cope
+ * with command lines. They're only used with COOPT_FREESTANDING, when
+ * coopt_string.h uses them in place of the C library's.
+ */
+
+#include "coopt_string.h"
+
+#ifdef COOPT_FREESTANDING
+
+size_t coopt_strlen(char const *s)
+{
+  char const *p = s;
+  while (*p!=0)
+    p++;
+  return p-s;
+}
+
+int coopt_strcmp(char const *a, char const *b)
+{
+  while (*a!=0 && *a==*b)
+  {
+    a++;
+    b++;
+  }
+  return (unsigned char)*a - (unsigned char)*b;
+}
+
+int coopt_strncmp(char const *a, char const *b, size_t n)
+{
+  for (; n>0; n--, a++, b++)
+  {
+    if (*a!=*b)
+      return (unsigned char)*a - (unsigned char)*b;
+    if (*a==0)
+      return 0;
+  }
+  return 0;
+}
+
+char *coopt_strchr(char const *s, int c)
+{
+  for (;; s++)
+  {
+    if (*s==(char)c)
+      return (char *)s;
+    if (*s==0)
+      return NULL;
+  }
+}
+
+size_t coopt_strcspn(char const *s, char const *reject)
+{
+  char const *p = s;
+  while (*p!=0 && coopt_strchr(reject, *p)==NULL)
+    p++;
+  return p-s;
+}
+
+int coopt_memcmp(void const *a, void const *b, size_t n)
+{
+  unsigned char const *p = (unsigned char const *)a;
+  unsigned char const *q = (unsigned char const *)b;
+
+  for (; n>0; n--, p++, q++)
+    if (*p!=*q)
+      return *p - *q;
+  return 0;
+}
+
+void *coopt_memchr(void const *s, int c, size_t n)
+{
+  unsigned char const *p = (unsigned char const *)s;
+
+  for (; n>0; n--, p++)
+    if (*p==(unsigned char)c)
+      return (void *)p;
+  return NULL;
+}
+
+void *coopt_memcpy(void *dest, void const *src, size_t n)
+{
+  unsigned char *d = (unsigned char *)dest;
+  unsigned char const *s = (unsigned char const *)src;
+
+  while (n-->0)
+    *d++ = *s++;
+  return dest;
+}
+
+void *coopt_memmove(void *dest, void const *src, size_t n)
+{
+  unsigned char *d = (unsigned char *)dest;
+  unsigned char const *s = (unsigned char const *)src;
+
+  if (d<=s)
+    return coopt_memcpy(dest, src, n);
+  d += n;
+  s += n;
+  while (n-->0)
+    *--d = *--s;
+  return dest;
+}
+
+void *coopt_memset(void *s, int c, size_t n)
+{
+  unsigned char *p = (unsigned char *)s;
+
+  while (n-->0)
+    *p++ = (unsigned char)c;
+  return s;
+}
+
+#endif
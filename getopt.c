@@ -0,0 +1,393 @@
+/*
+ * $Id$
+ * getopt.c
+ *
+ * Implementation of coopt_getopt() and coopt_getopt_long(), the getopt()
+ * compatibility layer for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#define COOPT_GETOPT_NO_RENAME
+#include "coopt_getopt.h"
+
+static char const * const coopt_getopt_long_markers[] = { "L--", "S-", NULL };
+static char const * const coopt_getopt_short_markers[] = { "S-", NULL };
+
+static int coopt_getopt_start(int, char * const [], char const *,
+			      struct option const *,
+			      struct coopt_getopt_data *);
+static int coopt_getopt_finish(struct coopt_getopt_data *, int);
+static int coopt_getopt_index(struct coopt_getopt_data *);
+static int coopt_getopt_error(struct coopt_getopt_data *,
+			      struct coopt_return *, int);
+
+/*
+ * The globals, and the data they're a view onto.
+ */
+int coopt_optind = 1;
+int coopt_opterr = 1;
+int coopt_optopt = '?';
+char * coopt_optarg = NULL;
+
+static struct coopt_getopt_data coopt_getopt_global =
+  COOPT_GETOPT_DATA_INITIALISER;
+
+int coopt_getopt(int argc, char * const argv[], char const *optstring)
+{
+  return coopt_getopt_long(argc, argv, optstring, NULL, NULL);
+}
+
+int coopt_getopt_long(int argc, char * const argv[], char const *optstring,
+		      struct option const *longopts, int *longindex)
+{
+  int r;
+  coopt_getopt_global.ind = coopt_optind;
+  coopt_getopt_global.err = coopt_opterr;
+  r = coopt_getopt_long_r(argc, argv, optstring, longopts, longindex,
+			  &coopt_getopt_global);
+  coopt_optind = coopt_getopt_global.ind;
+  coopt_optopt = coopt_getopt_global.opt;
+  coopt_optarg = coopt_getopt_global.arg;
+  return r;
+}
+
+int coopt_getopt_r(int argc, char * const argv[], char const *optstring,
+		   struct coopt_getopt_data *data)
+{
+  return coopt_getopt_long_r(argc, argv, optstring, NULL, NULL, data);
+}
+
+int coopt_getopt_long_r(int argc, char * const argv[],
+			char const *optstring,
+			struct option const *longopts, int *longindex,
+			struct coopt_getopt_data *data)
+{
+  struct coopt_return ret;
+  struct coopt_state snapshot;
+  struct option const *lo;
+  char const *p;
+
+  data->arg = NULL;
+
+  if (data->ind!=0 && data->ind == data->last_ind
+      && data->argv == argv)
+  {
+    if (data->finished)
+      return -1; /* nothing has changed since we last gave up */
+  }
+  else
+  {
+    /* new parse, or the caller has moved optind on us */
+    if (coopt_getopt_start(argc, argv, optstring, longopts, data)!=0)
+      return -1;
+  }
+
+  for (;;)
+  {
+    snapshot = data->state;
+    ret = coopt(&data->state);
+
+    if (ret.result == COOPT_RESULT_AMBIGUOUSOPT)
+    {
+      /* getopt_long() lets an exact match beat other options it's a prefix
+       * of, so try again without abbreviations before giving up.
+       */
+      struct coopt_return ambig = ret;
+      data->state = snapshot;
+      data->state.flags.allow_long_opts_breved = 0;
+      ret = coopt(&data->state);
+      data->state.flags.allow_long_opts_breved = 1;
+      if (ret.result == COOPT_RESULT_BADOPTION)
+      {
+	/* step over just this element; the next one isn't the parameter
+	 * of whichever option coopt() happened to find first
+	 */
+	data->state = snapshot;
+	data->state.flags.allow_long_sep_params = 0;
+	coopt(&data->state);
+	data->state.flags.allow_long_sep_params = 1;
+	data->ind = data->last_ind = coopt_getopt_index(data);
+	data->opt = 0;
+	return coopt_getopt_error(data, &ambig, '?');
+      }
+    }
+
+    if (ret.result == COOPT_RESULT_END || coopt_is_fatal(ret.result))
+      return coopt_getopt_finish(data, argc);
+
+    if (ret.result == COOPT_RESULT_OKAY && ret.opt == NULL)
+    {
+      /* an argument */
+      int index = (int)(data->state.argv - (char const * const *)argv) - 1;
+      if (data->state.char_within_arg < 0 || data->ordering == '+')
+	return coopt_getopt_finish(data, index); /* stop scanning here */
+      if (data->ordering == '-')
+      {
+	data->arg = (char *)ret.param;
+	data->ind = data->last_ind = coopt_getopt_index(data);
+	return 1;
+      }
+      /* coopt_permute() has remembered where it was */
+      continue;
+    }
+
+    data->ind = data->last_ind = coopt_getopt_index(data);
+
+    if (ret.opt != NULL && ret.opt->long_option == NULL)
+    {
+      /* short option: data points into optstring */
+      p = (char const *)ret.opt->data;
+      if (ret.result != COOPT_RESULT_OKAY)
+      {
+	data->opt = (unsigned char)p[0];
+	return coopt_getopt_error(data, &ret,
+				  (ret.result == COOPT_RESULT_MISSINGPARAM
+				   && data->colon)?(':'):('?'));
+      }
+      if (p[1]==':' && p[2]==':')
+      {
+	/* optional parameter: only ever inline */
+	char const *rest = data->state.argv[0] + data->state.char_within_arg;
+	if (data->state.char_within_arg > 0 && rest[0]!=0)
+	{
+	  data->arg = (char *)rest;
+	  data->state.char_within_arg += strlen(rest);
+	  data->ind = data->last_ind = coopt_getopt_index(data);
+	}
+      }
+      else
+	data->arg = (char *)ret.param;
+      return (unsigned char)p[0];
+    }
+
+    if (ret.opt == NULL)
+    {
+      /* COOPT_RESULT_BADOPTION */
+      data->opt = (ret.marker!=NULL && ret.marker[0]=='S')?
+	             ((unsigned char)ret.param[0]):(0);
+      return coopt_getopt_error(data, &ret, '?');
+    }
+
+    /* long option: data points at the struct option */
+    lo = (struct option const *)ret.opt->data;
+    if (ret.result == COOPT_RESULT_HADPARAM
+	&& lo->has_arg == optional_argument)
+      ret.result = COOPT_RESULT_OKAY;
+    if (ret.result != COOPT_RESULT_OKAY)
+    {
+      data->opt = lo->val;
+      return coopt_getopt_error(data, &ret,
+				((ret.result == COOPT_RESULT_MISSINGPARAM
+				  || ret.result == COOPT_RESULT_NOPARAM)
+				 && data->colon)?(':'):('?'));
+    }
+    data->arg = (char *)ret.param;
+    if (longindex!=NULL)
+      *longindex = (int)(lo - longopts);
+    if (lo->flag!=NULL)
+    {
+      *lo->flag = lo->val;
+      return 0;
+    }
+    return lo->val;
+  }
+}
+
+/*
+ * Build the coopt option array from optstring and longopts, and start
+ * coopt off at optind.
+ * Short options point their data at their place in optstring, long
+ * options at their struct option, which is all we need to translate
+ * back again.
+ */
+static int coopt_getopt_start(int argc, char * const argv[],
+			      char const *optstring,
+			      struct option const *longopts,
+			      struct coopt_getopt_data *data)
+{
+  unsigned int num_short=0, num_long=0, i;
+  char const *p;
+  struct coopt_option *opt;
+
+  free(data->options);
+  data->options = NULL;
+  data->finished = 0;
+  data->argv = argv;
+  data->optstring = optstring;
+  data->longopts = longopts;
+
+  if (data->ind <= 0)
+    data->ind = 1;
+  if (data->ind > argc)
+    data->ind = argc;
+
+  data->ordering = 0;
+  if (optstring[0]=='+' || optstring[0]=='-')
+    data->ordering = optstring++[0];
+  else if (getenv("POSIXLY_CORRECT")!=NULL)
+    data->ordering = '+';
+  data->colon = (optstring[0]==':');
+
+  for (p=optstring; p[0]!=0; p++)
+    if (p[0]!=':')
+      num_short++;
+  if (longopts!=NULL)
+    while (longopts[num_long].name!=NULL)
+      num_long++;
+
+  /* one block: options, then the permutation, then the index */
+  data->options = (struct coopt_option *)
+    malloc((num_short+num_long) * sizeof(struct coopt_option) +
+	   (argc + COOPT_INDEX_SIZE(num_short+num_long)) * sizeof(int));
+  if (data->options==NULL)
+  {
+    data->finished = 1;
+    data->last_ind = data->ind;
+    return -1;
+  }
+  data->num_options = num_short + num_long;
+  data->permutation = (int *)(data->options + data->num_options);
+  data->start = data->ind;
+
+  opt = data->options;
+  for (p=optstring; p[0]!=0; p++)
+  {
+    if (p[0]==':')
+      continue;
+    opt->short_option = p[0];
+    opt->has_param = (p[1]==':' && p[2]!=':')?
+                     (COOPT_REQUIRED_PARAM):(COOPT_NO_PARAM);
+    opt->long_option = NULL;
+    opt->data = (void *)p;
+    opt->attributes = 0;
+    opt++;
+  }
+  for (i=0; i<num_long; i++)
+  {
+    /* optional_argument is COOPT_NO_PARAM plus accepting _HADPARAM */
+    opt->short_option = 0;
+    opt->has_param = (longopts[i].has_arg==required_argument)?
+                     (COOPT_REQUIRED_PARAM):(COOPT_NO_PARAM);
+    opt->long_option = longopts[i].name;
+    opt->data = (void *)(longopts + i);
+    opt->attributes = 0;
+    opt++;
+  }
+
+  /* so options are looked up, rather than searched for, on every call */
+  coopt_index_init(&data->index, data->options, data->num_options, 0,
+		   data->permutation + argc);
+
+  coopt_init(&data->state, data->options, data->num_options,
+	     argc - data->ind,
+	     (char const * const *)argv + data->ind);
+  coopt_use_index(&data->state, &data->index);
+  data->state.flags.allow_long_opts_breved = 1;
+  data->state.markers = (longopts!=NULL)?(coopt_getopt_long_markers):
+                                         (coopt_getopt_short_markers);
+  if (data->ordering==0)
+    coopt_permute(&data->state, data->permutation);
+  data->last_ind = data->ind;
+  return 0;
+}
+
+/*
+ * We've stopped at argv[rest] (or run out). If we were permuting, move the
+ * arguments coopt() stepped over after the options, following each cycle
+ * of the permutation round once (so it's a single pass), and point optind
+ * at the first of them.
+ */
+static int coopt_getopt_finish(struct coopt_getopt_data *data, int rest)
+{
+  if (data->ordering==0 && data->options!=NULL)
+  {
+    /* GNU getopt casts away argv's const-ness too */
+    char **argv = (char **)data->argv + data->start;
+    int *perm = data->permutation;
+    int num_options, n, i, j, next;
+    n = coopt_permuted(&data->state, &num_options);
+    if (n > num_options)
+    {
+      for (i=0; i<n; i++)
+      {
+	char *t;
+	if (perm[i]<0) /* already placed (we mark them by complementing) */
+	  continue;
+	t = argv[i];
+	for (j=i; perm[j]!=i; j=next)
+	{
+	  next = perm[j];
+	  argv[j] = argv[next];
+	  perm[j] = ~next;
+	}
+	argv[j] = t;
+	perm[j] = ~i;
+      }
+      rest = data->start + num_options;
+    }
+  }
+
+  free(data->options);
+  data->options = NULL;
+  data->finished = 1;
+  data->ind = data->last_ind = rest;
+  return -1;
+}
+
+/*
+ * What optind should be now: the next element getopt() hasn't finished
+ * with. Part way through a block of short options, that's still the
+ * current element.
+ */
+static int coopt_getopt_index(struct coopt_getopt_data *data)
+{
+  struct coopt_state *state = &data->state;
+  int index = (int)(state->argv - (char const * const *)data->argv);
+  if (state->char_within_arg > 0 && state->argc > 0
+      && state->argv[0][state->char_within_arg]==0)
+    index++;
+  return index + state->skip_next_arg;
+}
+
+static int coopt_getopt_error(struct coopt_getopt_data *data,
+			      struct coopt_return *ret, int code)
+{
+  if (data->err && !data->colon)
+  {
+    char buf[256];
+    coopt_serror(buf, 256, ret, &data->state);
+    fprintf(stderr, "%s: %s\n", data->argv[0], buf);
+  }
+  return code;
+}
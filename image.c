@@ -0,0 +1,256 @@
+/*
+ * $Id$
+ * image.c
+ *
+ * Implementation of binary images of a compiled option index, which can be
+ * mapped into memory and used in place, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * An image is a sequence of native ints (so it's only portable between
+ * machines with the same byte order and size of int, which the header
+ * records), followed by a pool of NUL-terminated strings:
+ *
+ *   header	IMAGE_HEADER ints, as below
+ *   options	4 ints per option: short option character (as an unsigned
+ *		char), has_param, the offset of the long option in the
+ *		string pool (or -1), and attributes
+ *   short_map	256 ints
+ *   table	mask+1 ints
+ *   lengths	num_options ints
+ *   sorted	num_sorted ints
+ *   prefixes	num_sorted ints
+ *   firsts	num_sorted ints
+ *   strings	the string pool; its last byte is always NUL
+ *
+ * Everything is found by offset from the start of the image, so it can
+ * be mapped anywhere.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+#define IMAGE_MAGIC		0	/* COOPT_IMAGE_MAGIC */
+#define IMAGE_VERSION		1	/* COOPT_IMAGE_VERSION */
+#define IMAGE_BYTE_ORDER	2	/* IMAGE_ORDER_MARK */
+#define IMAGE_INT_SIZE		3	/* sizeof(int) */
+#define IMAGE_SIZE		4	/* bytes in the whole image */
+#define IMAGE_NUM_OPTIONS	5
+#define IMAGE_NUM_SORTED	6
+#define IMAGE_MASK		7
+#define IMAGE_SEED		8
+#define IMAGE_STRINGS		9	/* bytes in the string pool */
+#define IMAGE_HEADER		12	/* the rest is reserved, and zero */
+
+#define IMAGE_ORDER_MARK	0x01020304
+
+/* ints before the string pool */
+#define image_ints(num_options, num_sorted, slots) \
+	(IMAGE_HEADER + 4*(size_t)(num_options) + 256 + (size_t)(slots) + \
+	 (size_t)(num_options) + 3*(size_t)(num_sorted))
+
+size_t coopt_image_write(struct coopt_index const *index, void *buffer,
+			 size_t size)
+{
+  size_t strings=1, needed;
+  unsigned int i;
+  int *out;
+  char *pool;
+
+  for (i=0; i<index->num_options; i++)
+    if (index->options[i].long_option!=NULL)
+      strings += index->lengths[i]+1;
+  needed = image_ints(index->num_options, index->num_sorted,
+		      index->mask+1)*sizeof(int) + strings;
+  if (buffer==NULL || size<needed)
+    return needed;
+
+  out = (int *)buffer;
+  coopt_memset(buffer, 0, needed);
+  out[IMAGE_MAGIC] = COOPT_IMAGE_MAGIC;
+  out[IMAGE_VERSION] = COOPT_IMAGE_VERSION;
+  out[IMAGE_BYTE_ORDER] = IMAGE_ORDER_MARK;
+  out[IMAGE_INT_SIZE] = sizeof(int);
+  out[IMAGE_SIZE] = needed;
+  out[IMAGE_NUM_OPTIONS] = index->num_options;
+  out[IMAGE_NUM_SORTED] = index->num_sorted;
+  out[IMAGE_MASK] = index->mask;
+  out[IMAGE_SEED] = index->seed & 0xffffffffUL; /* all the hash uses */
+  out[IMAGE_STRINGS] = strings;
+  out += IMAGE_HEADER;
+
+  /* string 0 is the empty string, so no option has offset 0 */
+  pool = (char *)buffer + needed - strings;
+  strings = 1;
+  for (i=0; i<index->num_options; i++)
+  {
+    struct coopt_option const *o = index->options + i;
+    *out++ = (unsigned char)o->short_option;
+    *out++ = o->has_param;
+    if (o->long_option==NULL)
+      *out++ = -1;
+    else
+    {
+      *out++ = strings;
+      coopt_memcpy(pool+strings, o->long_option, index->lengths[i]+1);
+      strings += index->lengths[i]+1;
+    }
+    *out++ = o->attributes;
+  }
+  coopt_memcpy(out, index->short_map, 256*sizeof(int));
+  out += 256;
+  coopt_memcpy(out, index->table, (index->mask+1)*sizeof(int));
+  out += index->mask+1;
+  coopt_memcpy(out, index->lengths, index->num_options*sizeof(int));
+  out += index->num_options;
+  coopt_memcpy(out, index->sorted, index->num_sorted*sizeof(int));
+  out += index->num_sorted;
+  coopt_memcpy(out, index->prefixes, index->num_sorted*sizeof(int));
+  out += index->num_sorted;
+  coopt_memcpy(out, index->firsts, index->num_sorted*sizeof(int));
+  return needed;
+}
+
+int coopt_image_num_options(void const *image, size_t size)
+{
+  int const *in = (int const *)image;
+  /* each option takes at least five ints */
+  if (size < IMAGE_HEADER*sizeof(int) ||
+      in[IMAGE_MAGIC]!=COOPT_IMAGE_MAGIC ||
+      in[IMAGE_VERSION]!=COOPT_IMAGE_VERSION ||
+      in[IMAGE_BYTE_ORDER]!=IMAGE_ORDER_MARK ||
+      in[IMAGE_INT_SIZE]!=sizeof(int) || in[IMAGE_NUM_OPTIONS]<0 ||
+      (size_t)in[IMAGE_NUM_OPTIONS] > size/(5*sizeof(int)))
+    return -1;
+  return in[IMAGE_NUM_OPTIONS];
+}
+
+/*
+ * We check everything that could send coopt() astray, as the image may
+ * have come from anywhere; so this is linear in the size of the image.
+ */
+int coopt_image_attach(struct coopt_index *index,
+		       struct coopt_option *options, unsigned int num_options,
+		       void const *image, size_t size)
+{
+  int const *in = (int const *)image;
+  int const *opts, *short_map, *table, *lengths, *sorted, *firsts;
+  char const *pool;
+  unsigned long slots;
+  int n, num_sorted, strings, used=0, i;
+
+  n = coopt_image_num_options(image, size);
+  if (n<0)
+    return -1;
+  num_sorted = in[IMAGE_NUM_SORTED];
+  strings = in[IMAGE_STRINGS];
+  slots = (unsigned int)in[IMAGE_MASK] + 1UL;
+  if ((unsigned int)n > num_options || num_sorted<0 || num_sorted>n ||
+      strings<1 || slots<2 || (slots & (slots-1))!=0 ||
+      slots > (unsigned long)4*n+2 || in[IMAGE_SIZE]<0 ||
+      (size_t)in[IMAGE_SIZE] > size ||
+      (size_t)in[IMAGE_SIZE]!=image_ints(n, num_sorted, slots)*sizeof(int)
+			       + strings)
+    return -1;
+
+  opts = in + IMAGE_HEADER;
+  short_map = opts + 4*n;
+  table = short_map + 256;
+  lengths = table + slots;
+  sorted = lengths + n;
+  firsts = sorted + 2*num_sorted;
+  pool = (char const *)(firsts + num_sorted);
+  if (pool[strings-1]!=0)
+    return -1;
+
+  for (i=0; i<n; i++)
+  {
+    int offset = opts[4*i+2];
+    options[i].short_option = (char)opts[4*i];
+    options[i].has_param = opts[4*i+1];
+    options[i].data = NULL;
+    options[i].attributes = opts[4*i+3];
+    if (offset<0)
+    {
+      options[i].long_option = NULL;
+      if (lengths[i]!=-1)
+	return -1;
+    }
+    else
+    {
+      if (offset>=strings)
+	return -1;
+      options[i].long_option = pool+offset;
+      if (lengths[i]<0 || lengths[i]>=strings-offset ||
+	  pool[offset+lengths[i]]!=0 ||
+	  (int)coopt_strlen(options[i].long_option)!=lengths[i])
+	return -1;
+    }
+  }
+  for (i=0; i<256; i++)
+    if (short_map[i]<-1 || short_map[i]>=n)
+      return -1;
+  for (i=0; (unsigned long)i<slots; i++)
+  {
+    if (table[i]<-1 || table[i]>=n ||
+	(table[i]>=0 && options[table[i]].long_option==NULL))
+      return -1;
+    if (table[i]>=0)
+      used++;
+  }
+  /* at least half the slots are empty, as coopt_index_init() leaves
+   * them, so a search for a missing option always reaches one
+   */
+  if (used!=num_sorted || slots<=2*(unsigned long)num_sorted)
+    return -1;
+  for (i=0; i<num_sorted; i++)
+    if (sorted[i]<0 || sorted[i]>=n ||
+	options[sorted[i]].long_option==NULL)
+      return -1;
+  for (i=1; i<num_sorted; i++)
+    if (firsts[i]<0 || firsts[i]>=n ||
+	options[firsts[i]].long_option==NULL)
+      return -1;
+
+  index->options = options;
+  index->num_options = n;
+  coopt_memcpy(index->short_map, short_map, 256*sizeof(int));
+  index->table = table;
+  index->mask = slots-1;
+  index->seed = (unsigned int)in[IMAGE_SEED];
+  index->lengths = lengths;
+  index->sorted = sorted;
+  index->num_sorted = num_sorted;
+  index->prefixes = sorted + num_sorted;
+  index->firsts = firsts;
+  return 0;
+}
@@ -0,0 +1,406 @@
+/*
+ * $Id$
+ * incremental.c
+ *
+ * Implementation of coopt_incremental() and coopt_reparse(), parsing
+ * command lines again after they've been edited, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+/*
+ * Between calls, coopt() is usually at the start of an element, and then
+ * nothing about what came before matters but where it is, whether it's
+ * past the separator, and how many results there have been: that's all a
+ * checkpoint records, and starting again from one is just setting up the
+ * state to match. After the last of a block of short options, coopt() is
+ * still on that element (and may have its parameter to skip), but the
+ * next call moves on before looking at anything, so that counts as being
+ * at the start of the element after.
+ *
+ * When re-parsing, the old results and checkpoints after the edit (the
+ * 'tail') stay where they are unless the new ones are about to overwrite
+ * them, in which case they're moved once to the end of the arrays; if
+ * there still isn't room, they're given up on, and the rest is parsed in
+ * full. Old result i is at results[i + rshift], and old checkpoint i at
+ * checkpoints[i + cshift].
+ */
+struct coopt_tail
+{
+  int num_results; /* how many there were */
+  int num_checkpoints;
+  int next; /* the first old checkpoint we could still meet */
+  int rshift;
+  int cshift;
+  int from; /* only meet them at new elements from here on */
+  int delta; /* new element - old element, after the edit */
+};
+
+static int coopt_incremental_usable(struct coopt_state *);
+static int coopt_boundary(struct coopt_state *, char const * const *, int *);
+static int coopt_incremental_run(struct coopt_state *,
+				 struct coopt_incremental *,
+				 struct coopt_tail *);
+static void coopt_checkpoint_note(struct coopt_incremental *,
+				  struct coopt_tail *, int, int,
+				  unsigned long);
+static int coopt_result_room(struct coopt_incremental *, struct coopt_tail *);
+static int coopt_converge(struct coopt_state *, struct coopt_incremental *,
+			  struct coopt_tail *);
+
+void coopt_incremental_init(struct coopt_incremental *inc,
+			    struct coopt_return *results, int max_results,
+			    struct coopt_checkpoint *checkpoints,
+			    int max_checkpoints)
+{
+  inc->results = results;
+  inc->max_results = max_results;
+  inc->num_results = 0;
+  inc->checkpoints = checkpoints;
+  inc->max_checkpoints = max_checkpoints;
+  inc->num_checkpoints = 0;
+  inc->first_changed = 0;
+  inc->num_changed = 0;
+  inc->argv = NULL;
+  inc->argc = 0;
+  inc->spacing = 1;
+  inc->end_result = COOPT_RESULT_END;
+  inc->ran_out = 0;
+  inc->end_element = 0;
+  inc->end_char_within_arg = 0;
+  inc->end_skip_next_arg = 0;
+  inc->end_marker = NULL;
+  inc->end_num_results = 0;
+}
+
+int coopt_incremental(struct coopt_state *state, struct coopt_incremental *inc)
+{
+  struct coopt_tail tail;
+
+  if (!coopt_incremental_usable(state))
+    return COOPT_RESULT_ERROR;
+  inc->argv = state->argv;
+  inc->argc = state->argc;
+  inc->num_results = 0;
+  inc->num_checkpoints = 0;
+  inc->first_changed = 0;
+  inc->spacing = 1;
+  tail.num_results = 0;
+  tail.num_checkpoints = 0;
+  tail.next = 0;
+  tail.rshift = 0;
+  tail.cshift = 0;
+  tail.from = 0;
+  tail.delta = 0;
+  return coopt_incremental_run(state, inc, &tail);
+}
+
+int coopt_reparse(struct coopt_state *state, struct coopt_incremental *inc,
+		  int argc, char const * const *argv,
+		  int first, int removed, int added)
+{
+  struct coopt_tail tail;
+  struct coopt_checkpoint start;
+  int c, low, high;
+
+  if (!coopt_incremental_usable(state) || argv==NULL || first<0 ||
+      removed<0 || added<0 || first+removed>inc->argc ||
+      argc!=inc->argc-removed+added)
+    return COOPT_RESULT_ERROR;
+
+  /* c is one after the last checkpoint at or before the edit */
+  low = 0;
+  high = inc->num_checkpoints;
+  while (low<high)
+  {
+    c = low + (high-low)/2;
+    if (inc->checkpoints[c].element<=first)
+      low = c+1;
+    else
+      high = c;
+  }
+  c = low;
+  if (c>0)
+    start = inc->checkpoints[c-1];
+  else
+  {
+    start.element = 0;
+    start.result = 0;
+    start.separated = 0;
+    start.num_results = 0;
+  }
+
+  /*
+   * The first old checkpoint after the elements removed; if none were, it
+   * can be the one we start from.
+   */
+  tail.num_results = inc->num_results;
+  tail.num_checkpoints = inc->num_checkpoints;
+  for (tail.next=(c>0) ? c-1 : 0; tail.next<tail.num_checkpoints;
+       tail.next++)
+  {
+    if (inc->checkpoints[tail.next].element>=first+removed)
+      break;
+  }
+  if (inc->ran_out) /* what's after them is incomplete */
+    tail.next = tail.num_checkpoints;
+  tail.rshift = 0;
+  tail.cshift = 0;
+  tail.from = first+added;
+  tail.delta = added-removed;
+
+  inc->argv = argv;
+  inc->argc = argc;
+  inc->num_results = start.result;
+  inc->num_checkpoints = (tail.next<c) ? tail.next : c;
+  inc->first_changed = start.result;
+  state->argv = argv + start.element;
+  state->argc = argc - start.element;
+  state->char_within_arg = start.separated ? -1 : 0;
+  state->skip_next_arg = 0;
+  state->last_marker = NULL;
+  state->num_results = start.num_results;
+  return coopt_incremental_run(state, inc, &tail);
+}
+
+static int coopt_incremental_usable(struct coopt_state *state)
+{
+  return state!=NULL && state->argv!=NULL && state->classmap==NULL &&
+	 state->permutation==NULL && state->constraints==NULL &&
+	 state->parsed==NULL && state->diagnostics==NULL;
+}
+
+/*
+ * The element (counting from 'argv') the next call of coopt() will start
+ * on, and whether it's past the separator; or -1 if it's part way through
+ * one.
+ */
+static int coopt_boundary(struct coopt_state *state,
+			  char const * const *argv, int *separated)
+{
+  int element = (int)(state->argv - argv);
+
+  *separated = (state->char_within_arg<0);
+  if (state->char_within_arg<=0)
+    return (state->skip_next_arg) ? -1 : element;
+  if (state->argv[0][state->char_within_arg]!=0)
+    return -1;
+  return element + 1 + (state->skip_next_arg ? 1 : 0);
+}
+
+static int coopt_incremental_run(struct coopt_state *state,
+				 struct coopt_incremental *inc,
+				 struct coopt_tail *tail)
+{
+  struct coopt_return ret;
+  struct coopt_checkpoint *old;
+  int element, separated, missing = 0;
+
+  inc->ran_out = 0;
+  for (;;)
+  {
+    element = coopt_boundary(state, inc->argv, &separated);
+    if (element>=0 && missing)
+    {
+      /*
+       * Not somewhere to start again from: a missing parameter would be
+       * found if anything were added here
+       */
+      missing = 0;
+    }
+    else if (element>=0)
+    {
+      if (element>=tail->from)
+      {
+	/* back where we were before the edit? */
+	while (tail->next<tail->num_checkpoints &&
+	       inc->checkpoints[tail->next+tail->cshift].element <
+	       element-tail->delta)
+	  tail->next++;
+	old = inc->checkpoints + tail->next + tail->cshift;
+	if (tail->next<tail->num_checkpoints &&
+	    old->element==element-tail->delta &&
+	    old->separated==separated &&
+	    (state->max_results==0 || old->num_results==state->num_results))
+	  return coopt_converge(state, inc, tail);
+      }
+      coopt_checkpoint_note(inc, tail, element, separated,
+			    state->num_results);
+    }
+
+    ret = coopt(state);
+    if (coopt_is_fatal(ret.result) || ret.result==COOPT_RESULT_END)
+      break;
+    if (!coopt_result_room(inc, tail))
+    {
+      ret.result = COOPT_RESULT_TOOMANY;
+      inc->ran_out = 1;
+      break;
+    }
+    inc->results[inc->num_results++] = ret;
+    if (ret.result==COOPT_RESULT_MISSINGPARAM)
+      missing = 1;
+  }
+
+  inc->num_changed = inc->num_results - inc->first_changed;
+  inc->end_result = ret.result;
+  inc->end_element = (int)(state->argv - inc->argv);
+  inc->end_char_within_arg = state->char_within_arg;
+  inc->end_skip_next_arg = state->skip_next_arg;
+  inc->end_marker = state->last_marker;
+  inc->end_num_results = state->num_results;
+  return ret.result;
+}
+
+static void coopt_checkpoint_note(struct coopt_incremental *inc,
+				  struct coopt_tail *tail, int element,
+				  int separated, unsigned long num_results)
+{
+  struct coopt_checkpoint *cp;
+  int limit, i;
+
+  if (inc->num_checkpoints>0 &&
+      element < inc->checkpoints[inc->num_checkpoints-1].element +
+		inc->spacing)
+    return;
+
+  limit = (tail->next<tail->num_checkpoints) ? tail->next + tail->cshift :
+					       inc->max_checkpoints;
+  if (inc->num_checkpoints>=limit && tail->cshift==0 &&
+      tail->next<tail->num_checkpoints &&
+      inc->max_checkpoints>tail->num_checkpoints)
+  {
+    tail->cshift = inc->max_checkpoints - tail->num_checkpoints;
+    coopt_memmove(inc->checkpoints + tail->next + tail->cshift,
+		  inc->checkpoints + tail->next,
+		  (tail->num_checkpoints - tail->next) *
+		  sizeof(struct coopt_checkpoint));
+    limit = tail->next + tail->cshift;
+  }
+  if (inc->num_checkpoints>=limit)
+  {
+    /* keep every other one, always including the start */
+    if (inc->num_checkpoints<2)
+      return;
+    for (i=1; 2*i<inc->num_checkpoints; i++)
+      inc->checkpoints[i] = inc->checkpoints[2*i];
+    inc->num_checkpoints = i;
+    inc->spacing *= 2;
+    if (element < inc->checkpoints[i-1].element + inc->spacing)
+      return;
+  }
+
+  cp = inc->checkpoints + inc->num_checkpoints++;
+  cp->element = element;
+  cp->result = inc->num_results;
+  cp->separated = separated;
+  cp->num_results = num_results;
+}
+
+/* Make room for another result, giving up on the tail if need be */
+static int coopt_result_room(struct coopt_incremental *inc,
+			     struct coopt_tail *tail)
+{
+  int from, shift;
+
+  if (tail->next>=tail->num_checkpoints)
+    return inc->num_results<inc->max_results;
+  from = inc->checkpoints[tail->next+tail->cshift].result;
+  if (inc->num_results<from+tail->rshift)
+    return 1;
+  shift = inc->max_results - tail->num_results;
+  if (tail->rshift==0 && shift>0)
+  {
+    coopt_memmove(inc->results + from + shift, inc->results + from,
+		  (tail->num_results - from) * sizeof(struct coopt_return));
+    tail->rshift = shift;
+    return 1;
+  }
+  tail->next = tail->num_checkpoints;
+  return inc->num_results<inc->max_results;
+}
+
+/*
+ * The state is as it was at old checkpoint tail->next, so everything after
+ * that is as it was: move it into place.
+ */
+static int coopt_converge(struct coopt_state *state,
+			  struct coopt_incremental *inc,
+			  struct coopt_tail *tail)
+{
+  struct coopt_checkpoint cp = inc->checkpoints[tail->next+tail->cshift];
+  int from = cp.result;
+  int rdelta = inc->num_results - from;
+  unsigned long ndelta = state->num_results - cp.num_results;
+  int i;
+
+  if (inc->end_element<cp.element)
+  {
+    /* it stopped (on state->max_results) before moving on to there */
+    inc->end_element = cp.element;
+    inc->end_char_within_arg = cp.separated ? -1 : 0;
+    inc->end_skip_next_arg = 0;
+    inc->end_marker = NULL;
+  }
+
+  inc->num_changed = inc->num_results - inc->first_changed;
+  if (inc->num_results!=from+tail->rshift) /* often it's where it was */
+    coopt_memmove(inc->results + inc->num_results,
+		  inc->results + from + tail->rshift,
+		  (tail->num_results - from) * sizeof(struct coopt_return));
+  inc->num_results += tail->num_results - from;
+  if (inc->num_checkpoints==tail->next+tail->cshift && tail->delta==0 &&
+      rdelta==0 && ndelta==0)
+    inc->num_checkpoints += tail->num_checkpoints - tail->next; /* as is */
+  else
+  {
+    for (i=tail->next; i<tail->num_checkpoints; i++)
+    {
+      cp = inc->checkpoints[i+tail->cshift];
+      cp.element += tail->delta;
+      cp.result += rdelta;
+      cp.num_results += ndelta;
+      inc->checkpoints[inc->num_checkpoints++] = cp;
+    }
+  }
+
+  inc->end_element += tail->delta;
+  inc->end_num_results += ndelta;
+  state->argv = inc->argv + inc->end_element;
+  state->argc = inc->argc - inc->end_element;
+  state->char_within_arg = inc->end_char_within_arg;
+  state->skip_next_arg = inc->end_skip_next_arg;
+  state->last_marker = inc->end_marker;
+  state->num_results = inc->end_num_results;
+  return inc->end_result;
+}
@@ -0,0 +1,331 @@
+/*
+ * $Id$
+ * index.c
+ *
+ * Implementation of the compiled option index (short option map and long
+ * option hash table) for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+#define FNV_OFFSET 2166136261UL
+#define FNV_PRIME 16777619UL
+
+static int coopt_index_compare(struct coopt_option const *, int, int);
+static void coopt_index_sift(struct coopt_option const *, int *, int, int);
+static int coopt_index_common(char const *, char const *);
+static int coopt_index_first(struct coopt_index const *, unsigned int,
+			     unsigned int);
+
+/* A node of the tree in index->firsts; leaves are index->sorted itself */
+#define coopt_index_node(index, i) \
+	(((i)>=(index)->num_sorted)?((index)->sorted[(i)-(index)->num_sorted]):\
+				    ((index)->firsts[i]))
+
+int coopt_index_init(struct coopt_index *index,
+		     struct coopt_option const *options,
+		     unsigned int num_options, unsigned long seed, int *space)
+{
+  unsigned int i;
+  unsigned long slots=1;
+  int displaced=0;
+  int *table, *lengths, *sorted, *prefixes, *firsts;
+  int n;
+
+  /* largest power of two that fits, which is always more than twice the
+   * number of options, so at least half the slots are empty
+   */
+  while (slots*2 <= 4*num_options+2)
+    slots*=2;
+  table = space;
+  lengths = table + 4*num_options+2;
+  sorted = lengths + num_options;
+  prefixes = sorted + num_options;
+  firsts = prefixes + num_options;
+
+  index->options = options;
+  index->num_options = num_options;
+  index->table = table;
+  index->mask = slots-1;
+  index->seed = seed;
+  index->lengths = lengths;
+  index->sorted = sorted;
+  index->prefixes = prefixes;
+  index->firsts = firsts;
+
+  for (i=0; i<slots; i++)
+    table[i] = -1;
+  for (i=0; i<256; i++)
+    index->short_map[i] = -1;
+
+  n=0;
+  for (i=0; i<num_options; i++)
+  {
+    if (options[i].short_option!=0 &&
+	index->short_map[(unsigned char)options[i].short_option]<0)
+      index->short_map[(unsigned char)options[i].short_option] = i;
+    if (options[i].long_option!=NULL)
+    {
+      unsigned long slot;
+      lengths[i] = coopt_strlen(options[i].long_option);
+      slot = coopt_index_hash(seed, options[i].long_option, lengths[i])
+	     & index->mask;
+      if (table[slot]>=0)
+      {
+	displaced++;
+	do
+	{
+	  slot = (slot+1) & index->mask;
+	}
+	while (table[slot]>=0);
+      }
+      table[slot] = i;
+      sorted[n++] = i;
+    }
+    else
+      lengths[i] = -1;
+  }
+  index->num_sorted = n;
+
+  /* heapsort, so we don't need qsort() */
+  for (i=n/2; i>0; i--)
+    coopt_index_sift(options, sorted, i-1, n);
+  while (n>1)
+  {
+    int t = sorted[0];
+    sorted[0] = sorted[--n];
+    sorted[n] = t;
+    coopt_index_sift(options, sorted, 0, n);
+  }
+
+  /* an abbreviation is unambiguous once it's longer than what an option
+   * has in common with either of its neighbours
+   */
+  for (i=0; i<index->num_sorted; i++)
+  {
+    int common=0, c;
+    if (i>0)
+      common = coopt_index_common(options[sorted[i-1]].long_option,
+				  options[sorted[i]].long_option);
+    if (i+1<index->num_sorted)
+    {
+      c = coopt_index_common(options[sorted[i]].long_option,
+			     options[sorted[i+1]].long_option);
+      if (c>common)
+	common=c;
+    }
+    prefixes[i] = common+1;
+  }
+
+  /* the first of each pair of nodes, up to the root at 1 */
+  if (index->num_sorted>0)
+    firsts[0] = -1; /* not used */
+  for (i=index->num_sorted; i>1; i--)
+  {
+    int a = coopt_index_node(index, 2*(i-1)),
+	b = coopt_index_node(index, 2*(i-1)+1);
+    firsts[i-1] = (a<b)?(a):(b);
+  }
+  return displaced;
+}
+
+int coopt_index_short(struct coopt_index const *index, char c)
+{
+  if (c==0)
+    return -1;
+  return index->short_map[(unsigned char)c];
+}
+
+int coopt_index_long(struct coopt_index const *index, char const *name,
+		     size_t len)
+{
+  unsigned long slot = coopt_index_hash(index->seed, name, len) & index->mask;
+  while (index->table[slot]>=0)
+  {
+    int i = index->table[slot];
+    if ((size_t)index->lengths[i]==len &&
+	coopt_memcmp(index->options[i].long_option, name, len)==0)
+      return i;
+    slot = (slot+1) & index->mask;
+  }
+  return -1;
+}
+
+int coopt_index_abbrev(struct coopt_index const *index, char const *name,
+		       size_t len, int *ambiguous)
+{
+  unsigned int lo=0, hi=index->num_sorted, prev, step;
+  int first;
+
+  *ambiguous=0;
+  /* find the first option that doesn't come before 'name' */
+  while (lo<hi)
+  {
+    unsigned int mid = lo+(hi-lo)/2;
+    if (coopt_strncmp(index->options[index->sorted[mid]].long_option, name, len)<0)
+      lo = mid+1;
+    else
+      hi = mid;
+  }
+  if (lo>=index->num_sorted ||
+      coopt_strncmp(index->options[index->sorted[lo]].long_option, name, len)!=0)
+    return -1;
+  first = index->sorted[lo];
+  if ((size_t)index->prefixes[lo]<=len)
+    return first;
+
+  /* may be ambiguous; all the options it abbreviates follow on, so find
+   * where they stop by galloping and then a binary search, which only
+   * takes time in the log of how many there are
+   */
+  prev = lo;
+  hi = lo+1;
+  step = 1;
+  while (hi<index->num_sorted &&
+	 coopt_strncmp(index->options[index->sorted[hi]].long_option,
+		       name, len)==0)
+  {
+    prev = hi;
+    hi = (index->num_sorted-hi > step)?(hi+step):(index->num_sorted);
+    step *= 2;
+  }
+  while (prev+1<hi)
+  {
+    unsigned int mid = prev+(hi-prev)/2;
+    if (coopt_strncmp(index->options[index->sorted[mid]].long_option,
+		      name, len)==0)
+      prev = mid;
+    else
+      hi = mid;
+  }
+  *ambiguous = hi-lo-1;
+  /* we want the first of them in the original order */
+  return (hi-lo>1)?(coopt_index_first(index, lo, hi)):(first);
+}
+
+void coopt_use_index(struct coopt_state *state,
+		     struct coopt_index const *index)
+{
+  state->index = index;
+  if (index!=NULL)
+  {
+    state->options = index->options;
+    state->num_options = index->num_options;
+  }
+}
+
+unsigned long coopt_index_hash(unsigned long seed, char const *name,
+			       size_t len)
+{
+  unsigned long h = (FNV_OFFSET ^ seed) & 0xffffffffUL;
+  while (len-- > 0)
+  {
+    h ^= (unsigned char)*name++;
+    h = (h*FNV_PRIME) & 0xffffffffUL;
+  }
+  return h;
+}
+
+/*
+ * Order options by name, and then by position so the first of any
+ * repeated option comes first.
+ */
+static int coopt_index_compare(struct coopt_option const *options,
+			       int a, int b)
+{
+  int c = coopt_strcmp(options[a].long_option, options[b].long_option);
+  if (c!=0)
+    return c;
+  return a-b;
+}
+
+static void coopt_index_sift(struct coopt_option const *options, int *heap,
+			     int root, int n)
+{
+  for (;;)
+  {
+    int child = 2*root+1;
+    int t;
+    if (child>=n)
+      return;
+    if (child+1<n &&
+	coopt_index_compare(options, heap[child], heap[child+1])<0)
+      child++;
+    if (coopt_index_compare(options, heap[root], heap[child])>=0)
+      return;
+    t = heap[root];
+    heap[root] = heap[child];
+    heap[child] = t;
+    root = child;
+  }
+}
+
+/*
+ * Number of characters at the start of a and b that are the same
+ */
+static int coopt_index_common(char const *a, char const *b)
+{
+  int n=0;
+  while (a[n]!=0 && a[n]==b[n])
+    n++;
+  return n;
+}
+
+/*
+ * The first, in the original order, of sorted[lo] to sorted[hi-1]: the
+ * least of the O(log(hi-lo)) nodes of firsts that cover them exactly.
+ */
+static int coopt_index_first(struct coopt_index const *index,
+			     unsigned int lo, unsigned int hi)
+{
+  int first = index->sorted[lo], f;
+
+  for (lo+=index->num_sorted, hi+=index->num_sorted; lo<hi; lo/=2, hi/=2)
+  {
+    if (lo&1)
+    {
+      f = coopt_index_node(index, lo);
+      if (f<first)
+	first = f;
+      lo++;
+    }
+    if (hi&1)
+    {
+      hi--;
+      f = coopt_index_node(index, hi);
+      if (f<first)
+	first = f;
+    }
+  }
+  return first;
+}
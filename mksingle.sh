@@ -0,0 +1,68 @@
+#!/bin/sh
+#
+# $Id$
+# mksingle.sh
+#
+# Builds coopt_single.h, the whole of coopt in one header, from coopt.h,
+# coopt_string.h and the library sources named on the command line. The
+# output goes to stdout. Run by make; you shouldn't need to run it
+# yourself.
+#
+# usage: mksingle.sh srcdir file.c ...
+
+srcdir=$1
+shift
+
+cat <<'END'
+/*
+ * coopt_single.h
+ *
+ * The whole of coopt, the Tartarus option parsing library, in a single
+ * header; generated by mksingle.sh from the library sources, so don't
+ * edit it. See the licence in each part below.
+ *
+ * On its own this is just coopt.h. In exactly one place (or as many as
+ * you like), #define COOPT_IMPLEMENTATION before including it, and all
+ * of coopt is compiled in there as static inline functions. The compiler
+ * can then inline coopt() into your code and specialise it for your
+ * options and settings. Include this before anything else that includes
+ * coopt.h, and compile the implementation as C, not C++.
+ */
+
+#ifdef COOPT_IMPLEMENTATION
+#ifdef __cplusplus
+#error "coopt's implementation has to be compiled as C"
+#endif
+#ifndef COOPT_API
+#if defined(__STDC_VERSION__) && __STDC_VERSION__ >= 199901L
+#define COOPT_API static inline
+#elif defined(__GNUC__)
+#define COOPT_API static __inline__
+#else
+#define COOPT_API static
+#endif
+#endif
+#endif
+
+END
+
+echo "#line 1 \"coopt.h\""
+cat "$srcdir/coopt.h"
+
+echo
+echo "#if defined(COOPT_IMPLEMENTATION) && !defined(COOPT_SINGLE_IMPLEMENTED)"
+echo "#define COOPT_SINGLE_IMPLEMENTED"
+echo
+echo "#line 1 \"coopt_string.h\""
+cat "$srcdir/coopt_string.h"
+
+# Blank out the includes we've already done, so line numbers stay right
+for f in "$@"; do
+  echo
+  echo "#line 1 \"$f\""
+  sed -e 's/^#include "coopt\.h"$//' -e 's/^#include "coopt_string\.h"$//' \
+    "$srcdir/$f"
+done
+
+echo
+echo "#endif /* COOPT_IMPLEMENTATION */"
@@ -0,0 +1,148 @@
+/*
+ * $Id$
+ * parsed.c
+ *
+ * Implementation of coopt_parsed, the collected results of parsing, for
+ * coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+static void coopt_parsed_value(struct coopt_parsed *,
+			       struct coopt_parsed_option *, char const *);
+
+void coopt_parsed_init(struct coopt_parsed *parsed,
+		       struct coopt_index const *index, int argc, void *space)
+{
+  /* values first, as they're the more strictly aligned */
+  parsed->index = index;
+  parsed->values = (struct coopt_parsed_value *)space;
+  parsed->max_values = (argc>0)?(argc):(0);
+  parsed->options = (struct coopt_parsed_option *)
+	(parsed->values + parsed->max_values);
+  coopt_collect(NULL, parsed);
+}
+
+void coopt_collect(struct coopt_state *state, struct coopt_parsed *parsed)
+{
+  if (state!=NULL)
+    state->parsed = parsed;
+  if (parsed!=NULL)
+  {
+    unsigned int i;
+    for (i=0; i<parsed->index->num_options; i++)
+    {
+      parsed->options[i].count = 0;
+      parsed->options[i].first = -1;
+      parsed->options[i].last = -1;
+    }
+    parsed->arguments.count = 0;
+    parsed->arguments.first = -1;
+    parsed->arguments.last = -1;
+    parsed->num_values = 0;
+  }
+}
+
+void coopt_parsed_note(struct coopt_parsed *parsed,
+		       struct coopt_return const *ret)
+{
+  struct coopt_parsed_option *o;
+
+  if (ret->result!=COOPT_RESULT_OKAY)
+    return;
+  if (ret->opt==NULL)
+    o = &parsed->arguments;
+  else
+  {
+    o = (struct coopt_parsed_option *)coopt_parsed_option(parsed, ret->opt);
+    if (o==NULL)
+      return; /* not one of ours */
+  }
+  o->count++;
+  if (ret->param!=NULL)
+    coopt_parsed_value(parsed, o, ret->param);
+}
+
+struct coopt_parsed_option const *
+coopt_parsed_option(struct coopt_parsed const *parsed,
+		    struct coopt_option const *opt)
+{
+  struct coopt_option const *options = parsed->index->options;
+  if (opt < options || opt >= options + parsed->index->num_options)
+    return NULL;
+  return parsed->options + (opt - options);
+}
+
+struct coopt_parsed_option const *
+coopt_parsed_short(struct coopt_parsed const *parsed, char c)
+{
+  int i = coopt_index_short(parsed->index, c);
+  return (i<0)?(NULL):(parsed->options + i);
+}
+
+struct coopt_parsed_option const *
+coopt_parsed_long(struct coopt_parsed const *parsed, char const *name)
+{
+  int i = coopt_index_long(parsed->index, name, coopt_strlen(name));
+  return (i<0)?(NULL):(parsed->options + i);
+}
+
+char const *coopt_parsed_param(struct coopt_parsed const *parsed,
+			       struct coopt_parsed_option const *o)
+{
+  if (o==NULL || o->last<0)
+    return NULL;
+  return parsed->values[o->last].param;
+}
+
+/*
+ * Chain a new value onto the end of o's.
+ * Each value uses up at least one element (a separate parameter, or the
+ * rest of the element it's in), so there's always room.
+ */
+static void coopt_parsed_value(struct coopt_parsed *parsed,
+			       struct coopt_parsed_option *o,
+			       char const *param)
+{
+  int v;
+  if (parsed->num_values >= parsed->max_values)
+    return;
+  v = parsed->num_values++;
+  parsed->values[v].param = param;
+  parsed->values[v].next = -1;
+  if (o->last>=0)
+    parsed->values[o->last].next = v;
+  else
+    o->first = v;
+  o->last = v;
+}
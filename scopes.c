@@ -0,0 +1,166 @@
+/*
+ * $Id$
+ * scopes.c
+ *
+ * Implementation of coopt_scopes(), grouping options by where they are on
+ * the command line, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+
+static int coopt_scope_new(struct coopt_scopes *, int, int, int);
+
+void coopt_scopes_init(struct coopt_scopes *scopes,
+		       struct coopt_return *results, int max_results,
+		       struct coopt_scope *scope, int max_scopes)
+{
+  scopes->results = results;
+  scopes->max_results = max_results;
+  scopes->num_results = 0;
+  scopes->scopes = scope;
+  scopes->max_scopes = max_scopes;
+  scopes->num_scopes = 0;
+}
+
+/*
+ * 'group' is the innermost group still open, and 'pending' the scope
+ * gathering options for the next argument (both -1 if there isn't one),
+ * so each result is dealt with in constant time; groups are only walked
+ * at the end, to close any left open.
+ */
+int coopt_scopes(struct coopt_state *state, struct coopt_scopes *scopes)
+{
+  struct coopt_return ret;
+  struct coopt_scope *s;
+  unsigned int attributes;
+  int group = -1, pending = -1, n;
+
+  scopes->num_results = 0;
+  scopes->num_scopes = 0;
+  for (;;)
+  {
+    ret = coopt(state);
+    if (coopt_is_fatal(ret.result) || ret.result==COOPT_RESULT_END)
+      break;
+    if (scopes->num_results >= scopes->max_results)
+    {
+      ret.result = COOPT_RESULT_TOOMANY;
+      break;
+    }
+    n = scopes->num_results++;
+    scopes->results[n] = ret;
+    attributes = 0;
+    if (ret.result==COOPT_RESULT_OKAY && ret.opt!=NULL)
+      attributes = ret.opt->attributes;
+
+    if (attributes & COOPT_SCOPE_CLOSE)
+    {
+      if (group<0)
+      {
+	scopes->results[n].result = COOPT_RESULT_UNBALANCED;
+	attributes &= ~COOPT_SCOPE_CLOSE;
+      }
+      else
+      {
+	s = scopes->scopes + group;
+	s->num = n + 1 - s->first;
+	group = s->parent;
+	pending = -1;
+      }
+    }
+    if (attributes & COOPT_SCOPE_OPEN)
+    {
+      int opened = coopt_scope_new(scopes, n, group, 1);
+      if (opened<0)
+      {
+	scopes->num_results--;
+	ret.result = COOPT_RESULT_TOOMANY;
+	break;
+      }
+      group = opened;
+      pending = -1; /* options before it don't get an argument */
+    }
+    else if (!(attributes & COOPT_SCOPE_CLOSE))
+    {
+      if (pending<0)
+      {
+	pending = coopt_scope_new(scopes, n, group, 0);
+	if (pending<0)
+	{
+	  scopes->num_results--;
+	  ret.result = COOPT_RESULT_TOOMANY;
+	  break;
+	}
+      }
+      s = scopes->scopes + pending;
+      s->num = n + 1 - s->first;
+      if (ret.result==COOPT_RESULT_OKAY && ret.opt==NULL)
+      {
+	s->argument = n;
+	pending = -1;
+      }
+    }
+    if (coopt_is_termination(ret.result))
+      break; /* a missing parameter */
+  }
+
+  /*
+   * Groups still open run to the end; if that's the end of the command
+   * line, they were never closed.
+   */
+  while (group>=0)
+  {
+    s = scopes->scopes + group;
+    s->num = scopes->num_results - s->first;
+    if (coopt_is_termination(ret.result))
+      scopes->results[s->first].result = COOPT_RESULT_UNBALANCED;
+    group = s->parent;
+  }
+  return ret.result;
+}
+
+/* A new scope starting at result 'first', or -1 if there's no room */
+static int coopt_scope_new(struct coopt_scopes *scopes, int first,
+			   int parent, int group)
+{
+  struct coopt_scope *s;
+
+  if (scopes->num_scopes >= scopes->max_scopes)
+    return -1;
+  s = scopes->scopes + scopes->num_scopes;
+  s->first = first;
+  s->num = 1;
+  s->argument = -1;
+  s->parent = parent;
+  s->group = group;
+  return scopes->num_scopes++;
+}
@@ -34,10 +34,11 @@
  *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef COOPT_DEBUG
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#endif
 #include "coopt.h"
+#include "coopt_string.h"
 
 /*
  * Do we show markers in error strings?
@@ -48,8 +49,8 @@
 #define available(x) (written+x<bufsize-1) /* -1 to allow space for terminator */
 
 #define writestr(x) \
-	if (available(strlen(x))) \
-	  written+=sprintf(buffer+written, x)
+	if (available(coopt_strlen(x))) \
+	  written+=coopt_append(buffer, written, x, coopt_strlen(x))
 #define writeopt() \
         written+=coopt_sopt(buffer+written, bufsize-written, \
                             ret, SHOW_MARKERS, state)
@@ -65,6 +66,22 @@
 #define str_OKAYARG "Argument "
 #define str_OKAYOPT "Option "
 #define str_END "End of options"
+#define str_MORE "More input needed"
+#define str_TOOLONG "Command line element too long"
+#define str_TOOMANY "Too many options and arguments"
+#define str_UNBALANCED "Unmatched "
+#define str_CONFLICT " conflicts with "
+#define str_REQUIRES " requires "
+#define str_NONEOF "One of "
+#define str_NONEOF_OR " or "
+#define str_NONEOF_END " is required"
+#define str_AT_SEP ":"
+#define str_AT_END ": "
+#define str_EOL "\n"
+
+static size_t coopt_serror_related(char *, size_t, struct coopt_return *,
+				   struct coopt_state *);
+static size_t coopt_serror_number(char *, unsigned long);
 
 size_t coopt_serror(char *buffer, size_t bufsize, struct coopt_return *ret,
 		    struct coopt_state *state)
@@ -119,6 +136,47 @@ size_t coopt_serror(char *buffer, size_t bufsize, struct coopt_return *ret,
    case COOPT_RESULT_END:
     writestr(str_END);
     break;
+   case COOPT_RESULT_MORE:
+    writestr(str_MORE);
+    break;
+   case COOPT_RESULT_TOOLONG:
+    writestr(str_TOOLONG);
+    break;
+   case COOPT_RESULT_TOOMANY:
+    writestr(str_TOOMANY);
+    break;
+   case COOPT_RESULT_UNBALANCED:
+    writestr(str_UNBALANCED);
+    writeopt();
+    break;
+   case COOPT_RESULT_CONFLICT:
+    writestr(str_OKAYOPT);
+    writeopt();
+    writestr(str_CONFLICT);
+    written+=coopt_serror_related(buffer+written, bufsize-written, ret, state);
+    break;
+   case COOPT_RESULT_REQUIRES:
+    writestr(str_OKAYOPT);
+    writeopt();
+    writestr(str_REQUIRES);
+    written+=coopt_serror_related(buffer+written, bufsize-written, ret, state);
+    break;
+   case COOPT_RESULT_NONEOF:
+    if (ret->related!=NULL)
+    {
+      writestr(str_NONEOF);
+      writeopt();
+      writestr(str_NONEOF_OR);
+      written+=coopt_serror_related(buffer+written, bufsize-written,
+				    ret, state);
+    }
+    else
+    {
+      writestr(str_OKAYOPT);
+      writeopt();
+    }
+    writestr(str_NONEOF_END);
+    break;
 #ifdef COOPT_DEBUG
    default:
     fprintf(stderr, "coopt internal error: coopt_serror() passed unknown result code %i\n", ret->result);
@@ -127,3 +185,77 @@ size_t coopt_serror(char *buffer, size_t bufsize, struct coopt_return *ret,
   }
   return written;
 }
+
+/*
+ * Write out ret->related, as writeopt() would ret->opt
+ */
+static size_t coopt_serror_related(char *buffer, size_t bufsize,
+				   struct coopt_return *ret,
+				   struct coopt_state *state)
+{
+  struct coopt_return related;
+  buffer[0]=0;
+  if (ret->related==NULL)
+    return 0;
+  related = *ret;
+  related.result = COOPT_RESULT_OKAY;
+  related.opt = ret->related;
+  related.marker = coopt_marker_for(state, ret->related);
+  return coopt_sopt(buffer, bufsize, &related, SHOW_MARKERS, state);
+}
+
+/*
+ * Each diagnostic on a line of its own, as "element:offset: error",
+ * until we run out of room.
+ */
+size_t coopt_serror_diagnostics(char *buffer, size_t bufsize,
+				struct coopt_diagnostics const *diag,
+				struct coopt_state *state)
+{
+  size_t written=0;
+  unsigned int i;
+  buffer[0]=0;
+
+  if (diag==NULL || state==NULL)
+    return written; /* illegally called */
+
+  for (i=0; i<diag->num_entries; i++)
+  {
+    struct coopt_diagnostic const *d = diag->entries+i;
+    struct coopt_return ret = coopt_diagnostic_return(d);
+    char at[2*(sizeof(long)*3+1)+sizeof(str_AT_SEP str_AT_END)];
+    size_t n;
+
+    n = coopt_serror_number(at, (unsigned long)d->element);
+    coopt_memcpy(at+n, str_AT_SEP, sizeof(str_AT_SEP));
+    n += coopt_strlen(str_AT_SEP);
+    n += coopt_serror_number(at+n, (unsigned long)d->offset);
+    coopt_memcpy(at+n, str_AT_END, sizeof(str_AT_END));
+    if (!available(coopt_strlen(at)))
+      break;
+    written+=coopt_append(buffer, written, at, coopt_strlen(at));
+    written+=coopt_serror(buffer+written, bufsize-written, &ret, state);
+    if (!available(coopt_strlen(str_EOL)))
+      break;
+    writestr(str_EOL);
+  }
+  return written;
+}
+
+/* Write (n) in decimal, terminated, returning the number of digits */
+static size_t coopt_serror_number(char *out, unsigned long n)
+{
+  char digits[sizeof(long)*3];
+  size_t len=0, i;
+
+  do
+  {
+    digits[len++] = (char)('0' + n%10);
+    n /= 10;
+  }
+  while (n>0);
+  for (i=0; i<len; i++)
+    out[i] = digits[len-1-i];
+  out[len] = 0;
+  return len;
+}
@@ -34,21 +34,18 @@
  *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
+#ifdef COOPT_DEBUG
 #include <stdio.h>
-#include <stdlib.h>
-#include <string.h>
+#endif
 #include "coopt.h"
+#include "coopt_string.h"
 
 #define available(x) (written+x<bufsize-1) /* -1 to allow space for terminator */
 
-#ifndef HAVE_STRSTR
-char *strstr(char const *, char const *);
-#endif
-
 size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
                   int show_marker, struct coopt_state *state)
 {
-  size_t written=0;
+  size_t written=0, len;
   buffer[0]=0;
 
   if (ret==NULL || ret->marker==NULL)
@@ -59,8 +56,9 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
 
   if (show_marker!=0)
   {
-    if (available(strlen(ret->marker+1)))
-      written+=sprintf(buffer+written, ret->marker+1);
+    len = coopt_strlen(ret->marker+1);
+    if (available(len))
+      written+=coopt_append(buffer, written, ret->marker+1, len);
     else
       return written;
   }
@@ -86,21 +84,20 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
         if (state->flags.allow_long_eq_params && state->long_eq!=NULL)
         {
 	  /* Go up to state->long_eq within ret->param */
-	  char *eq = strstr(ret->param, state->long_eq);
+	  char *eq = coopt_strstr(ret->param, state->long_eq);
 	  if (eq==NULL)
 	  {
-	    if (available(strlen(ret->param)))
-	      written+=sprintf(buffer+written, ret->param);
+	    len = coopt_strlen(ret->param);
+	    if (available(len))
+	      written+=coopt_append(buffer, written, ret->param, len);
 	    else
 	      return written;
 	  }
 	  else
 	  {
-	    if (available(eq - ret->param))
-	    {
-	      strncat(buffer, ret->param, eq - ret->param);
-	      written=strlen(buffer);
-	    }
+	    len = eq - ret->param;
+	    if (available(len))
+	      written+=coopt_append(buffer, written, ret->param, len);
 	    else
 	      return written;
 	  }
@@ -108,8 +105,9 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
         else
         {
 	  /* Go to end of ret->param */
-	  if (available(strlen(ret->param)))
-	    written+=sprintf(buffer+written, ret->param);
+	  len = coopt_strlen(ret->param);
+	  if (available(len))
+	    written+=coopt_append(buffer, written, ret->param, len);
 	  else
 	    return written;
         }
@@ -124,7 +122,11 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
    case COOPT_RESULT_NOPARAM:
    case COOPT_RESULT_HADPARAM:
    case COOPT_RESULT_OKAY:
-   case COOPT_RESULT_MISSINGPARAM: /* display ret->opt */
+   case COOPT_RESULT_MISSINGPARAM:
+   case COOPT_RESULT_CONFLICT:
+   case COOPT_RESULT_REQUIRES:
+   case COOPT_RESULT_NONEOF:
+   case COOPT_RESULT_UNBALANCED: /* display ret->opt */
      switch (ret->marker[0])
      {
        case 'S':
@@ -137,8 +139,9 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
            return written;
          break;
        case 'L':
-         if (available(strlen(ret->opt->long_option)))
-           written+=sprintf(buffer+written, ret->opt->long_option);
+         len = coopt_strlen(ret->opt->long_option);
+         if (available(len))
+           written+=coopt_append(buffer, written, ret->opt->long_option, len);
          else
            return written;
          break;
@@ -153,3 +156,31 @@ size_t coopt_sopt(char *buffer, size_t bufsize, struct coopt_return *ret,
 
   return written;
 }
+
+char const *coopt_marker_for(struct coopt_state *state,
+			     struct coopt_option const *opt)
+{
+  int i;
+  char type = (opt->long_option!=NULL)?('L'):('S');
+  if (opt->long_option==NULL && opt->short_option==0)
+    return NULL; /* disabled option */
+  for (i=0; state->markers[i]!=NULL; i++)
+  {
+    if (state->markers[i][0]!=type)
+      continue;
+    if (state->namespaces!=NULL)
+    {
+      struct coopt_option const *options = state->namespaces[i].options;
+      unsigned int num_options = state->namespaces[i].num_options;
+      if (options==NULL)
+      {
+	options = state->options;
+	num_options = state->num_options;
+      }
+      if (opt<options || opt>=options+num_options)
+	continue; /* another namespace */
+    }
+    return state->markers[i];
+  }
+  return NULL;
+}
@@ -3,8 +3,9 @@
  * strstr.c
  *
  * Our implementation of strstr(), because we can't guarantee that's
- * either there or sane. Returns a pointer to the start of the substring,
- * or NULL if the substring is not found.
+ * either there or sane (nor that it runs in linear time, which matters
+ * when the command line is hostile). Returns a pointer to the start of
+ * the substring, or NULL if the substring is not found.
  *
  * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
  *
@@ -37,24 +38,139 @@
  *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
  */
 
-#include <stdio.h>
-#include <stdlib.h>
+/*
+ * This is Crochemore and Perrin's Two-Way algorithm, which finds a
+ * needle of length m in a haystack of length n in O(n+m) time and
+ * constant space, however repetitive either of them is. The needle is
+ * split at a "critical factorisation" u.v; we match v left to right, and
+ * then u right to left, shifting by the needle's period (remembering how
+ * much of it is known to match) or past the mismatch.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
 
-#ifndef HAVE_strstr
+static long coopt_maxsuf(unsigned char const *, long, long *, int);
 
-char *strstr(char const *haystack, char const *needle)
+char *coopt_strstr(char const *haystack, char const *needle)
 {
-  while (haystack[0]!=0)
+  unsigned char const *x = (unsigned char const *)needle;
+  unsigned char const *y = (unsigned char const *)haystack;
+  long m = coopt_strlen(needle);
+  long n, ell, per, q, i, j;
+
+  if (m==0)
+    return (char *)haystack;
+  if (m==1)
   {
-    int i=0;
-    while (haystack[i]==needle[i] && haystack[i]!=0 && needle[i]!=0)
-      i++;
-    if (needle[i]==0)
-      return (char *)haystack;
+    /* the usual long_eq; nothing to factorise, so just look for it */
+    for (; *y!=x[0]; y++)
+      if (*y==0)
+	return NULL;
+    return (char *)y;
+  }
+  n = coopt_strlen(haystack);
+  if (n<m)
+    return NULL;
 
-    haystack++;
+  /* the critical factorisation is the later of the two maximal suffixes */
+  i = coopt_maxsuf(x, m, &per, 0);
+  j = coopt_maxsuf(x, m, &q, 1);
+  if (i>j)
+    ell = i;
+  else
+  {
+    ell = j;
+    per = q;
+  }
+
+  if (coopt_memcmp(x, x+per, ell+1)==0)
+  {
+    /* periodic needle: remember how much of the left part matches */
+    long memory = -1;
+    j = 0;
+    while (j<=n-m)
+    {
+      i = ((ell>memory)?(ell):(memory))+1;
+      while (i<m && x[i]==y[i+j])
+	i++;
+      if (i>=m)
+      {
+	i = ell;
+	while (i>memory && x[i]==y[i+j])
+	  i--;
+	if (i<=memory)
+	  return (char *)(y+j);
+	j += per;
+	memory = m-per-1;
+      }
+      else
+      {
+	j += i-ell;
+	memory = -1;
+      }
+    }
   }
-  return (char *)(NULL);
+  else
+  {
+    per = ((ell+1>m-ell-1)?(ell+1):(m-ell-1))+1;
+    j = 0;
+    while (j<=n-m)
+    {
+      i = ell+1;
+      while (i<m && x[i]==y[i+j])
+	i++;
+      if (i>=m)
+      {
+	i = ell;
+	while (i>=0 && x[i]==y[i+j])
+	  i--;
+	if (i<0)
+	  return (char *)(y+j);
+	j += per;
+      }
+      else
+	j += i-ell;
+    }
+  }
+  return NULL;
 }
 
-#endif
+/*
+ * The start (less one) of the maximal suffix of x, under the usual
+ * ordering of characters or (if 'reverse') the opposite one; its period
+ * goes in *p.
+ */
+static long coopt_maxsuf(unsigned char const *x, long m, long *p, int reverse)
+{
+  long ms = -1, j = 0, k = 1;
+
+  *p = 1;
+  while (j+k<m)
+  {
+    unsigned char a = x[j+k], b = x[ms+k];
+    if (a==b)
+    {
+      if (k!=*p)
+	k++;
+      else
+      {
+	j += *p;
+	k = 1;
+      }
+    }
+    else if ((a<b)!=(reverse!=0))
+    {
+      j += k;
+      k = 1;
+      *p = j-ms;
+    }
+    else
+    {
+      ms = j;
+      j = ms+1;
+      k = *p = 1;
+    }
+  }
+  return ms;
+}
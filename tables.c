@@ -0,0 +1,210 @@
+/*
+ * $Id$
+ * tables.c
+ *
+ * Implementation of coopt_tables, option tables that can be replaced
+ * while they're in use, for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#include "coopt.h"
+
+/*
+ * Readers change 'readers' and look at 'epoch' and 'current' while a swap
+ * might be changing them, so with GCC we use its atomic builtins for
+ * those. Everything else is only touched by the one thread swapping.
+ */
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define COOPT_TABLES_ATOMIC 1
+#define tables_load(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+#define tables_store(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+#define tables_add(p, n) __atomic_add_fetch((p), (n), __ATOMIC_SEQ_CST)
+#define tables_sub(p, n) __atomic_sub_fetch((p), (n), __ATOMIC_SEQ_CST)
+#else
+#define tables_load(p) (*(p))
+#define tables_store(p, v) (*(p) = (v))
+#define tables_add(p, n) (*(p) += (n))
+#define tables_sub(p, n) (*(p) -= (n))
+#endif
+
+static void coopt_tables_lock(struct coopt_tables *);
+static void coopt_tables_unlock(struct coopt_tables *);
+
+void coopt_tables_init(struct coopt_tables *tables, struct coopt_table *first)
+{
+  tables->retire = NULL;
+  tables->retire_data = NULL;
+  tables->lock = NULL;
+  tables->unlock = NULL;
+  tables->lock_data = NULL;
+  tables->version = 1;
+  tables->epoch = 0;
+  tables->readers[0] = 0;
+  tables->readers[1] = 0;
+  tables->retired = NULL;
+  tables->last_retired = NULL;
+  first->version = tables->version;
+  tables->current = first;
+}
+
+/*
+ * Count ourselves against the epoch we're in, and make sure it's still
+ * that epoch once we have been counted; otherwise a swap could have
+ * decided we weren't there.
+ */
+struct coopt_table const *coopt_table_acquire(struct coopt_tables *tables,
+					       unsigned int *ticket)
+{
+  struct coopt_table const *table;
+  unsigned long epoch;
+
+  coopt_tables_lock(tables);
+  do
+  {
+    epoch = tables_load(&tables->epoch);
+    tables_add(&tables->readers[epoch&1], 1);
+    if (tables_load(&tables->epoch)==epoch)
+      break;
+    tables_sub(&tables->readers[epoch&1], 1);
+  }
+  while (1);
+  table = tables_load(&tables->current);
+  coopt_tables_unlock(tables);
+  *ticket = (unsigned int)(epoch&1);
+  return table;
+}
+
+void coopt_table_release(struct coopt_tables *tables, unsigned int ticket)
+{
+  coopt_tables_lock(tables);
+  tables_sub(&tables->readers[ticket&1], 1);
+  coopt_tables_unlock(tables);
+}
+
+void coopt_table_init(struct coopt_state *state,
+		      struct coopt_table const *table,
+		      int argc, char const * const *argv)
+{
+  coopt_init(state, table->options, table->num_options, argc, argv);
+  if (table->index!=NULL)
+    coopt_use_index(state, table->index);
+}
+
+unsigned long coopt_tables_swap(struct coopt_tables *tables,
+				struct coopt_table *next)
+{
+  struct coopt_table *old;
+  unsigned long version;
+
+  coopt_tables_lock(tables);
+  old = tables->current;
+  version = next->version = ++tables->version;
+  tables_store(&tables->current, next);
+  old->retired_epoch = tables->epoch;
+  old->next_retired = NULL;
+  if (tables->retired==NULL)
+    tables->retired = old;
+  else
+    tables->last_retired->next_retired = old;
+  tables->last_retired = old;
+  coopt_tables_unlock(tables);
+
+  coopt_tables_reclaim(tables);
+  return version;
+}
+
+/*
+ * Move the epoch on as far as the readers let us (two is as far as we
+ * need to go to finish with everything retired so far), and then retire
+ * the tables nobody can be using any more. We call 'retire' once we've
+ * unlocked, in case it wants to swap in another table.
+ */
+unsigned int coopt_tables_reclaim(struct coopt_tables *tables)
+{
+  struct coopt_table *done = NULL, **last_done = &done, *t;
+  unsigned int waiting = 0;
+  int i;
+
+  coopt_tables_lock(tables);
+  for (i=0; i<2 && tables->retired!=NULL; i++)
+  {
+    unsigned long epoch = tables->epoch;
+    if (epoch - tables->last_retired->retired_epoch >= 2 ||
+	tables_load(&tables->readers[(epoch+1)&1])!=0)
+      break;
+    tables_store(&tables->epoch, epoch+1);
+  }
+  while (tables->retired!=NULL &&
+	 tables->epoch - tables->retired->retired_epoch >= 2)
+  {
+    t = tables->retired;
+    tables->retired = t->next_retired;
+    t->next_retired = NULL;
+    *last_done = t;
+    last_done = &t->next_retired;
+  }
+  if (tables->retired==NULL)
+    tables->last_retired = NULL;
+  for (t=tables->retired; t!=NULL; t=t->next_retired)
+    waiting++;
+  coopt_tables_unlock(tables);
+
+  while (done!=NULL)
+  {
+    t = done;
+    done = t->next_retired;
+    t->next_retired = NULL;
+    if (tables->retire!=NULL)
+      tables->retire(tables->retire_data, t);
+  }
+  return waiting;
+}
+
+/* Only needed without atomic operations */
+static void coopt_tables_lock(struct coopt_tables *tables)
+{
+#ifndef COOPT_TABLES_ATOMIC
+  if (tables->lock!=NULL)
+    tables->lock(tables->lock_data);
+#else
+  (void)tables;
+#endif
+}
+
+static void coopt_tables_unlock(struct coopt_tables *tables)
+{
+#ifndef COOPT_TABLES_ATOMIC
+  if (tables->unlock!=NULL)
+    tables->unlock(tables->lock_data);
+#else
+  (void)tables;
+#endif
+}
@@ -0,0 +1,277 @@
+/*
+ * $Id$
+ * test-cxx.cpp
+ *
+ * checks coopt.hpp against plain coopt()
+ * (c) Copyright James Aylett 1999-2000 All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ *
+ * Only built when configure finds a C++20 compiler. Each test runs the
+ * same command lines through coopt.hpp and through a plain coopt() loop,
+ * and checks that they give the same results in the same order:
+ *
+ * 1. parse()
+ * 2. generate()
+ * 3. range pipelines over generate()
+ */
+
+#include "coopt.hpp"
+
+#include <cstdio>
+#include <cstring>
+#include <ranges>
+#include <vector>
+
+static int tests;
+static int testspassed;
+
+/* the command lines; argv[0] isn't included */
+static char const * const cmd_options[] = { "-v", "-f", "x", "--file=y",
+					    "a", "--silent", "-sg", "b" };
+static char const * const cmd_arguments[] = { "a", "--", "-v", "b" };
+static char const * const cmd_error[] = { "-v", "a", "--bogus", "b", "-s" };
+static char const * const cmd_missing[] = { "a", "-v", "-f" };
+static char const * const cmd_breved[] = { "--vi", "a", "--fi=z" };
+
+struct cmdline
+{
+  int argc;
+  char const * const *argv;
+};
+
+#define CMDLINE(a) { static_cast<int>(sizeof(a)/sizeof(a[0])), a }
+
+static cmdline const cmdlines[] = {
+  CMDLINE(cmd_options),
+  CMDLINE(cmd_arguments),
+  CMDLINE(cmd_error),
+  CMDLINE(cmd_missing),
+};
+
+static coopt_option const options[] = {
+  { 'v', COOPT_NO_PARAM, "visual", 0, 0 },
+  { 'f', COOPT_REQUIRED_PARAM, "file", 0, 0 },
+  { 's', COOPT_NO_PARAM, "silent", 0, 0 },
+  { 'g', COOPT_NO_PARAM, NULL, 0, 0 },
+};
+
+static void display_test(int test, char subtest, char const *desc)
+{
+  std::printf("%i%c. %s ... ", test, subtest, desc);
+}
+
+static void test_out(bool passed)
+{
+  std::printf("%s.\n", passed ? "passed" : "failed");
+  tests++;
+  testspassed += passed;
+}
+
+/*
+ * What coopt.hpp should give: every result up to COOPT_RESULT_END (not
+ * included), or up to and including the first that isn't okay.
+ */
+static std::vector<coopt_return> plain(coopt_state &state)
+{
+  std::vector<coopt_return> out;
+  coopt_return ret;
+  do
+  {
+    ret = coopt(&state);
+    if (ret.result==COOPT_RESULT_END)
+      break;
+    out.push_back(ret);
+  } while (coopt_is_okay(ret.result));
+  return out;
+}
+
+static std::vector<coopt_return> plain(cmdline const &c)
+{
+  coopt_state state;
+  coopt_init(&state, options, sizeof(options)/sizeof(options[0]),
+	     c.argc, c.argv);
+  return plain(state);
+}
+
+/* pointers into argv and options must match too, not just the text */
+static bool same(coopt_return const &a, coopt_return const &b)
+{
+  return a.result==b.result && a.ambigresult==b.ambigresult
+    && a.opt==b.opt && a.param==b.param && a.marker==b.marker
+    && a.related==b.related;
+}
+
+template<class R>
+static bool matches(R &&results, std::vector<coopt_return> const &expected)
+{
+  std::size_t i = 0;
+  for (auto &&r : results)
+  {
+    if (i==expected.size() || !same(r.raw(), expected[i]))
+      return false;
+    i++;
+  }
+  return i==expected.size();
+}
+
+/* the accessors should agree with the raw coopt_return */
+static bool consistent(coopt_cxx::result const &r)
+{
+  coopt_return const &raw = r.raw();
+  if (r.code()!=raw.result || r.opt()!=raw.opt
+      || r.is_okay()!=coopt_is_okay(raw.result)
+      || r.is_error()!=coopt_is_error(raw.result))
+    return false;
+  if (r.has_param()!=(raw.param!=NULL))
+    return false;
+  if (raw.param!=NULL && (r.param().data()!=raw.param
+			   || r.param().size()!=std::strlen(raw.param)))
+    return false;
+  return r.is_argument()==(raw.result==COOPT_RESULT_OKAY && raw.opt==NULL);
+}
+
+int main()
+{
+  bool passed;
+
+  display_test(1, 'a', "parse() gives the same results as coopt()");
+  passed = true;
+  for (auto const &c : cmdlines)
+  {
+    auto expected = plain(c);
+    passed = passed && matches(coopt_cxx::parse(options, c.argc, c.argv),
+			       expected);
+  }
+  test_out(passed);
+
+  display_test(1, 'b', "parse() results are consistent with coopt_return");
+  passed = true;
+  for (auto const &c : cmdlines)
+    for (auto &&r : coopt_cxx::parse(options, c.argc, c.argv))
+      passed = passed && consistent(r);
+  test_out(passed);
+
+  display_test(1, 'c', "parse() honours changes made through state()");
+  {
+    cmdline const c = CMDLINE(cmd_breved);
+    coopt_state state;
+    coopt_init(&state, options, sizeof(options)/sizeof(options[0]),
+	       c.argc, c.argv);
+    state.flags.allow_long_opts_breved = 1;
+    auto expected = plain(state);
+
+    auto p = coopt_cxx::parse(options, c.argc, c.argv);
+    p.state().flags.allow_long_opts_breved = 1;
+    passed = expected.size()==3 && matches(p, expected);
+  }
+  test_out(passed);
+
+  display_test(1, 'd', "parse() stops after the first error");
+  {
+    cmdline const c = CMDLINE(cmd_error);
+    std::size_t n = 0;
+    bool last_error = false;
+    for (auto &&r : coopt_cxx::parse(options, c.argc, c.argv))
+    {
+      n++;
+      last_error = r.is_error();
+    }
+    passed = n==3 && last_error;
+  }
+  test_out(passed);
+
+#ifdef COOPT_HPP_GENERATOR
+  display_test(2, 'a', "generate() gives the same results as coopt()");
+  passed = true;
+  for (auto const &c : cmdlines)
+  {
+    auto expected = plain(c);
+    passed = passed && matches(coopt_cxx::generate(options, c.argc, c.argv),
+			       expected);
+  }
+  test_out(passed);
+
+  display_test(2, 'b', "generate() on a configured coopt_state");
+  {
+    cmdline const c = CMDLINE(cmd_breved);
+    coopt_state state, gstate;
+    coopt_init(&state, options, sizeof(options)/sizeof(options[0]),
+	       c.argc, c.argv);
+    state.flags.allow_long_opts_breved = 1;
+    gstate = state;
+    auto expected = plain(state);
+    passed = expected.size()==3
+      && matches(coopt_cxx::generate(gstate), expected);
+  }
+  test_out(passed);
+
+  display_test(3, 'a', "filtering arguments out of generate()");
+  passed = true;
+  for (auto const &c : cmdlines)
+  {
+    std::vector<char const *> expected;
+    for (auto const &ret : plain(c))
+      if (ret.result==COOPT_RESULT_OKAY && ret.opt==NULL)
+	expected.push_back(ret.param);
+
+    std::size_t i = 0;
+    for (auto &&arg : coopt_cxx::generate(options, c.argc, c.argv)
+			| std::views::filter(&coopt_cxx::result::is_argument))
+    {
+      if (i==expected.size() || arg.param().data()!=expected[i])
+	passed = false;
+      i++;
+    }
+    passed = passed && i==expected.size();
+  }
+  test_out(passed);
+
+  display_test(3, 'b', "transforming generate() into option names");
+  {
+    cmdline const c = CMDLINE(cmd_options);
+    std::vector<char> expected;
+    for (auto const &ret : plain(c))
+      if (ret.opt!=NULL)
+	expected.push_back(ret.opt->short_option);
+
+    std::vector<char> got;
+    for (char ch : coopt_cxx::generate(options, c.argc, c.argv)
+		     | std::views::filter(&coopt_cxx::result::is_option)
+		     | std::views::transform([](coopt_cxx::result const &r)
+					     { return r.opt()->short_option; }))
+      got.push_back(ch);
+    passed = expected.size()==6 && got==expected;
+  }
+  test_out(passed);
+#endif
+
+  std::printf("\nRan %i tests, passed %i.\n", tests, testspassed);
+  return tests-testspassed;
+}
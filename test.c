@@ -39,12 +39,38 @@
  * 4. error conditions
  * 5. reconfiguration behaviours
  * 6. potential uses of the 'private' field
+ * 7. getopt() compatibility
+ * 8. bulk classification
+ * 9. permutation
+ * 10. constraints
+ * 11. parsed options
+ * 12. push parsing
+ * 13. tokenising
+ * 14. namespaces
+ * 15. caching
+ * 16. clusters of flags
+ * 17. diagnostics
+ * 18. replacing option tables
+ * 19. emitting command lines
+ * 20. fingerprints
+ * 21. scopes
+ * 22. passing options through
+ * 23. tracing
+ * 24. incremental re-parsing
  */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#ifdef COOPT_TEST_SINGLE
+#define COOPT_IMPLEMENTATION
+#include "coopt_single.h"
+#else
 #include "coopt.h"
+#endif
+#ifndef COOPT_FREESTANDING
+#include "coopt_getopt.h"
+#endif
 
 /* dupstr() - strdup, only we write it so we don't depend on it */
 char *dupstr(const char *in)
@@ -60,6 +86,8 @@ char *dupstr(const char *in)
  */
 void init_test(struct coopt_state *, struct coopt_option *, unsigned int,
 	     char *, char *);
+void reinit_test(struct coopt_state *, struct coopt_option *, unsigned int,
+		 char *);
 /*void do_test(struct coopt_state *state);*/
 
 int test;
@@ -74,13 +102,21 @@ int verboseflag;
 void init_test(struct coopt_state *state, struct coopt_option *option,
 	     unsigned int num_options, char *explanation, char *arglist)
 {
-  int argc=0, space_in_argv;
-  char **argv;
-  char *t;
   display_test(explanation);
 
   globalresult=1;
 
+  reinit_test(state, option, num_options, arglist);
+}
+
+/* Start again with another command line, within the same test */
+void reinit_test(struct coopt_state *state, struct coopt_option *option,
+		 unsigned int num_options, char *arglist)
+{
+  int argc=0, space_in_argv;
+  char **argv;
+  char *t;
+
   t = dupstr(arglist);
 
   /* Get argc, argv */
@@ -125,6 +161,7 @@ void init_test(struct coopt_state *state, struct coopt_option *option,
   }
 
 #define test_test(t) globalresult=globalresult*(((t))?(1):(0)); test_display();
+#define test_getopt(t) globalresult=globalresult*(((t))?(1):(0));
 
 void expect(struct coopt_state *state, int result)
 {
@@ -253,6 +290,126 @@ void expect_opt_ambig_param_marker(struct coopt_state *state, int result, int am
              test_string(ret.marker, marker));
 }
 
+void count_lock(void *locks)
+{
+  ((int *)locks)[0]++;
+}
+
+void count_unlock(void *locks)
+{
+  ((int *)locks)[1]++;
+}
+
+/* Adds (table) to the NULL-terminated list of tables retired so far */
+void note_retired(void *retired, struct coopt_table *table)
+{
+  struct coopt_table **r = (struct coopt_table **)retired;
+  while (*r!=NULL)
+    r++;
+  r[0] = table;
+  r[1] = NULL;
+}
+
+/* Fingerprint (arglist), allowing abbreviations; returns coopt_fingerprint() */
+int fingerprint_of(struct coopt_state *state, struct coopt_option *option,
+		   unsigned int num_options, char *arglist,
+		   struct coopt_fingerprint *fingerprint)
+{
+  reinit_test(state, option, num_options, arglist);
+  state->flags.allow_long_opts_breved = 1;
+  return coopt_fingerprint(state, fingerprint);
+}
+
+int same_fingerprint(struct coopt_fingerprint const *a,
+		     struct coopt_fingerprint const *b)
+{
+  int i;
+  for (i=0; i<4; i++)
+  {
+    if (a->hash[i]!=b->hash[i])
+      return 0;
+  }
+  return 1;
+}
+
+/* Is (s) the scope given? */
+int test_scope(struct coopt_scope const *s, int first, int num, int argument,
+	       int parent, int group)
+{
+  return (s->first==first && s->num==num && s->argument==argument &&
+	  s->parent==parent && (s->group!=0)==group);
+}
+
+/* Does coopt_passthrough() give what's expected? */
+int test_passthrough(struct coopt_state *state, int take_params, int result,
+		     struct coopt_option const *opt,
+		     char const * const *elements, int count)
+{
+  char const * const *e;
+  int n;
+  struct coopt_return ret = coopt_passthrough(state, take_params, &e, &n);
+  return (ret.result==result && ret.opt==opt && e==elements && n==count);
+}
+
+/* Is (e) the event given? (the time isn't checked) */
+int test_event(struct coopt_trace_event const *e, int kind, int element,
+	       int offset, int option, int detail)
+{
+  return (e->kind==kind && e->element==element && e->offset==offset &&
+	  e->option==option && e->detail==detail);
+}
+
+/*
+ * Replace (removed) elements of (line) from (first) with the (added) in
+ * (with), parse it again, and check it's all as parsing afresh leaves it
+ */
+int test_reparse(struct coopt_state *state, struct coopt_incremental *inc,
+		 char const **line, int *count, int first, int removed,
+		 char const * const *with, int added)
+{
+  struct coopt_state fresh;
+  struct coopt_return ret, *r;
+  int i, result;
+
+  memmove(line+first+added, line+first+removed,
+	  (*count-first-removed)*sizeof(char const *));
+  memcpy(line+first, with, added*sizeof(char const *));
+  *count += added-removed;
+  result = coopt_reparse(state, inc, *count, line, first, removed, added);
+
+  /* as coopt_init() would leave it, but with the same flags and limits */
+  fresh = *state;
+  fresh.argc = *count;
+  fresh.argv = line;
+  fresh.char_within_arg = 0;
+  fresh.skip_next_arg = 0;
+  fresh.last_marker = NULL;
+  fresh.num_results = 0;
+  for (i=0; ; i++)
+  {
+    ret = coopt(&fresh);
+    if (coopt_is_fatal(ret.result) || ret.result==COOPT_RESULT_END)
+      break;
+    if (i>=inc->num_results) /* only right if there wasn't room */
+      return (result==COOPT_RESULT_TOOMANY &&
+	      inc->num_results==inc->max_results);
+    r = inc->results + i;
+    if (r->result!=ret.result || r->ambigresult!=ret.ambigresult ||
+	r->opt!=ret.opt || r->param!=ret.param || r->marker!=ret.marker ||
+	r->related!=ret.related)
+      return 0;
+  }
+  if (i!=inc->num_results || ret.result!=result ||
+      state->num_results!=fresh.num_results)
+    return 0;
+  /*
+   * and they carry on alike (though after stopping on state->max_results,
+   * one may not have moved on to the next element yet)
+   */
+  return (coopt(state).result==coopt(&fresh).result &&
+	  (result!=COOPT_RESULT_END || state->argc==fresh.argc));
+}
+
 int main(int argc, char const * const * argv)
 {
   struct coopt_option option[6];
@@ -260,6 +417,7 @@ int main(int argc, char const * const * argv)
   struct coopt_return ret;
 
   verboseflag=0;
+  memset(option, 0, sizeof(option)); /* so attributes start clear */
 
   printf("coopt test rig.\n");
 /*  printf("available options will be:\n");
@@ -874,6 +1032,43 @@ int main(int argc, char const * const * argv)
   expect(&state,COOPT_RESULT_END);
   test_out();
 
+  init("messages containing %", "--100%s -%");
+  {
+    char message[256];
+    ret = coopt(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (test_string(message, "Unknown option --100%s"));
+    ret = coopt(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (test_string(message, "Unknown option -%"));
+  }
+  test_out();
+
+  init("element length limit", "-v --verbose=aaaaaaaa arg0 -- toolongarg ok");
+  state.max_length=9;
+  expect_opt(&state,COOPT_RESULT_OKAY, option);
+  expect_opt_param(&state,COOPT_RESULT_TOOLONG, NULL, "--verbose=aaaaaaaa");
+  expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg0");
+  expect_opt_param(&state,COOPT_RESULT_TOOLONG, NULL, "toolongarg");
+  expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "ok");
+  expect(&state,COOPT_RESULT_END);
+  test_out();
+
+  init("result limit", "-vvvvvv arg0");
+  state.max_results=3;
+  expect_opt(&state,COOPT_RESULT_OKAY, option);
+  expect_opt(&state,COOPT_RESULT_OKAY, option);
+  expect_opt(&state,COOPT_RESULT_OKAY, option);
+  expect(&state,COOPT_RESULT_TOOMANY);
+  expect(&state,COOPT_RESULT_TOOMANY);
+  test_out();
+
+  init("long_eq of several characters", "--file:=:=:x --file::=:y");
+  state.long_eq=":=:";
+  expect_opt_param(&state,COOPT_RESULT_OKAY, option+1, "=:x");
+  expect_opt_param(&state,COOPT_RESULT_BADOPTION, NULL, "file::=:y");
+  test_out();
+
   printf("\n5. reconfiguration cases\n");
   test=5;
   subtest='a';
@@ -1020,6 +1215,1656 @@ int main(int argc, char const * const * argv)
   expect(&state,COOPT_RESULT_END);
   test_out();
 
+#ifndef COOPT_FREESTANDING /* no getopt() compatibility */
+  printf("\n7. getopt() compatibility\n");
+  test=7;
+  subtest='a';
+
+  {
+    static struct option longopts[] =
+    {
+      { "verbose", no_argument, NULL, 'v' },
+      { "file", required_argument, NULL, 'f' },
+      { "colour", optional_argument, NULL, 'c' },
+      { "col", no_argument, NULL, 'C' },
+      { "silent", no_argument, NULL, 1 },
+      { NULL, 0, NULL, 0 }
+    };
+    int flag;
+    int longindex;
+    char *argv[10];
+    struct coopt_getopt_data data = COOPT_GETOPT_DATA_INITIALISER;
+
+    longopts[4].flag = &flag;
+
+    display_test("getopt()");
+    globalresult=1;
+    argv[0]="test"; argv[1]="-vf"; argv[2]="<param>"; argv[3]="-o<x>";
+    argv[4]="-o"; argv[5]="arg0"; argv[6]=NULL;
+    optind=1;
+    test_getopt (getopt(6, argv, "vf:o::")=='v' && optind==1);
+    test_getopt (getopt(6, argv, "vf:o::")=='f' && optind==3 &&
+		 test_string(optarg, "<param>"));
+    test_getopt (getopt(6, argv, "vf:o::")=='o' && optind==4 &&
+		 test_string(optarg, "<x>"));
+    test_getopt (getopt(6, argv, "vf:o::")=='o' && optind==5 &&
+		 optarg==NULL);
+    test_getopt (getopt(6, argv, "vf:o::")==-1 && optind==5);
+    test_getopt (getopt(6, argv, "vf:o::")==-1 && optind==5);
+    test_out();
+
+    display_test("getopt() errors");
+    globalresult=1;
+    argv[0]="test"; argv[1]="-z"; argv[2]="-f"; argv[3]=NULL;
+    optind=1;
+    test_getopt (getopt(3, argv, ":f:")=='?' && optopt=='z');
+    test_getopt (getopt(3, argv, ":f:")==':' && optopt=='f' && optind==3);
+    test_getopt (getopt(3, argv, ":f:")==-1);
+    test_out();
+
+    display_test("getopt_long() with permutation");
+    globalresult=1;
+    argv[0]="test"; argv[1]="arg0"; argv[2]="--verbose"; argv[3]="arg1";
+    argv[4]="--file"; argv[5]="<param>"; argv[6]="--sil"; argv[7]="--";
+    argv[8]="-v"; argv[9]=NULL;
+    optind=1;
+    flag=0;
+    test_getopt (getopt_long(9, argv, "vf:", longopts, &longindex)=='v'
+		 && longindex==0);
+    test_getopt (getopt_long(9, argv, "vf:", longopts, &longindex)=='f'
+		 && longindex==1 && test_string(optarg, "<param>"));
+    test_getopt (getopt_long(9, argv, "vf:", longopts, &longindex)==0
+		 && longindex==4 && flag==1);
+    test_getopt (getopt_long(9, argv, "vf:", longopts, &longindex)==-1
+		 && optind==6);
+    test_getopt (test_string(argv[1], "--verbose") &&
+		 test_string(argv[2], "--file") &&
+		 test_string(argv[3], "<param>") &&
+		 test_string(argv[4], "--sil") &&
+		 test_string(argv[5], "--") &&
+		 test_string(argv[6], "arg0") &&
+		 test_string(argv[7], "arg1") &&
+		 test_string(argv[8], "-v"));
+    test_out();
+
+    display_test("getopt_long_r() with optional parameters and exact matches");
+    globalresult=1;
+    argv[0]="test"; argv[1]="--col"; argv[2]="--colour=red";
+    argv[3]="--colo"; argv[4]="--c"; argv[5]="arg0"; argv[6]="-v";
+    argv[7]=NULL;
+    data.err=0;
+    test_getopt (coopt_getopt_long_r(7, argv, "+v", longopts, NULL, &data)=='C');
+    test_getopt (coopt_getopt_long_r(7, argv, "+v", longopts, NULL, &data)=='c'
+		 && test_string(data.arg, "red"));
+    test_getopt (coopt_getopt_long_r(7, argv, "+v", longopts, NULL, &data)=='c'
+		 && data.arg==NULL);
+    test_getopt (coopt_getopt_long_r(7, argv, "+v", longopts, NULL, &data)=='?');
+    test_getopt (coopt_getopt_long_r(7, argv, "+v", longopts, NULL, &data)==-1
+		 && data.ind==5);
+    test_out();
+
+    display_test("getopt_long() returning arguments in order");
+    globalresult=1;
+    argv[0]="test"; argv[1]="arg0"; argv[2]="-v"; argv[3]="arg1";
+    argv[4]=NULL;
+    optind=0;
+    test_getopt (getopt_long(4, argv, "-v", longopts, NULL)==1
+		 && test_string(optarg, "arg0"));
+    test_getopt (getopt_long(4, argv, "-v", longopts, NULL)=='v');
+    test_getopt (getopt_long(4, argv, "-v", longopts, NULL)==1
+		 && test_string(optarg, "arg1"));
+    test_getopt (getopt_long(4, argv, "-v", longopts, NULL)==-1
+		 && optind==4);
+    test_out();
+
+    display_test("getopt_long() with an ambiguous option taking a parameter");
+    globalresult=1;
+    {
+      static struct option const ambigopts[] =
+      {
+	{ "verbose", no_argument, NULL, 'v' },
+	{ "output", required_argument, NULL, 'o' },
+	{ "opt", no_argument, NULL, 'p' },
+	{ NULL, 0, NULL, 0 }
+      };
+      argv[0]="test"; argv[1]="--o"; argv[2]="--verbose"; argv[3]=NULL;
+      optind=0;
+      opterr=0;
+      test_getopt (getopt_long(3, argv, "v", ambigopts, NULL)=='?'
+		   && optind==2);
+      test_getopt (getopt_long(3, argv, "v", ambigopts, NULL)=='v'
+		   && optind==3);
+      test_getopt (getopt_long(3, argv, "v", ambigopts, NULL)==-1
+		   && optind==3);
+      opterr=1;
+    }
+    test_out();
+  }
+#endif
+
+  printf("\n8. bulk classification\n");
+  test=8;
+  subtest='a';
+
+  option[0].short_option='v';
+  option[0].has_param=COOPT_NO_PARAM;
+  option[0].long_option="verbose";
+  option[0].data=0;
+
+  option[1].short_option='f';
+  option[1].has_param=COOPT_REQUIRED_PARAM;
+  option[1].long_option="file";
+  option[1].data=0;
+
+  option[2].short_option='s';
+  option[2].long_option="silent";
+  option[2].data=0;
+
+  option[3].short_option='g';
+  option[3].long_option=NULL;
+  option[3].data=0;
+
+  option[4].short_option=0;
+  option[4].has_param=COOPT_NO_PARAM;
+  option[4].long_option="visual";
+  option[4].data=0;
+
+  {
+    unsigned long map[COOPT_CLASSMAP_WORDS(10)];
+    char const * const *args;
+
+    init("classified short and long options",
+	 "arg0 -vf <param> arg1 --file <param> - --verbose -- arg2 -arg3");
+    coopt_classify(&state, map);
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg0");
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S-");
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option+1, "<param>", "S-");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg1");
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option+1, "<param>", "L--");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "-");
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "L--");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg2");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "-arg3");
+    expect(&state,COOPT_RESULT_END);
+    test_out();
+
+    init("runs of arguments",
+	 "arg0 arg1 -v arg2 -f <param> - arg3 -- arg4 -arg5");
+    coopt_classify(&state, map);
+    test_getopt (coopt_arguments(&state, &args)==2 &&
+		 test_string(args[0], "arg0") && test_string(args[1], "arg1"));
+    test_getopt (coopt_arguments(&state, &args)==0);
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S-");
+    test_getopt (coopt_arguments(&state, &args)==1 &&
+		 test_string(args[0], "arg2"));
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option+1, "<param>", "S-");
+    test_getopt (coopt_arguments(&state, &args)==2 &&
+		 test_string(args[0], "-") && test_string(args[1], "arg3"));
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg4");
+    test_getopt (coopt_arguments(&state, &args)==1 &&
+		 test_string(args[0], "-arg5"));
+    expect(&state,COOPT_RESULT_END);
+    test_out();
+
+    init("runs of arguments, within limits",
+	 "arg0 toolongarg arg1 arg2 -v arg3 arg4");
+    coopt_classify(&state, map);
+    state.max_length = 9;
+    state.max_results = 5;
+    test_getopt (coopt_arguments(&state, &args)==1 &&
+		 test_string(args[0], "arg0") && state.num_results==1);
+    expect_opt_param(&state,COOPT_RESULT_TOOLONG, NULL, "toolongarg");
+    test_getopt (coopt_arguments(&state, &args)==2 &&
+		 test_string(args[1], "arg2") && state.num_results==4);
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S-");
+    test_getopt (coopt_arguments(&state, &args)==0);
+    expect(&state,COOPT_RESULT_TOOMANY);
+    {
+      struct coopt_trace trace;
+      struct coopt_trace_event events[4];
+
+      reinit_test(&state, option, 5, "-- arg0 arg1 toolongarg arg2");
+      coopt_classify(&state, map);
+      state.max_length = 9;
+      state.max_results = 3;
+      coopt_trace_init(&trace, events, 4);
+      coopt_trace(&state, &trace);
+      test_getopt (coopt(&state).result==COOPT_RESULT_OKAY);
+      test_getopt (coopt_arguments(&state, &args)==1 &&
+		   test_string(args[0], "arg1"));
+      test_getopt (trace.head==3 &&
+		   test_event(events+2, COOPT_TRACE_RESULT, 3, -1, -1,
+			      COOPT_RESULT_OKAY));
+      expect_opt_param(&state,COOPT_RESULT_TOOLONG, NULL, "toolongarg");
+      test_getopt (coopt_arguments(&state, &args)==0);
+      expect(&state,COOPT_RESULT_TOOMANY);
+    }
+    test_out();
+  }
+
+  printf("\n9. permutation\n");
+  test=9;
+  subtest='a';
+
+  {
+    int index[12];
+    int num_options;
+    char const * const *args;
+
+    init("options first, then arguments",
+	 "arg0 -vf <param> arg1 --file <param> arg2 -sg -- arg3 -v");
+    coopt_permute(&state, index);
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    test_getopt (ret.result==COOPT_RESULT_END);
+    test_getopt (coopt_permuted(&state, &num_options)==11 && num_options==6);
+    test_getopt (index[0]==1 && index[1]==2 && index[2]==4 && index[3]==5 &&
+		 index[4]==7 && index[5]==8);
+    test_getopt (index[6]==0 && index[7]==3 && index[8]==6 &&
+		 index[9]==9 && index[10]==10);
+    test_out();
+
+    init("partial permutation, with runs of arguments",
+	 "arg0 arg1 -v arg2 -f <param> arg3 arg4");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg0");
+    coopt_permute(&state, index);
+    test_getopt (coopt_arguments(&state, &args)==1);
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S-");
+    test_getopt (coopt_arguments(&state, &args)==1);
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option+1, "<param>", "S-");
+    expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "arg3");
+    test_getopt (coopt_permuted(&state, &num_options)==6 && num_options==3);
+    test_getopt (index[0]==1 && index[1]==3 && index[2]==4 &&
+		 index[3]==0 && index[4]==2 && index[5]==5);
+    test_out();
+  }
+
+  printf("\n10. constraints\n");
+  test=10;
+  subtest='a';
+
+  {
+    struct coopt_option const *visual[2], *file[2], *silent_visual[3];
+    struct coopt_constraint constraint[3];
+    struct coopt_constraints constraints;
+    unsigned long space[COOPT_CONSTRAINTS_WORDS(5, 3)];
+    char message[256];
+
+    visual[0] = option+4; visual[1] = NULL;
+    file[0] = option+1; file[1] = NULL;
+    silent_visual[0] = option+2; silent_visual[1] = option+4;
+    silent_visual[2] = NULL;
+    constraint[0].type = COOPT_CONFLICTS;
+    constraint[0].option = option; /* -v */
+    constraint[0].options = visual;
+    constraint[1].type = COOPT_REQUIRES;
+    constraint[1].option = option+3; /* -g */
+    constraint[1].options = file;
+    constraint[2].type = COOPT_ONE_OF;
+    constraint[2].option = NULL;
+    constraint[2].options = silent_visual;
+    coopt_constraints_init(&constraints, constraint, 3, option, 5, space);
+
+    init("conflicts and requirements", "-v --visual -g");
+    coopt_constrain(&state, &constraints);
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    test_getopt (ret.result==COOPT_RESULT_END);
+    ret = coopt_check(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (ret.result==COOPT_RESULT_CONFLICT && ret.opt==option &&
+		 ret.related==option+4);
+    test_getopt (test_string(message, "Option --verbose conflicts with --visual"));
+    ret = coopt_check(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (ret.result==COOPT_RESULT_REQUIRES && ret.opt==option+3 &&
+		 ret.related==option+1);
+    test_getopt (test_string(message, "Option -g requires --file"));
+    ret = coopt_check(&state);
+    test_getopt (ret.result==COOPT_RESULT_END);
+    test_out();
+
+    init("one of a group", "-s --visual -v");
+    coopt_constrain(&state, &constraints);
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    ret = coopt_check(&state);
+    test_getopt (ret.result==COOPT_RESULT_CONFLICT && ret.opt==option);
+    ret = coopt_check(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (ret.result==COOPT_RESULT_CONFLICT && ret.opt==option+2 &&
+		 ret.related==option+4);
+    test_getopt (test_string(message, "Option --silent conflicts with --visual"));
+    ret = coopt_check(&state);
+    test_getopt (ret.result==COOPT_RESULT_END);
+    test_out();
+
+    init("none of a group", "-f <param>");
+    coopt_constrain(&state, &constraints);
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    ret = coopt_check(&state);
+    coopt_serror(message, 256, &ret, &state);
+    test_getopt (ret.result==COOPT_RESULT_NONEOF && ret.opt==option+2 &&
+		 ret.related==option+4);
+    test_getopt (test_string(message, "One of --silent or --visual is required"));
+    ret = coopt_check(&state);
+    test_getopt (ret.result==COOPT_RESULT_END);
+    test_out();
+
+    init("no constraints", "-s --visual");
+    ret = coopt_check(&state);
+    test_getopt (ret.result==COOPT_RESULT_END);
+    test_out();
+  }
+
+  printf("\n11. parsed options\n");
+  test=11;
+  subtest='a';
+
+  {
+    struct coopt_index index;
+    int slots[COOPT_INDEX_SIZE(5)];
+    struct coopt_parsed parsed;
+    struct coopt_parsed_option const *o;
+    void *space;
+
+    display_test("compiled index");
+    globalresult=1;
+    coopt_index_init(&index, option, 5, 0, slots);
+    test_getopt (coopt_index_short(&index, 'v')==0);
+    test_getopt (coopt_index_short(&index, 'g')==3);
+    test_getopt (coopt_index_short(&index, 'x')==-1);
+    test_getopt (coopt_index_short(&index, 0)==-1);
+    test_getopt (coopt_index_long(&index, "visual", 6)==4);
+    test_getopt (coopt_index_long(&index, "file=fish", 4)==1);
+    test_getopt (coopt_index_long(&index, "fil", 3)==-1);
+    test_getopt (coopt_index_long(&index, "silently", 8)==-1);
+    {
+      int ambiguous;
+      test_getopt (coopt_index_abbrev(&index, "vi", 2, &ambiguous)==4 &&
+		   ambiguous==0);
+      test_getopt (coopt_index_abbrev(&index, "v", 1, &ambiguous)==0 &&
+		   ambiguous==1);
+      test_getopt (coopt_index_abbrev(&index, "x", 1, &ambiguous)==-1);
+    }
+    {
+      /* the first of a run of abbreviations isn't the first by name */
+      static struct coopt_option const runs[] =
+      {
+	{ 0, COOPT_NO_PARAM, "zeta", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "opt3", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "other", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "opt1", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "opt2", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "opt0", 0, 0 },
+      };
+      struct coopt_index runs_index;
+      int runs_slots[COOPT_INDEX_SIZE(6)], ambiguous;
+      coopt_index_init(&runs_index, runs, 6, 0, runs_slots);
+      test_getopt (coopt_index_abbrev(&runs_index, "opt", 3, &ambiguous)==1 &&
+		   ambiguous==3);
+      test_getopt (coopt_index_abbrev(&runs_index, "o", 1, &ambiguous)==1 &&
+		   ambiguous==4);
+      test_getopt (coopt_index_abbrev(&runs_index, "opt0", 4, &ambiguous)==5 &&
+		   ambiguous==0);
+      test_getopt (coopt_index_abbrev(&runs_index, "ot", 2, &ambiguous)==2 &&
+		   ambiguous==0);
+    }
+    test_out();
+
+    init("coopt() using the index", "--vi --v --fi=x -gs --silent");
+    coopt_use_index(&state, &index);
+    state.flags.allow_long_opts_breved=1;
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option+4, NULL, "L--");
+    expect_opt(&state,COOPT_RESULT_AMBIGUOUSOPT, option);
+    expect_opt_param(&state,COOPT_RESULT_OKAY, option+1, "x");
+    expect_opt(&state,COOPT_RESULT_OKAY, option+3);
+    expect_opt(&state,COOPT_RESULT_OKAY, option+2);
+    state.flags.allow_long_opts_breved=0;
+    expect_opt(&state,COOPT_RESULT_OKAY, option+2);
+    expect(&state,COOPT_RESULT_END);
+    test_out();
+
+    init("presence, last value and all values",
+	 "-v arg0 -f one --file=two -s -v arg1 --file three");
+    space = malloc(COOPT_PARSED_SIZE(5, 11));
+    coopt_parsed_init(&parsed, &index, 11, space);
+    coopt_collect(&state, &parsed);
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    test_getopt (ret.result==COOPT_RESULT_END);
+    o = coopt_parsed_long(&parsed, "verbose");
+    test_getopt (o!=NULL && o==coopt_parsed_short(&parsed, 'v') &&
+		 o==coopt_parsed_option(&parsed, option));
+    test_getopt (o->count==2 && coopt_parsed_param(&parsed, o)==NULL);
+    o = coopt_parsed_short(&parsed, 'f');
+    test_getopt (o!=NULL && o->count==3);
+    test_getopt (test_string(coopt_parsed_param(&parsed, o), "three"));
+    test_getopt (test_string(parsed.values[o->first].param, "one"));
+    test_getopt (test_string(parsed.values[parsed.values[o->first].next].param,
+			     "two"));
+    o = coopt_parsed_short(&parsed, 'g');
+    test_getopt (o!=NULL && o->count==0);
+    test_getopt (coopt_parsed_long(&parsed, "gibbon")==NULL);
+    test_getopt (parsed.arguments.count==2);
+    test_getopt (test_string(coopt_parsed_param(&parsed, &parsed.arguments),
+			     "arg1"));
+    test_out();
+
+    init("arguments skipped in bulk", "a b -v c");
+    coopt_collect(&state, &parsed);
+    {
+      char const * const *args;
+      test_getopt (coopt_arguments(&state, &args)==2);
+    }
+    do
+    {
+      ret = coopt(&state);
+    } while (coopt_is_okay(ret.result));
+    test_getopt (parsed.arguments.count==3 &&
+		 coopt_parsed_short(&parsed, 'v')->count==1);
+    test_getopt (test_string(parsed.values[parsed.arguments.first].param, "a"));
+    test_out();
+    free(space);
+
+    {
+      struct coopt_index attached;
+      struct coopt_option attached_option[5];
+      size_t size = coopt_image_write(&index, NULL, 0);
+      int *image = malloc(size); /* malloc() aligns it for us */
+
+      display_test("binary images");
+      globalresult=1;
+      test_getopt (coopt_image_write(&index, image, size)==size);
+      test_getopt (coopt_image_num_options(image, size)==5);
+      test_getopt (coopt_image_attach(&attached, attached_option, 4,
+				      image, size)==-1);
+      test_getopt (coopt_image_attach(&attached, attached_option, 5,
+				      image, size-1)==-1);
+      test_getopt (coopt_image_attach(&attached, attached_option, 5,
+				      image, size)==0);
+      test_getopt (test_string(attached_option[1].long_option, "file") &&
+		   attached_option[1].has_param==COOPT_REQUIRED_PARAM &&
+		   attached_option[3].long_option==NULL &&
+		   attached_option[3].short_option=='g');
+      test_getopt (attached_option[1].long_option > (char *)image &&
+		   attached_option[1].long_option < (char *)image + size);
+      test_getopt (coopt_index_long(&attached, "visual", 6)==4 &&
+		   coopt_index_short(&attached, 's')==2);
+      image[1]++; /* version */
+      test_getopt (coopt_image_num_options(image, size)==-1);
+      test_getopt (coopt_image_attach(&attached, attached_option, 5,
+				      image, size)==-1);
+      image[1]--;
+      {
+	/* a hash table with no empty slot would have coopt_index_long()
+	 * probing for ever, so an image mustn't be able to give it one:
+	 * this squeezes two long options into two slots
+	 */
+	static struct coopt_option const pair[] =
+	{
+	  { 0, COOPT_NO_PARAM, "aa", 0, 0 },
+	  { 0, COOPT_NO_PARAM, "bb", 0, 0 },
+	};
+	struct coopt_index pair_index;
+	struct coopt_option pair_option[2];
+	int pair_slots[COOPT_INDEX_SIZE(2)];
+	size_t pair_size, full_size, before = 12 + 4*2 + 256;
+	unsigned long slots;
+	int *pair_image, *full;
+
+	coopt_index_init(&pair_index, pair, 2, 0, pair_slots);
+	slots = pair_index.mask + 1;
+	pair_size = coopt_image_write(&pair_index, NULL, 0);
+	full_size = pair_size - (slots-2)*sizeof(int);
+	pair_image = malloc(pair_size);
+	full = malloc(full_size);
+	if (pair_image==NULL || full==NULL)
+	{
+	  fprintf(stderr, "Couldn't allocate space for images\n");
+	  exit(1);
+	}
+	coopt_image_write(&pair_index, pair_image, pair_size);
+	test_getopt (coopt_image_attach(&attached, pair_option, 2,
+					pair_image, pair_size)==0);
+	memcpy(full, pair_image, before*sizeof(int));
+	full[4] = full_size;
+	full[7] = 1; /* mask */
+	full[before] = 0;
+	full[before+1] = 1;
+	memcpy(full+before+2, pair_image+before+slots,
+	       pair_size - (before+slots)*sizeof(int));
+	test_getopt (coopt_image_attach(&attached, pair_option, 2,
+					full, full_size)==-1);
+	free(pair_image);
+	free(full);
+      }
+      test_out();
+
+      coopt_image_attach(&attached, attached_option, 5, image, size);
+      init_test(&state, attached_option, 5, "coopt() using an image",
+		"--visual -fx --file y a");
+      coopt_use_index(&state, &attached);
+      expect_opt(&state,COOPT_RESULT_OKAY, attached_option+4);
+      expect_opt_param(&state,COOPT_RESULT_OKAY, attached_option+1, "x");
+      expect_opt_param(&state,COOPT_RESULT_OKAY, attached_option+1, "y");
+      expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "a");
+      expect(&state,COOPT_RESULT_END);
+      test_out();
+      free(image);
+    }
+  }
+
+  printf("\n12. push parsing\n");
+  test=12;
+  subtest='a';
+
+  {
+    static char const stream[] = "a\0-vf\0x\0--file\0y\0--silent\0--\0-v";
+    /* how many results are final after each byte */
+    static int const final[] = { 0, 0, 1, 1, 1, 1, 2, 2, 3, 3, 3, 3, 3, 3, 3,
+				 3, 3, 4, 4, 4, 4, 4, 4, 4, 4, 4, 5, 5, 5, 5,
+				 5, 5 };
+    struct coopt_feed feed;
+    char buffer[24];
+    char got[64];
+    size_t fed, step, n, taken;
+    int results;
+
+    for (step=1; step<=3; step+=2)
+    {
+      display_test((step==1)?("a byte at a time"):("three bytes at a time"));
+      globalresult=1;
+      coopt_feed_init(&feed, option, 5, buffer, sizeof(buffer));
+      got[0]=0;
+      results=0;
+      for (fed=0; ; fed+=n)
+      {
+	n=sizeof(stream)-1-fed;
+	if (n>step)
+	  n=step;
+	if (n==0)
+	  coopt_feed_end(&feed);
+	taken=0;
+	for (;;)
+	{
+	  /* it won't take more than two elements at once */
+	  taken += coopt_feed(&feed, stream+fed+taken, n-taken);
+	  ret = coopt_feed_next(&feed);
+	  if (ret.result!=COOPT_RESULT_OKAY)
+	    break;
+	  results++;
+	  strcat(got, (ret.opt==NULL)?(ret.param):(ret.opt->long_option));
+	  if (ret.opt!=NULL && ret.param!=NULL)
+	  {
+	    strcat(got, "=");
+	    strcat(got, ret.param);
+	  }
+	  strcat(got, " ");
+	}
+	if (n>0)
+	{
+	  test_getopt (ret.result==COOPT_RESULT_MORE && taken==n &&
+		       results==final[fed+n]);
+	}
+	else
+	{
+	  test_getopt (ret.result==COOPT_RESULT_END);
+	  break;
+	}
+      }
+      test_getopt (test_string(got, "a verbose file=x file=y silent -v "));
+      test_out();
+    }
+
+    display_test("bounded buffer");
+    globalresult=1;
+    coopt_feed_init(&feed, option, 5, buffer, 8);
+    test_getopt (coopt_feed(&feed, "-v\0-f", 5)==5);
+    ret = coopt_feed_next(&feed);
+    test_getopt (ret.result==COOPT_RESULT_OKAY && ret.opt==option);
+    test_getopt (coopt_feed_next(&feed).result==COOPT_RESULT_MORE);
+    /* room for "-f" and five bytes, but not the terminator */
+    test_getopt (coopt_feed(&feed, "\0abcdefgh", 10)==5);
+    test_getopt (coopt_feed_next(&feed).result==COOPT_RESULT_ERROR);
+    test_out();
+
+    display_test("ambiguous option waiting for its parameter");
+    globalresult=1;
+    {
+      static struct coopt_option const outs[] =
+      {
+	{ 0, COOPT_REQUIRED_PARAM, "output", 0, 0 },
+	{ 0, COOPT_NO_PARAM, "outer", 0, 0 },
+      };
+      coopt_feed_init(&feed, outs, 2, buffer, sizeof(buffer));
+      feed.state.flags.allow_long_opts_breved = 1;
+      test_getopt (coopt_feed(&feed, "--out", 6)==6);
+      test_getopt (coopt_feed_next(&feed).result==COOPT_RESULT_MORE);
+      test_getopt (coopt_feed(&feed, "x", 1)==1);
+      coopt_feed_end(&feed);
+      ret = coopt_feed_next(&feed);
+      test_getopt (ret.result==COOPT_RESULT_AMBIGUOUSOPT &&
+		   ret.ambigresult==COOPT_RESULT_OKAY &&
+		   test_string(ret.param, "x"));
+      test_getopt (coopt_feed_next(&feed).result==COOPT_RESULT_END);
+    }
+    test_out();
+  }
+
+  printf("\n13. tokenising\n");
+  test=13;
+  subtest='a';
+
+  {
+    char line[64];
+    char const *args[8];
+    int n;
+
+    display_test("plain elements, in place");
+    globalresult=1;
+    strcpy(line, "  -v\t--file x\n a ");
+    n = coopt_tokenise(line, args, 8);
+    test_getopt (n==4 && args[0]==line+2 && args[1]==line+5 &&
+		 args[2]==line+12 && args[3]==line+15);
+    if (n==4)
+    {
+      coopt_init(&state, option, 5, n, args);
+      expect_opt(&state,COOPT_RESULT_OKAY, option);
+      expect_opt_param(&state,COOPT_RESULT_OKAY, option+1, "x");
+      expect_opt_param(&state,COOPT_RESULT_OKAY, NULL, "a");
+      expect(&state,COOPT_RESULT_END);
+    }
+    test_out();
+
+    display_test("quoting");
+    globalresult=1;
+    strcpy(line, "a'b c'd \"x\\\"y\\\\\\$z\\q\" \\  '' e\\\nf");
+    n = coopt_tokenise(line, args, 8);
+    test_getopt (n==5);
+    if (n==5)
+    {
+      test_getopt (test_string(args[0], "ab cd"));
+      test_getopt (test_string(args[1], "x\"y\\$z\\q"));
+      test_getopt (test_string(args[2], " "));
+      test_getopt (test_string(args[3], ""));
+      test_getopt (test_string(args[4], "ef"));
+    }
+    test_out();
+
+    display_test("errors and too many elements");
+    globalresult=1;
+    strcpy(line, "a 'b");
+    test_getopt (coopt_tokenise(line, args, 8)==-1);
+    strcpy(line, "a \"b\\\"");
+    test_getopt (coopt_tokenise(line, args, 8)==-1);
+    strcpy(line, "a b\\");
+    test_getopt (coopt_tokenise(line, args, 8)==-1);
+    strcpy(line, "  ");
+    test_getopt (coopt_tokenise(line, args, 8)==0);
+    strcpy(line, "a b c");
+    test_getopt (coopt_tokenise(line, args, 2)==3 &&
+		 test_string(args[0], "a") && test_string(args[1], "b"));
+    test_out();
+
+    display_test("line continuations on their own");
+    globalresult=1;
+    strcpy(line, "a \\\n b");
+    n = coopt_tokenise(line, args, 8);
+    test_getopt (n==2 && test_string(args[0], "a") &&
+		 test_string(args[1], "b"));
+    strcpy(line, "a \\\n");
+    test_getopt (coopt_tokenise(line, args, 8)==1);
+    strcpy(line, "''");
+    n = coopt_tokenise(line, args, 8);
+    test_getopt (n==1 && test_string(args[0], ""));
+    test_out();
+  }
+
+  printf("\n14. namespaces\n");
+  test=14;
+  subtest='a';
+
+  {
+    static struct coopt_option const plus_option[] = {
+      { 'v', COOPT_NO_PARAM, "visible", 0, 0 },
+      { 'x', COOPT_REQUIRED_PARAM, "extra", 0, 0 }
+    };
+    static char const * const markers[] = { "L--", "L++", "S-", "S+", NULL };
+    struct coopt_namespace ns[4];
+    struct coopt_index index, plus_index;
+    int slots[COOPT_INDEX_SIZE(5)], plus_slots[COOPT_INDEX_SIZE(2)];
+    int indexed;
+
+    coopt_index_init(&index, option, 5, 0, slots);
+    coopt_index_init(&plus_index, plus_option, 2, 0, plus_slots);
+    ns[0].options = ns[2].options = NULL;
+    ns[0].num_options = ns[2].num_options = 0;
+    ns[0].index = ns[2].index = NULL;
+    ns[1].options = ns[3].options = plus_option;
+    ns[1].num_options = ns[3].num_options = 2;
+
+    for (indexed=0; indexed<2; indexed++)
+    {
+      init((indexed)?("separate indexes"):("separate tables"),
+	   "-v +v +xfoo -x --verbose ++visible ++verbose +f");
+      state.markers = markers;
+      if (indexed)
+	coopt_use_index(&state, &index);
+      ns[1].index = ns[3].index = (indexed)?(&plus_index):(NULL);
+      coopt_use_namespaces(&state, ns);
+      expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S-");
+      expect_opt_param_marker(&state,COOPT_RESULT_OKAY, plus_option, NULL,
+			      "S+");
+      expect_opt_param_marker(&state,COOPT_RESULT_OKAY, plus_option+1, "foo",
+			      "S+");
+      expect_opt_param_marker(&state,COOPT_RESULT_BADOPTION, NULL, "x", "S-");
+      expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "L--");
+      expect_opt_param_marker(&state,COOPT_RESULT_OKAY, plus_option, NULL,
+			      "L++");
+      expect_opt_param_marker(&state,COOPT_RESULT_BADOPTION, NULL, "verbose",
+			      "L++");
+      expect_opt_param_marker(&state,COOPT_RESULT_BADOPTION, NULL, "f", "S+");
+      expect(&state,COOPT_RESULT_END);
+      test_out();
+    }
+
+    init("back to one table", "+v ++verbose");
+    state.markers = markers;
+    coopt_use_namespaces(&state, ns);
+    test_getopt (test_string(coopt_marker_for(&state, option), "L--"));
+    test_getopt (test_string(coopt_marker_for(&state, option+3), "S-"));
+    test_getopt (test_string(coopt_marker_for(&state, plus_option), "L++"));
+    coopt_use_namespaces(&state, NULL);
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "S+");
+    expect_opt_param_marker(&state,COOPT_RESULT_OKAY, option, NULL, "L++");
+    expect(&state,COOPT_RESULT_END);
+    test_out();
+  }
+
+  printf("\n15. caching\n");
+  test=15;
+  subtest='a';
+
+  {
+    struct coopt_cache cache, other;
+    struct coopt_return results[8];
+    char const * const *args;
+    void *space, *other_space, *image;
+    size_t size;
+    int n, locks[2];
+
+    space = malloc(COOPT_CACHE_SIZE(2, 512));
+    other_space = malloc(COOPT_CACHE_SIZE(2, 512));
+    if (space==NULL || other_space==NULL)
+    {
+      fprintf(stderr, "Couldn't allocate space for cache\n");
+      exit(1);
+    }
+    coopt_cache_init(&cache, option, 5, 2, 512, space);
+
+    init("misses and hits", "-vf x --silent a");
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==5 && cache.lookups==1 && cache.hits==0);
+    reinit_test(&state, option, 5, "-vf x --silent a");
+    args = state.argv;
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==5 && cache.lookups==2 && cache.hits==1);
+    if (n==5)
+    {
+      test_getopt (results[0].result==COOPT_RESULT_OKAY &&
+		   results[0].opt==option &&
+		   test_string(results[0].marker, "S-"));
+      test_getopt (results[1].opt==option+1 && results[1].param==args[1]);
+      test_getopt (results[2].opt==option+2 &&
+		   test_string(results[2].marker, "L--"));
+      test_getopt (results[3].opt==NULL && results[3].param==args[3]);
+      test_getopt (results[4].result==COOPT_RESULT_END);
+    }
+    test_getopt (state.argc==0);
+    reinit_test(&state, option, 5, "-vf x --silent a");
+    test_getopt (coopt_cache_run(&cache, &state, results, 2)==5 &&
+		 cache.hits==2);
+    test_out();
+
+    init("eviction and keys", "-v");
+    coopt_cache_run(&cache, &state, results, 8);
+    reinit_test(&state, option, 5, "-s");
+    coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (cache.evictions==1 && cache.hits==2);
+    reinit_test(&state, option, 5, "-v");
+    coopt_cache_run(&cache, &state, results, 8);
+    reinit_test(&state, option, 5, "-vf x --silent a");
+    coopt_cache_run(&cache, &state, results, 8);
+    reinit_test(&state, option, 5, "-v");
+    coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (cache.evictions==2 && cache.hits==4);
+    reinit_test(&state, option, 5, "-s");
+    coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (cache.evictions==3 && cache.hits==4);
+    reinit_test(&state, option, 5, "-s");
+    state.flags.allow_mix_short_params = 1;
+    coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (cache.lookups==10 && cache.hits==4);
+    reinit_test(&state, option, 4, "-s");
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==2 && results[0].opt==option+2 && cache.lookups==10);
+    test_getopt (cache.collisions==0);
+    test_out();
+
+    display_test("saving and loading");
+    globalresult=1;
+    size = coopt_cache_write(&cache, NULL, 0);
+    image = malloc(size);
+    if (image==NULL)
+    {
+      fprintf(stderr, "Couldn't allocate space for cache image\n");
+      exit(1);
+    }
+    test_getopt (coopt_cache_write(&cache, image, size)==size);
+    coopt_cache_init(&other, option, 4, 2, 512, other_space);
+    test_getopt (coopt_cache_read(&other, image, size)==-1);
+    coopt_cache_init(&other, option, 5, 1, 512, other_space);
+    test_getopt (coopt_cache_read(&other, image, size)==2);
+    test_getopt (coopt_cache_read(&other, image, size-1)==-1);
+    reinit_test(&state, option, 5, "-s");
+    state.flags.allow_mix_short_params = 1;
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==2 && results[0].opt==option+2 && other.hits==0);
+    reinit_test(&state, option, 5, "-s");
+    state.flags.allow_mix_short_params = 1;
+    n = coopt_cache_run(&other, &state, results, 8);
+    test_getopt (n==2 && results[0].opt==option+2 && other.hits==1);
+    test_getopt (state.num_results==1);
+    free(image);
+    test_out();
+
+    display_test("locking");
+    globalresult=1;
+    locks[0] = locks[1] = 0;
+    cache.lock = count_lock;
+    cache.unlock = count_unlock;
+    cache.lock_data = locks;
+    reinit_test(&state, option, 5, "-v --file y");
+    coopt_cache_run(&cache, &state, results, 8);
+    reinit_test(&state, option, 5, "-v --file y");
+    coopt_cache_run(&cache, &state, results, 8);
+    coopt_cache_write(&cache, NULL, 0);
+    test_getopt (locks[0]==4 && locks[1]==4);
+    test_out();
+
+    init("limits after a hit", "-v -s -v a");
+    state.max_results = 2;
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==3 && results[2].result==COOPT_RESULT_TOOMANY &&
+		 state.num_results==2);
+    reinit_test(&state, option, 5, "-v -s -v a");
+    state.max_results = 2;
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==3 && results[2].result==COOPT_RESULT_TOOMANY &&
+		 state.num_results==2 && cache.hits==7);
+    test_getopt (coopt(&state).result==COOPT_RESULT_TOOMANY);
+    reinit_test(&state, option, 5, "-vf x --silent a");
+    n = coopt_cache_run(&cache, &state, results, 8);
+    test_getopt (n==5 && state.num_results==4);
+    test_out();
+
+    free(space);
+    free(other_space);
+  }
+
+  printf("\n16. clusters of flags\n");
+  test=16;
+  subtest='a';
+
+  {
+    unsigned long flags[COOPT_FLAGMAP_WORDS(5)];
+    struct coopt_return ret;
+
+    init("flags and the rest", "-vsg -f x --verbose -gv a");
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_OKAY && ret.opt==option+1 &&
+		 test_string(ret.param, "x") &&
+		 flags[0]==((1UL<<0) | (1UL<<2) | (1UL<<3)));
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.opt==option && test_string(ret.marker, "L--") &&
+		 flags[0]==0);
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.opt==NULL && test_string(ret.param, "a") &&
+		 coopt_flagmap_test(flags, 0) && coopt_flagmap_test(flags, 3) &&
+		 !coopt_flagmap_test(flags, 2));
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_END && flags[0]==0);
+    test_out();
+
+    init("errors where coopt() has them", "-vqs -vfs");
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_BADOPTION &&
+		 test_string(ret.param, "qs") && flags[0]==(1UL<<0));
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_OKAY && ret.opt==option+1 &&
+		 test_string(ret.param, "s") &&
+		 flags[0]==((1UL<<0) | (1UL<<2)));
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_END && flags[0]==0);
+    reinit_test(&state, option, 5, "-fgf x y");
+    state.flags.allow_mix_short_params = 1;
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.opt==option+1 && test_string(ret.param, "x") &&
+		 flags[0]==0);
+    ret = coopt_cluster(&state, flags);
+    test_getopt (ret.result==COOPT_RESULT_MULTIMIXED && ret.opt==option+1 &&
+		 flags[0]==(1UL<<3));
+    test_out();
+  }
+
+  printf("\n17. diagnostics\n");
+  test=17;
+  subtest='a';
+
+  {
+    struct coopt_diagnostic entries[4];
+    struct coopt_diagnostics diag;
+    char buffer[256];
+
+    coopt_diagnostics_init(&diag, entries, 4);
+    init("all the errors in one go",
+	 "-vqf a --bogus --verbose=x -zs b --file");
+    coopt_diagnose(&state, &diag);
+    expect_opt(&state, COOPT_RESULT_OKAY, option);
+    expect_opt_param(&state, COOPT_RESULT_OKAY, option+1, "a");
+    expect_opt(&state, COOPT_RESULT_OKAY, option+2);
+    expect_opt_param(&state, COOPT_RESULT_OKAY, NULL, "b");
+    expect(&state, COOPT_RESULT_END);
+    test_getopt (diag.count==5 && diag.num_entries==4);
+    test_getopt (entries[0].result==COOPT_RESULT_BADOPTION &&
+		 entries[0].element==0 && entries[0].offset==2);
+    test_getopt (entries[1].result==COOPT_RESULT_BADOPTION &&
+		 entries[1].element==2 && entries[1].offset==2);
+    test_getopt (entries[2].result==COOPT_RESULT_HADPARAM &&
+		 entries[2].opt==option && entries[2].element==3 &&
+		 entries[2].offset==2);
+    test_getopt (entries[3].result==COOPT_RESULT_BADOPTION &&
+		 entries[3].element==4 && entries[3].offset==1);
+    coopt_serror_diagnostics(buffer, sizeof(buffer), &diag, &state);
+    test_getopt (test_string(buffer, "0:2: Unknown option -q\n"
+			     "2:2: Unknown option --bogus\n"
+			     "3:2: Parameter given to --verbose\n"
+			     "4:1: Unknown option -z\n"));
+    test_out();
+
+    init("positions, and stopping", "--v a -gf");
+    state.flags.allow_long_opts_breved = 1;
+    coopt_diagnose(&state, &diag);
+    expect_opt_param(&state, COOPT_RESULT_OKAY, NULL, "a");
+    expect_opt(&state, COOPT_RESULT_OKAY, option+3);
+    expect(&state, COOPT_RESULT_END);
+    test_getopt (diag.count==2 && diag.num_entries==2);
+    test_getopt (entries[0].result==COOPT_RESULT_AMBIGUOUSOPT &&
+		 entries[0].element==0 && entries[0].offset==2);
+    test_getopt (entries[1].result==COOPT_RESULT_MISSINGPARAM &&
+		 entries[1].opt==option+1 && entries[1].element==2 &&
+		 entries[1].offset==2);
+    test_getopt (coopt_serror_diagnostics(buffer, 40, &diag, &state)==38 &&
+		 test_string(buffer, "0:2: Ambiguous abbreviation --verbose\n"));
+    test_getopt (coopt_serror_diagnostics(buffer, 7, &diag, &state)==5 &&
+		 test_string(buffer, "0:2: "));
+    reinit_test(&state, option, 5, "-zzz");
+    state.max_results = 2;
+    coopt_diagnose(&state, &diag);
+    expect(&state, COOPT_RESULT_TOOMANY);
+    test_getopt (diag.count==2);
+    reinit_test(&state, option, 5, "-zv");
+    coopt_diagnose(&state, &diag);
+    coopt_diagnose(&state, NULL);
+    expect(&state, COOPT_RESULT_BADOPTION);
+    test_getopt (diag.count==0);
+    test_out();
+  }
+
+  printf("\n18. replacing option tables\n");
+  test=18;
+  subtest='a';
+
+  {
+    struct coopt_table first, second, third;
+    struct coopt_tables tables;
+    struct coopt_table const *t, *u;
+    struct coopt_table *retired[4];
+    unsigned int ticket, other_ticket;
+    char const *args[] = { "--visual", "-v" };
+
+    first.options = option;
+    first.num_options = 5;
+    first.index = NULL;
+    second = third = first;
+    second.num_options = 4;
+
+    display_test("new readers get the new table");
+    globalresult=1;
+    retired[0] = NULL;
+    coopt_tables_init(&tables, &first);
+    tables.retire = note_retired;
+    tables.retire_data = retired;
+    t = coopt_table_acquire(&tables, &ticket);
+    test_getopt (t==&first && t->version==1);
+    coopt_table_init(&state, t, 2, args);
+    expect_opt(&state, COOPT_RESULT_OKAY, option+4);
+    test_getopt (coopt_tables_swap(&tables, &second)==2);
+    u = coopt_table_acquire(&tables, &other_ticket);
+    test_getopt (u==&second && u->version==2);
+    coopt_table_init(&state, u, 2, args);
+    expect(&state, COOPT_RESULT_BADOPTION);
+    expect_opt(&state, COOPT_RESULT_OKAY, option);
+    coopt_table_release(&tables, other_ticket);
+    test_getopt (retired[0]==NULL);
+    coopt_table_release(&tables, ticket);
+    test_getopt (coopt_tables_reclaim(&tables)==0 && retired[0]==&first &&
+		 retired[1]==NULL);
+    test_out();
+
+    display_test("old tables wait for their readers");
+    globalresult=1;
+    retired[0] = NULL;
+    t = coopt_table_acquire(&tables, &ticket);
+    coopt_tables_swap(&tables, &third);
+    coopt_tables_swap(&tables, &first);
+    test_getopt (t==&second && retired[0]==NULL &&
+		 coopt_tables_reclaim(&tables)==2);
+    u = coopt_table_acquire(&tables, &other_ticket);
+    test_getopt (u==&first && u->version==4);
+    coopt_table_init(&state, t, 2, args);
+    expect(&state, COOPT_RESULT_BADOPTION);
+    coopt_table_release(&tables, ticket);
+    /* third went in the same epoch as the second reader started */
+    test_getopt (coopt_tables_reclaim(&tables)==1 && retired[0]==&second &&
+		 retired[1]==NULL);
+    coopt_table_release(&tables, other_ticket);
+    test_getopt (coopt_tables_reclaim(&tables)==0 && retired[1]==&third &&
+		 retired[2]==NULL);
+    test_out();
+  }
+
+  printf("\n19. emitting command lines\n");
+  test=19;
+  subtest='a';
+
+  {
+    struct coopt_emitter emitter;
+    struct coopt_return results[10];
+    char const *out[12];
+    char arena[64];
+    int i, n;
+
+    init("canonical forms", "-vfx --sil --visual -g --file=y b -- -q");
+    state.flags.allow_long_opts_breved = 1;
+    for (n=0; n<10; n++)
+    {
+      results[n] = coopt(&state);
+      if (!coopt_is_okay(results[n].result))
+	break;
+    }
+    coopt_emitter_init(&emitter, out, 12, arena, sizeof(arena));
+    test_getopt (out[0]==NULL);
+    for (i=0; i<n; i++)
+    {
+      test_getopt (coopt_emit(&emitter, results+i)==0);
+    }
+    test_getopt (coopt_emitted(&emitter)==11 && out[11]==NULL);
+    test_getopt (test_string(out[0], "--verbose") &&
+		 test_string(out[1], "--file") && out[2]==results[1].param &&
+		 test_string(out[2], "x") && test_string(out[3], "--silent") &&
+		 test_string(out[4], "--visual") && test_string(out[5], "-g") &&
+		 test_string(out[6], "--file") && out[7]==results[5].param &&
+		 out[8]==results[6].param && test_string(out[9], "--") &&
+		 out[10]==results[7].param && test_string(out[10], "-q"));
+    test_getopt (coopt_emit(&emitter, results)==-2);
+    test_out();
+
+    display_test("other forms, and running out of room");
+    globalresult=1;
+    coopt_emitter_init(&emitter, out, 12, arena, 25);
+    emitter.flags.prefer_short = 1;
+    emitter.flags.long_eq_params = 1;
+    emitter.flags.short_inline_params = 1;
+    test_getopt (coopt_emit_element(&emitter, "prog")==0);
+    for (i=0; i<5; i++)
+    {
+      test_getopt (coopt_emit(&emitter, results+i)==0);
+    }
+    /* -fy needs 4 more bytes, and there are only 3 */
+    test_getopt (coopt_emit(&emitter, results+5)==-1);
+    test_getopt (coopt_emitted(&emitter)==6 && out[6]==NULL);
+    test_getopt (test_string(out[0], "prog") && test_string(out[1], "-v") &&
+		 test_string(out[2], "-fx") && test_string(out[3], "-s") &&
+		 test_string(out[4], "--visual") && test_string(out[5], "-g"));
+    coopt_emitter_init(&emitter, out, 3, arena, sizeof(arena));
+    emitter.flags.long_eq_params = 1;
+    test_getopt (coopt_emit(&emitter, results+1)==0 &&
+		 test_string(out[0], "--file=x"));
+    test_getopt (coopt_emit(&emitter, results+7)==-1 &&
+		 coopt_emit(&emitter, results+6)==0 &&
+		 coopt_emit(&emitter, results+6)==-1);
+    reinit_test(&state, option, 5, "-z");
+    results[0] = coopt(&state);
+    test_getopt (coopt_emit(&emitter, results)==-2 &&
+		 coopt_emitted(&emitter)==2 && out[2]==NULL);
+    test_out();
+  }
+
+  printf("\n20. fingerprints\n");
+  test=20;
+  subtest='a';
+
+  {
+    static struct coopt_option fp_option[] = {
+      { 'O', COOPT_REQUIRED_PARAM, "optimise", 0, COOPT_UNORDERED },
+      { 'g', COOPT_NO_PARAM, "debug", 0, COOPT_UNORDERED },
+      { 'o', COOPT_REQUIRED_PARAM, "output", 0, 0 },
+      { 'v', COOPT_NO_PARAM, "verbose", 0, 0 }
+    };
+    struct coopt_fingerprint a, b;
+    int i;
+
+    display_test("ways of writing the same thing");
+    globalresult=1;
+    test_getopt (fingerprint_of(&state, fp_option, 4, "-O2 -g -o x y",
+				&a)==COOPT_RESULT_END);
+    test_getopt (fingerprint_of(&state, fp_option, 4,
+				"--optimise=2 --debug --output x y",
+				&b)==COOPT_RESULT_END && same_fingerprint(&a, &b));
+    test_getopt (fingerprint_of(&state, fp_option, 4,
+				"-O 2 --deb --out=x y", &b)==COOPT_RESULT_END &&
+		 same_fingerprint(&a, &b));
+    test_getopt (fingerprint_of(&state, fp_option, 4, "-gO2 -ox y",
+				&b)==COOPT_RESULT_END && same_fingerprint(&a, &b));
+    for (i=0; i<4; i++)
+    {
+      test_getopt (a.hash[i]<=0xffffffffUL);
+    }
+    test_out();
+
+    display_test("unordered options");
+    globalresult=1;
+    fingerprint_of(&state, fp_option, 4, "-g -O2 -o x y -O3", &a);
+    fingerprint_of(&state, fp_option, 4, "-O3 -o x -O2 -g y", &b);
+    test_getopt (same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-O2 -g -O3 -o x y -g", &b);
+    test_getopt (!same_fingerprint(&a, &b)); /* -g twice isn't -g once */
+    fingerprint_of(&state, fp_option, 4, "-O23 -o x y", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    test_out();
+
+    display_test("things that do matter");
+    globalresult=1;
+    fingerprint_of(&state, fp_option, 4, "-v -o x y z", &a);
+    fingerprint_of(&state, fp_option, 4, "-o x -v y z", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-v -o x z y", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-v -o xy z", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-v -o x yz", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-v -o x y", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "", &a);
+    fingerprint_of(&state, fp_option, 4, "-O", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    test_out();
+
+    display_test("errors");
+    globalresult=1;
+    test_getopt (fingerprint_of(&state, fp_option, 4, "-v -o",
+				&a)==COOPT_RESULT_MISSINGPARAM);
+    test_getopt (fingerprint_of(&state, fp_option, 4, "-v -z y",
+				&a)==COOPT_RESULT_END);
+    fingerprint_of(&state, fp_option, 4, "-v y", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    fingerprint_of(&state, fp_option, 4, "-v -q y", &b);
+    test_getopt (!same_fingerprint(&a, &b));
+    test_out();
+  }
+
+  printf("\n21. scopes\n");
+  test=21;
+  subtest='a';
+
+  {
+    static struct coopt_option scope_option[] = {
+      { 'c', COOPT_REQUIRED_PARAM, "codec", 0, 0 },
+      { 'v', COOPT_NO_PARAM, "verbose", 0, 0 },
+      { '(', COOPT_NO_PARAM, "start-group", 0, COOPT_SCOPE_OPEN },
+      { ')', COOPT_NO_PARAM, "end-group", 0, COOPT_SCOPE_CLOSE },
+      { 0, COOPT_NO_PARAM, "next-group", 0,
+	COOPT_SCOPE_OPEN | COOPT_SCOPE_CLOSE }
+    };
+    struct coopt_scopes scopes;
+    struct coopt_return results[12];
+    struct coopt_scope scope[12];
+    struct coopt_scope const *s = scope;
+    char buf[64];
+
+    coopt_scopes_init(&scopes, results, 12, scope, 12);
+    display_test("options for each argument");
+    globalresult=1;
+    reinit_test(&state, scope_option, 5, "-c x in1 -vcy in2 in3 -v");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_END);
+    test_getopt (scopes.num_results==7 && scopes.num_scopes==4);
+    test_getopt (test_scope(s, 0, 2, 1, -1, 0) &&
+		 test_scope(s+1, 2, 3, 4, -1, 0) &&
+		 test_scope(s+2, 5, 1, 5, -1, 0) &&
+		 test_scope(s+3, 6, 1, -1, -1, 0));
+    test_getopt (results[3].opt==scope_option &&
+		 test_string(results[3].param, "y") &&
+		 test_string(results[4].param, "in2"));
+    test_out();
+
+    display_test("groups");
+    globalresult=1;
+    reinit_test(&state, scope_option, 5,
+		"a --start-group -c x b -v -( c -) -v --end-group d");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_END);
+    test_getopt (scopes.num_results==11 && scopes.num_scopes==8);
+    test_getopt (test_scope(s, 0, 1, 0, -1, 0) &&
+		 test_scope(s+1, 1, 9, -1, -1, 1) &&
+		 test_scope(s+2, 2, 2, 3, 1, 0) &&
+		 test_scope(s+3, 4, 1, -1, 1, 0) &&
+		 test_scope(s+4, 5, 3, -1, 1, 1) &&
+		 test_scope(s+5, 6, 1, 6, 4, 0) &&
+		 test_scope(s+6, 8, 1, -1, 1, 0) &&
+		 test_scope(s+7, 10, 1, 10, -1, 0));
+    test_getopt (results[8].opt==scope_option+1 &&
+		 results[9].opt==scope_option+3);
+    reinit_test(&state, scope_option, 5, "-( a --next-group b -)");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_END);
+    test_getopt (scopes.num_scopes==4 && test_scope(s, 0, 3, -1, -1, 1) &&
+		 test_scope(s+1, 1, 1, 1, 0, 0) &&
+		 test_scope(s+2, 2, 3, -1, -1, 1) &&
+		 test_scope(s+3, 3, 1, 3, 2, 0));
+    test_out();
+
+    display_test("unbalanced groups");
+    globalresult=1;
+    reinit_test(&state, scope_option, 5, "-) a -( -( b");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_END);
+    test_getopt (scopes.num_results==5 && scopes.num_scopes==4);
+    test_getopt (results[0].result==COOPT_RESULT_UNBALANCED &&
+		 results[1].result==COOPT_RESULT_OKAY &&
+		 results[2].result==COOPT_RESULT_UNBALANCED &&
+		 results[3].result==COOPT_RESULT_UNBALANCED &&
+		 results[4].result==COOPT_RESULT_OKAY);
+    test_getopt (test_scope(s, 0, 2, 1, -1, 0) &&
+		 test_scope(s+1, 2, 3, -1, -1, 1) &&
+		 test_scope(s+2, 3, 2, -1, 1, 1) &&
+		 test_scope(s+3, 4, 1, 4, 2, 0));
+    coopt_serror(buf, sizeof(buf), results, &state);
+    test_getopt (test_string(buf, "Unmatched -)"));
+    coopt_serror(buf, sizeof(buf), results+3, &state);
+    test_getopt (test_string(buf, "Unmatched -("));
+    test_out();
+
+    display_test("errors and running out of room");
+    globalresult=1;
+    reinit_test(&state, scope_option, 5, "-z a -( -c");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_MISSINGPARAM);
+    test_getopt (scopes.num_results==4 && scopes.num_scopes==3 &&
+		 results[0].result==COOPT_RESULT_BADOPTION &&
+		 results[2].result==COOPT_RESULT_UNBALANCED &&
+		 test_scope(s, 0, 2, 1, -1, 0) &&
+		 test_scope(s+1, 2, 2, -1, -1, 1) &&
+		 test_scope(s+2, 3, 1, -1, 1, 0));
+    coopt_scopes_init(&scopes, results, 3, scope, 12);
+    reinit_test(&state, scope_option, 5, "-( a b c -)");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_TOOMANY);
+    test_getopt (scopes.num_results==3 && scopes.num_scopes==3 &&
+		 results[0].result==COOPT_RESULT_OKAY &&
+		 test_scope(s, 0, 3, -1, -1, 1));
+    coopt_scopes_init(&scopes, results, 12, scope, 2);
+    reinit_test(&state, scope_option, 5, "a b c");
+    test_getopt (coopt_scopes(&state, &scopes)==COOPT_RESULT_TOOMANY);
+    test_getopt (scopes.num_results==2 && scopes.num_scopes==2);
+    test_out();
+  }
+
+  printf("\n22. passing options through\n");
+  test=22;
+  subtest='a';
+
+  {
+    struct coopt_index index;
+    int slots[COOPT_INDEX_SIZE(5)];
+    char const * const *base;
+    int indexed;
+
+    coopt_index_init(&index, option, 5, 0, slots);
+    for (indexed=0; indexed<2; indexed++)
+    {
+      init((indexed)?("unknown options and parameters, indexed"):
+	   ("unknown options and parameters"),
+	   "-v --foo=1 -W all -x y --bar z -vs --visual -- -q");
+      if (indexed)
+      {
+	coopt_use_index(&state, &index);
+      }
+      base = state.argv;
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				    base+1, 1));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				    base+2, 2));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				    base+4, 2));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				    base+6, 2));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option+2,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option+4,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, NULL,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_END, NULL,
+				    NULL, 0));
+      test_out();
+    }
+
+    init("without parameters", "-x y --bar=1 -vz -Wall -f -q -q -x -v");
+    base = state.argv;
+    test_getopt (test_passthrough(&state, 0, COOPT_RESULT_BADOPTION, NULL,
+				  base, 1));
+    test_getopt (test_passthrough(&state, 0, COOPT_RESULT_OKAY, NULL,
+				  NULL, 0));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  base+2, 1));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option,
+				  NULL, 0));
+    /* part way through a block, so not passed through */
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  NULL, 0));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  base+4, 1));
+    /* -f's parameter isn't looked at again */
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option+1,
+				  NULL, 0));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  base+7, 1));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  base+8, 1));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option,
+				  NULL, 0));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_END, NULL,
+				  NULL, 0));
+    reinit_test(&state, option, 5, "-x -y");
+    state.max_results = 1;
+    base = state.argv;
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				  base, 1));
+    test_getopt (test_passthrough(&state, 1, COOPT_RESULT_TOOMANY, NULL,
+				  NULL, 0));
+    test_out();
+
+    display_test("with diagnostics");
+    globalresult=1;
+    {
+      struct coopt_diagnostics diag;
+      struct coopt_diagnostic entries[4];
+
+      coopt_diagnostics_init(&diag, entries, 4);
+      reinit_test(&state, option, 5, "-vz --silent=1 --foo x");
+      coopt_diagnose(&state, &diag);
+      base = state.argv;
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_OKAY, option,
+				    NULL, 0));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_BADOPTION, NULL,
+				    base+2, 2));
+      test_getopt (test_passthrough(&state, 1, COOPT_RESULT_END, NULL,
+				    NULL, 0));
+      /* -z and --silent=1 are still errors */
+      test_getopt (diag.num_entries==2 &&
+		   entries[0].result==COOPT_RESULT_BADOPTION &&
+		   entries[1].result==COOPT_RESULT_HADPARAM &&
+		   state.diagnostics==&diag);
+    }
+    test_out();
+  }
+
+  printf("\n23. tracing\n");
+  test=23;
+  subtest='a';
+
+  {
+    struct coopt_trace trace;
+    struct coopt_trace_event events[20], *e = events;
+    struct coopt_trace_event const *saved;
+    unsigned long buffer[(COOPT_TRACE_SIZE(20) + sizeof(long) - 1)/
+			 sizeof(long)];
+    size_t size;
+
+    init("events", "-vf x --visual y");
+    coopt_trace_init(&trace, events, 20);
+    coopt_trace(&state, &trace);
+    while (coopt_is_okay(coopt(&state).result))
+      ;
+    test_getopt (trace.head==13);
+    test_getopt (test_event(e, COOPT_TRACE_MARKER, 0, 0, -1, 1) &&
+		 test_event(e+1, COOPT_TRACE_SHORT, 0, 1, 0, 'v') &&
+		 test_event(e+2, COOPT_TRACE_RESULT, 0, 2, 0,
+			    COOPT_RESULT_OKAY));
+    test_getopt (test_event(e+3, COOPT_TRACE_SHORT, 0, 2, 1, 'f') &&
+		 test_event(e+4, COOPT_TRACE_SKIP, 0, 3, 1, 1) &&
+		 test_event(e+5, COOPT_TRACE_RESULT, 0, 3, 1,
+			    COOPT_RESULT_OKAY));
+    test_getopt (test_event(e+6, COOPT_TRACE_SKIP, 1, 0, -1, 0) &&
+		 test_event(e+7, COOPT_TRACE_MARKER, 2, 0, -1, 0) &&
+		 test_event(e+8, COOPT_TRACE_LONG, 2, 0, 4, 6) &&
+		 test_event(e+9, COOPT_TRACE_RESULT, 3, 0, 4,
+			    COOPT_RESULT_OKAY));
+    test_getopt (test_event(e+10, COOPT_TRACE_MARKER, 3, 0, -1, -1) &&
+		 test_event(e+11, COOPT_TRACE_RESULT, 4, 0, -1,
+			    COOPT_RESULT_OKAY) &&
+		 test_event(e+12, COOPT_TRACE_RESULT, 4, 0, -1,
+			    COOPT_RESULT_END));
+    /* and nothing more once it's stopped */
+    reinit_test(&state, option, 5, "-v -- x");
+    coopt_trace(&state, &trace);
+    test_getopt (coopt(&state).result==COOPT_RESULT_OKAY);
+    coopt_trace(&state, NULL);
+    while (coopt_is_okay(coopt(&state).result))
+      ;
+    test_getopt (trace.head==16 &&
+		 test_event(e+15, COOPT_TRACE_RESULT, 0, 2, 0,
+			    COOPT_RESULT_OKAY));
+    test_out();
+
+    display_test("saving, and wrapping round");
+    globalresult=1;
+    coopt_trace_init(&trace, events, 7); /* four, of which three kept */
+    reinit_test(&state, option, 5, "-v -s -x");
+    coopt_trace(&state, &trace);
+    while (coopt_is_okay(coopt(&state).result))
+      ;
+    test_getopt (trace.mask==3 && trace.head==9);
+    size = coopt_trace_write(&trace, NULL, 0);
+    test_getopt (size==COOPT_TRACE_SIZE(3));
+    test_getopt (coopt_trace_write(&trace, buffer, size-1)==size);
+    test_getopt (coopt_trace_write(&trace, buffer, sizeof(buffer))==size);
+    test_getopt (coopt_trace_events(buffer, size, &saved)==3);
+    test_getopt (saved!=NULL &&
+		 test_event(saved, COOPT_TRACE_MARKER, 2, 0, -1, 1) &&
+		 test_event(saved+1, COOPT_TRACE_SHORT, 2, 1, -1, 'x') &&
+		 test_event(saved+2, COOPT_TRACE_RESULT, 2, 2, -1,
+			    COOPT_RESULT_BADOPTION));
+    test_getopt (coopt_trace_events(buffer, size-1, &saved)==-1);
+    buffer[0]++;
+    test_getopt (coopt_trace_events(buffer, size, &saved)==-1 &&
+		 saved==NULL);
+    coopt_trace_init(&trace, events, 0);
+    test_getopt (coopt_trace_write(&trace, buffer, sizeof(buffer))==
+		 COOPT_TRACE_SIZE(0));
+    test_getopt (coopt_trace_events(buffer, COOPT_TRACE_SIZE(0), &saved)==0);
+    test_out();
+  }
+
+  printf("\n24. incremental re-parsing\n");
+  test=24;
+  subtest='a';
+
+  {
+    struct coopt_incremental inc;
+    struct coopt_return results[64];
+    struct coopt_checkpoint checkpoints[64];
+    char const *line[64];
+    char const *with[4];
+    int count, i;
+
+    init("editing", "-v a -f x --visual b -- -s c");
+    count = state.argc;
+    memcpy(line, state.argv, count*sizeof(char const *));
+    coopt_init(&state, option, 5, count, line);
+    coopt_incremental_init(&inc, results, 64, checkpoints, 64);
+    test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_END &&
+		 inc.num_results==7 && inc.num_changed==7);
+    /* nothing changed, so nothing is parsed again */
+    test_getopt (test_reparse(&state, &inc, line, &count, 4, 0, with, 0) &&
+		 inc.num_changed==0 && inc.num_results==7);
+    with[0] = "-s";
+    test_getopt (test_reparse(&state, &inc, line, &count, 1, 1, with, 1) &&
+		 inc.first_changed==1 && inc.num_changed==1);
+    with[0] = "y"; /* -f's parameter */
+    test_getopt (test_reparse(&state, &inc, line, &count, 3, 1, with, 1) &&
+		 inc.first_changed==2 && inc.num_changed==1 &&
+		 inc.results[2].param==with[0]);
+    with[0] = "-g";
+    with[1] = "-gs";
+    test_getopt (test_reparse(&state, &inc, line, &count, 5, 0, with, 2) &&
+		 inc.num_results==10 && inc.num_changed==3);
+    /* without the separator, the rest are options */
+    test_getopt (test_reparse(&state, &inc, line, &count, 8, 1, with, 0) &&
+		 inc.results[8].opt==option+2);
+    with[0] = "--";
+    test_getopt (test_reparse(&state, &inc, line, &count, 8, 0, with, 1) &&
+		 inc.results[8].opt==NULL);
+    /* -f's parameter becomes an argument */
+    with[0] = "-v";
+    test_getopt (test_reparse(&state, &inc, line, &count, 2, 1, with, 1) &&
+		 inc.num_results==11);
+    with[0] = "d";
+    with[1] = "-f";
+    test_getopt (test_reparse(&state, &inc, line, &count, count, 0, with, 2)
+		 && inc.results[inc.num_results-1].result==
+		    COOPT_RESULT_OKAY);
+    with[0] = "--";
+    test_getopt (test_reparse(&state, &inc, line, &count, 8, 1, with, 0) &&
+		 inc.results[inc.num_results-1].result==
+		 COOPT_RESULT_MISSINGPARAM);
+    with[0] = "e";
+    test_getopt (test_reparse(&state, &inc, line, &count, count, 0, with, 1));
+    test_getopt (test_reparse(&state, &inc, line, &count, 0, count, with, 0)
+		 && inc.num_results==0);
+    test_out();
+
+    display_test("only what changed is parsed again");
+    globalresult=1;
+    for (count=0; count<40; count++)
+      line[count] = (count%2) ? "a" : "-vs";
+    coopt_init(&state, option, 5, count, line);
+    coopt_incremental_init(&inc, results, 64, checkpoints, 64);
+    test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_END &&
+		 inc.num_results==60);
+    with[0] = "-f";
+    test_getopt (test_reparse(&state, &inc, line, &count, 20, 1, with, 1) &&
+		 inc.first_changed==30 && inc.num_changed==1 &&
+		 inc.num_results==58);
+    /* between -f and its parameter */
+    with[0] = "-x";
+    with[1] = "-vz";
+    test_getopt (test_reparse(&state, &inc, line, &count, 21, 0, with, 2) &&
+		 inc.first_changed==30 && inc.num_changed==4 &&
+		 inc.num_results==61);
+    test_out();
+
+    display_test("running short of room");
+    globalresult=1;
+    for (count=0; count<40; count++)
+      line[count] = (count%2) ? "a" : "-vs";
+    coopt_init(&state, option, 5, count, line);
+    coopt_incremental_init(&inc, results, 64, checkpoints, 3);
+    test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_END &&
+		 inc.num_checkpoints<=3);
+    for (i=0; i<8; i++)
+    {
+      with[0] = (i%2) ? "-f" : "-s";
+      test_getopt (test_reparse(&state, &inc, line, &count, 5*i, 1, with,
+				1));
+    }
+    for (count=0; count<40; count++)
+      line[count] = (count%2) ? "a" : "-vs";
+    coopt_init(&state, option, 5, count, line);
+    coopt_incremental_init(&inc, results, 62, checkpoints, 3);
+    test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_END &&
+		 inc.num_results==60);
+    with[0] = "-vsg";
+    test_getopt (test_reparse(&state, &inc, line, &count, 20, 1, with, 1) &&
+		 inc.num_results==61);
+    test_getopt (test_reparse(&state, &inc, line, &count, 38, 1, with, 1) &&
+		 inc.num_results==62);
+    with[0] = "-vsgv";
+    test_getopt (test_reparse(&state, &inc, line, &count, 0, 1, with, 1) &&
+		 inc.num_results==62 && inc.ran_out);
+    with[0] = "b";
+    test_getopt (test_reparse(&state, &inc, line, &count, 0, 1, with, 1) &&
+		 inc.num_results==61);
+    test_out();
+
+    display_test("with a limit on results");
+    globalresult=1;
+    reinit_test(&state, option, 5, "-v a -vs");
+    state.max_results = 2;
+    count = state.argc;
+    memcpy(line, state.argv, count*sizeof(char const *));
+    state.argv = line;
+    test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_TOOMANY &&
+		 inc.num_results==2);
+    with[0] = "-s";
+    test_getopt (test_reparse(&state, &inc, line, &count, 1, 1, with, 1));
+    with[0] = "a";
+    test_getopt (test_reparse(&state, &inc, line, &count, 0, 1, with, 1));
+    with[0] = "-v";
+    test_getopt (test_reparse(&state, &inc, line, &count, 0, 0, with, 1));
+    test_out();
+
+    display_test("what it won't do");
+    globalresult=1;
+    {
+      struct coopt_diagnostics diag;
+      struct coopt_diagnostic entries[4];
+
+      coopt_diagnostics_init(&diag, entries, 4);
+      coopt_diagnose(&state, &diag);
+      test_getopt (coopt_incremental(&state, &inc)==COOPT_RESULT_ERROR);
+      state.diagnostics = NULL;
+    }
+    test_getopt (coopt_reparse(&state, &inc, count+1, line, 0, 0, 0)==
+		 COOPT_RESULT_ERROR);
+    test_getopt (coopt_reparse(&state, &inc, count, line, count, 1, 1)==
+		 COOPT_RESULT_ERROR);
+    test_out();
+  }
+
   printf("\nRan %i tests, passed %i.\n", tests, testspassed);
 
   return (tests-testspassed);
@@ -0,0 +1,183 @@
+/*
+ * $Id$
+ * tokenise.c
+ *
+ * Implementation of command line splitting (coopt_tokenise()) for coopt.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * We scan for the characters that matter with a table of what each
+ * character is; elements are usually only a few characters long, which
+ * is too short for strspn() and strcspn() to make up for setting up
+ * their own tables on every call. Text is only moved once an element has
+ * had some quoting removed from it; until then, the element is left where
+ * it is and just gets terminated.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+/* Classes of character */
+#define COOPT_TOKENISE_ORDINARY	(0)
+#define COOPT_TOKENISE_SPACE	(1) /* space, tab and newline */
+#define COOPT_TOKENISE_QUOTE	(2) /* quotes and backslash */
+#define COOPT_TOKENISE_END	(3) /* the terminator */
+
+static unsigned char const coopt_tokenise_class[256] =
+{
+  3, 0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 0, 2, 0, 0, 0, 0, 2, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 2, 0, 0, 0
+  /* and the rest are ordinary */
+};
+
+#define coopt_tokenise_is(c, class) \
+	(coopt_tokenise_class[(unsigned char)(c)]==(class))
+
+static char *coopt_tokenise_double(char **, char *);
+
+int coopt_tokenise(char *line, char const **argv, int max_argv)
+{
+  char *in = line;
+  int count = 0;
+
+  for (;;)
+  {
+    char *start, *out;
+    char end;
+    int quoted = 0; /* so '' is an element, though an empty one */
+
+    while (coopt_tokenise_is(*in, COOPT_TOKENISE_SPACE))
+      in++;
+    if (*in==0)
+      return count;
+
+    start = out = in;
+    for (;;)
+    {
+      size_t n = 0;
+      while (coopt_tokenise_is(in[n], COOPT_TOKENISE_ORDINARY))
+	n++;
+      if (out!=in)
+	coopt_memmove(out, in, n);
+      out += n;
+      in += n;
+
+      if (*in=='\'')
+      {
+	char *close = coopt_strchr(in+1, '\'');
+	if (close==NULL)
+	  return -1;
+	n = close-(in+1);
+	coopt_memmove(out, in+1, n);
+	out += n;
+	in = close+1;
+	quoted = 1;
+      }
+      else if (*in=='"')
+      {
+	in++;
+	quoted = 1;
+	out = coopt_tokenise_double(&in, out);
+	if (out==NULL)
+	  return -1;
+      }
+      else if (*in=='\\')
+      {
+	if (in[1]==0)
+	  return -1;
+	/* backslash newline is a line continuation, and goes completely */
+	if (in[1]!='\n')
+	  *out++ = in[1];
+	in += 2;
+      }
+      else
+	break;
+    }
+
+    /* *in is a space or the terminator, and out may be the same place */
+    end = *in;
+    if (end!=0)
+      in++;
+    if (out==start && !quoted)
+    {
+      /* nothing but line continuations, which aren't an element */
+      if (end==0)
+	return count;
+      continue;
+    }
+    *out = 0;
+    if (count<max_argv)
+      argv[count] = start;
+    count++;
+    if (end==0)
+      return count;
+  }
+}
+
+/*
+ * Copy the inside of a double quoted string to 'out', leaving '*in' after
+ * the closing quote. Backslash only escapes a few characters in here.
+ * Returns where to carry on writing, or NULL if the quote isn't closed.
+ */
+static char *coopt_tokenise_double(char **in, char *out)
+{
+  char *p = *in;
+
+  for (;;)
+  {
+    size_t n = coopt_strcspn(p, "\"\\");
+    coopt_memmove(out, p, n);
+    out += n;
+    p += n;
+    if (*p==0)
+      return NULL;
+    if (*p=='"')
+    {
+      *in = p+1;
+      return out;
+    }
+    /* a backslash */
+    if (p[1]=='$' || p[1]=='`' || p[1]=='"' || p[1]=='\\')
+    {
+      *out++ = p[1];
+      p += 2;
+    }
+    else if (p[1]=='\n')
+      p += 2;
+    else
+      *out++ = *p++;
+  }
+}
@@ -0,0 +1,202 @@
+/*
+ * $Id$
+ * tools.c
+ *
+ * Things shared by the programs built alongside libcoopt: reading option
+ * specs, and naming results.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * The spec has one option per line:
+ *
+ *   <short> <long> [param] [attributes]
+ *
+ * where <short> is a single character and <long> the long option, either
+ * of which may be "-" if there isn't one, "param" means the option takes
+ * a parameter, and the attributes are any of "unordered", "scope-open"
+ * and "scope-close" (for COOPT_UNORDERED and so on). Blank lines and
+ * lines starting with '#' are ignored.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "coopt.h"
+#include "tools.h"
+
+#define MAX_LINE 1024
+#define MAX_SEEDS 65536
+#define MAX_FIELDS 8
+
+char const * const spec_attributes[SPEC_NUM_ATTRIBUTES] =
+{
+  "unordered", "scope-open", "scope-close"
+};
+
+static struct
+{
+  int result;
+  char const *name;
+} const results[] =
+{
+  { COOPT_RESULT_ERROR, "ERROR" },
+  { COOPT_RESULT_NOPARAM, "NOPARAM" },
+  { COOPT_RESULT_TOOMANY, "TOOMANY" },
+  { COOPT_RESULT_BADOPTION, "BADOPTION" },
+  { COOPT_RESULT_AMBIGUOUSOPT, "AMBIGUOUSOPT" },
+  { COOPT_RESULT_MULTIMIXED, "MULTIMIXED" },
+  { COOPT_RESULT_HADPARAM, "HADPARAM" },
+  { COOPT_RESULT_CONFLICT, "CONFLICT" },
+  { COOPT_RESULT_REQUIRES, "REQUIRES" },
+  { COOPT_RESULT_NONEOF, "NONEOF" },
+  { COOPT_RESULT_TOOLONG, "TOOLONG" },
+  { COOPT_RESULT_UNBALANCED, "UNBALANCED" },
+  { COOPT_RESULT_OKAY, "OKAY" },
+  { COOPT_RESULT_MISSINGPARAM, "MISSINGPARAM" },
+  { COOPT_RESULT_END, "END" },
+  { COOPT_RESULT_MORE, "MORE" }
+};
+#define NUM_RESULTS (sizeof(results)/sizeof(results[0]))
+
+static char *spec_strdup(char const *);
+
+int spec_read(FILE *in, char const *name, char const *program,
+	      struct coopt_option **opts, unsigned int *num_opts)
+{
+  char line[MAX_LINE];
+  unsigned int size=16, n=0, lineno=0;
+  struct coopt_option *o;
+
+  o = (struct coopt_option *)malloc(size * sizeof(struct coopt_option));
+  while (o!=NULL && fgets(line, MAX_LINE, in)!=NULL)
+  {
+    char *field[MAX_FIELDS+1];
+    int fields=0, i, bad=0;
+    unsigned int has_param=COOPT_NO_PARAM, attributes=0;
+    char *t;
+
+    lineno++;
+    for (t=strtok(line, " \t\r\n"); t!=NULL && fields<=MAX_FIELDS;
+	 t=strtok(NULL, " \t\r\n"))
+      field[fields++] = t;
+    if (fields==0 || field[0][0]=='#')
+      continue;
+    for (i=2; i<fields && !bad; i++)
+    {
+      unsigned int a;
+      if (strcmp(field[i], "param")==0)
+      {
+	has_param = COOPT_REQUIRED_PARAM;
+	continue;
+      }
+      for (a=0; a<SPEC_NUM_ATTRIBUTES &&
+		strcmp(field[i], spec_attributes[a])!=0; a++)
+	;
+      if (a==SPEC_NUM_ATTRIBUTES)
+	bad = 1;
+      else
+	attributes |= 1U<<a;
+    }
+    if (fields<2 || fields>MAX_FIELDS || strlen(field[0])!=1 || bad)
+    {
+      fprintf(stderr,
+	      "%s: %s:%u: expected <short> <long> [param] [attributes]\n",
+	      program, name, lineno);
+      return 1;
+    }
+
+    if (n==size)
+    {
+      size*=2;
+      o = (struct coopt_option *)realloc(o, size*sizeof(struct coopt_option));
+      if (o==NULL)
+	break;
+    }
+    o[n].short_option = (field[0][0]=='-')?(0):(field[0][0]);
+    o[n].long_option = NULL;
+    if (strcmp(field[1], "-")!=0 &&
+	(o[n].long_option = spec_strdup(field[1]))==NULL)
+    {
+      o=NULL;
+      break;
+    }
+    o[n].has_param = has_param;
+    o[n].data = NULL;
+    o[n].attributes = attributes;
+    n++;
+  }
+  if (o==NULL)
+  {
+    fprintf(stderr, "%s: out of memory\n", program);
+    return 1;
+  }
+  *opts = o;
+  *num_opts = n;
+  return 0;
+}
+
+/* Look for a seed with no collisions; failing that, the fewest */
+int spec_index(struct coopt_index *index, struct coopt_option const *opts,
+	       unsigned int num_opts, int *space)
+{
+  unsigned long seed, best_seed=0;
+  int displaced, best=-1;
+
+  for (seed=0; seed<MAX_SEEDS && best!=0; seed++)
+  {
+    displaced = coopt_index_init(index, opts, num_opts, seed, space);
+    if (best<0 || displaced<best)
+    {
+      best = displaced;
+      best_seed = seed;
+    }
+  }
+  coopt_index_init(index, opts, num_opts, best_seed, space);
+  return best;
+}
+
+char const *result_name(int result)
+{
+  unsigned int i;
+  for (i=0; i<NUM_RESULTS; i++)
+    if (results[i].result==result)
+      return results[i].name;
+  return "unknown";
+}
+
+static char *spec_strdup(char const *s)
+{
+  char *d = (char *)malloc(strlen(s)+1);
+  if (d!=NULL)
+    strcpy(d, s);
+  return d;
+}
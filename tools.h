@@ -0,0 +1,67 @@
+/*
+ * $Id$
+ * tools.h
+ *
+ * Things shared by the programs built alongside libcoopt; not installed.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+#ifndef COOPT_TOOLS_H
+#define COOPT_TOOLS_H
+
+#include <stdio.h>
+#include "coopt.h"
+
+/* Attributes, by bit, as they're given in the spec */
+extern char const * const spec_attributes[];
+#define SPEC_NUM_ATTRIBUTES (3)
+
+/*
+ * Read options from the spec into a malloc()ed array, reporting any
+ * problem on stderr as coming from 'program'; returns non-zero if there
+ * was one. 'name' is what to call the spec in messages.
+ */
+int spec_read(FILE * /*in*/, char const * /*name*/, char const * /*program*/,
+	      struct coopt_option ** /*opts*/, unsigned int * /*num_opts*/);
+
+/*
+ * Build an index of the options in 'space' (which has room for
+ * COOPT_INDEX_SIZE(num_opts) ints) with the seed that leaves the fewest
+ * long options out of their own hash slots; returns how many that is.
+ */
+int spec_index(struct coopt_index * /*index*/,
+	       struct coopt_option const * /*opts*/, unsigned int /*num_opts*/,
+	       int * /*space*/);
+
+/* The name of a result code, such as "BADOPTION", or "unknown" */
+char const *result_name(int /*result*/);
+
+#endif
@@ -0,0 +1,226 @@
+/*
+ * $Id$
+ * trace.c
+ *
+ * Implementation of coopt's tracing: a ring buffer of events written as
+ * coopt() works, and its saved form.
+ * (c) Copyright James Aylett 1999-2000. All Rights Reserved.
+ *
+ *   Redistribution and use in source and binary forms, with or without
+ *   modification, are permitted provided that the following conditions
+ *   are met:
+ *
+ *   1.  Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *
+ *   2.  Redistributions in binary form must reproduce the above
+ *       copyright notice, this list of conditions and the following
+ *       disclaimer in the documentation and/or other materials provided
+ *       with the distribution.
+ *
+ *   3.  Neither name of coopt nor the names of its contributors may be
+ *       used to endorse or promote products derived from this software
+ *       without specific prior written permission.
+ *
+ *   THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ *   ``AS IS'' AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ *   LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ *   A PARTICULAR PURPOSE ARE DISCLAIMED.  IN NO EVENT SHALL THE
+ *   CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ *   EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ *   PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ *   PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ *   LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ *   NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ *   SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/*
+ * Only the thread parsing writes events, so the one thing shared with
+ * coopt_trace_write() is 'head', which it stores after finishing each
+ * event; with GCC, we use its atomic builtins so that's ordered properly.
+ *
+ * Saved traces are some unsigned longs, as below, and then the events.
+ */
+
+#include "coopt.h"
+#include "coopt_string.h"
+
+#if defined(__GNUC__) && defined(__ATOMIC_SEQ_CST)
+#define trace_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+#define trace_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+#else
+#define trace_load(p) (*(p))
+#define trace_store(p, v) (*(p) = (v))
+#endif
+
+#define TRACE_MAGIC		0	/* COOPT_TRACE_MAGIC */
+#define TRACE_VERSION		1	/* COOPT_TRACE_VERSION */
+#define TRACE_BYTE_ORDER	2	/* TRACE_ORDER_MARK */
+#define TRACE_EVENT_SIZE	3	/* sizeof(struct coopt_trace_event) */
+#define TRACE_NUM_EVENTS	4
+#define TRACE_DROPPED		5	/* events lost before the first */
+#define TRACE_HEADER		6
+
+#define TRACE_ORDER_MARK	0x01020304UL
+
+static void coopt_trace_clock(struct coopt_trace_event *, unsigned long);
+
+void coopt_trace_init(struct coopt_trace *trace,
+		      struct coopt_trace_event *events,
+		      unsigned long max_events)
+{
+  unsigned long size = 1;
+
+  while (size*2 <= max_events && size*2 > size)
+    size *= 2;
+  trace->events = (max_events==0)?(NULL):(events);
+  trace->mask = size-1;
+  trace->head = 0;
+  trace->argv = NULL;
+}
+
+void coopt_trace(struct coopt_state *state, struct coopt_trace *trace)
+{
+  state->trace = trace;
+  if (trace!=NULL)
+    trace->argv = state->argv;
+}
+
+void coopt_trace_note(struct coopt_state *state, int kind, int option,
+		      int detail)
+{
+  struct coopt_trace *trace = state->trace;
+  unsigned long n = trace->head;
+  struct coopt_trace_event *e;
+
+  if (trace->events==NULL)
+    return;
+  e = trace->events + (n & trace->mask);
+  coopt_trace_clock(e, n);
+  e->kind = kind;
+  e->element = state->argv - trace->argv;
+  e->offset = state->char_within_arg;
+  e->option = option;
+  e->detail = detail;
+  trace_store(&trace->head, n+1);
+}
+
+/*
+ * As coopt_fingerprint() finds it, the option's index in its own table.
+ * coopt() passes the parts of its return it needs, not its address, so
+ * that the return can stay in registers when we aren't tracing.
+ */
+void coopt_trace_result(struct coopt_state *state,
+			struct coopt_option const *opt, char const *marker,
+			int result)
+{
+  int option = -1;
+
+  if (opt!=NULL)
+  {
+    struct coopt_option const *base = state->options;
+    if (state->namespaces!=NULL && marker!=NULL)
+    {
+      int ns;
+      for (ns=0; state->markers[ns]!=NULL; ns++)
+      {
+	if (state->markers[ns]==marker)
+	{
+	  if (state->namespaces[ns].options!=NULL)
+	    base = state->namespaces[ns].options;
+	  break;
+	}
+      }
+    }
+    option = opt - base;
+  }
+  coopt_trace_note(state, COOPT_TRACE_RESULT, option, result);
+}
+
+size_t coopt_trace_write(struct coopt_trace *trace, void *buffer,
+			 size_t size)
+{
+  unsigned long head = trace_load(&trace->head), first, after, n, i;
+  unsigned long *out = (unsigned long *)buffer;
+  struct coopt_trace_event *events;
+  size_t needed;
+
+  /*
+   * The slot after the newest event may be being written now, so we
+   * only take the ones before that
+   */
+  n = (trace->events==NULL)?(0):
+      (head > trace->mask)?(trace->mask):(head);
+  first = head - n;
+  needed = COOPT_TRACE_SIZE(n);
+  if (buffer==NULL || size<needed)
+    return needed;
+
+  events = (struct coopt_trace_event *)(out + TRACE_HEADER);
+  for (i=0; i<n; i++)
+    events[i] = trace->events[(first+i) & trace->mask];
+
+  /* and any the writer has got round to since may be half overwritten */
+  after = trace_load(&trace->head);
+  if (after - first > trace->mask)
+  {
+    unsigned long lost = after - first - trace->mask;
+    if (lost > n)
+      lost = n;
+    coopt_memmove(events, events+lost, (n-lost)*sizeof(*events));
+    first += lost;
+    n -= lost;
+  }
+
+  out[TRACE_MAGIC] = COOPT_TRACE_MAGIC;
+  out[TRACE_VERSION] = COOPT_TRACE_VERSION;
+  out[TRACE_BYTE_ORDER] = TRACE_ORDER_MARK;
+  out[TRACE_EVENT_SIZE] = sizeof(struct coopt_trace_event);
+  out[TRACE_NUM_EVENTS] = n;
+  out[TRACE_DROPPED] = first;
+  return COOPT_TRACE_SIZE(n);
+}
+
+int coopt_trace_events(void const *buffer, size_t size,
+		       struct coopt_trace_event const **events)
+{
+  unsigned long const *in = (unsigned long const *)buffer;
+
+  *events = NULL;
+  if (buffer==NULL || size<COOPT_TRACE_SIZE(0) ||
+      in[TRACE_MAGIC]!=COOPT_TRACE_MAGIC ||
+      in[TRACE_VERSION]!=COOPT_TRACE_VERSION ||
+      in[TRACE_BYTE_ORDER]!=TRACE_ORDER_MARK ||
+      in[TRACE_EVENT_SIZE]!=sizeof(struct coopt_trace_event) ||
+      in[TRACE_NUM_EVENTS] > (size-COOPT_TRACE_SIZE(0))/
+			     sizeof(struct coopt_trace_event) ||
+      in[TRACE_NUM_EVENTS] > 0x7fffffffUL)
+    return -1;
+  *events = (struct coopt_trace_event const *)(in + TRACE_HEADER);
+  return (int)in[TRACE_NUM_EVENTS];
+}
+
+/*
+ * Read the cycle counter, where we know how; otherwise use the event's
+ * number, so at least the order is right.
+ */
+static void coopt_trace_clock(struct coopt_trace_event *e, unsigned long n)
+{
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+  unsigned int lo, hi;
+  __asm__ __volatile__ ("rdtsc" : "=a" (lo), "=d" (hi));
+  e->time_hi = hi;
+  e->time_lo = lo;
+  (void)n;
+#elif defined(__GNUC__) && defined(__aarch64__)
+  unsigned long t;
+  __asm__ __volatile__ ("mrs %0, cntvct_el0" : "=r" (t));
+  e->time_hi = t >> 32;
+  e->time_lo = t & 0xffffffffUL;
+  (void)n;
+#else
+  e->time_hi = 0;
+  e->time_lo = n & 0xffffffffUL;
+#endif
+}